@@ -32,6 +32,7 @@ public class NiagaraDestructionDriver : ModuleRules
 				"Chaos",
 				"PhysicsCore",
 				"DeveloperSettings",
+				"MassEntity",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -42,6 +43,11 @@ public class NiagaraDestructionDriver : ModuleRules
 			{
 				"CoreUObject",
 				"Engine",
+				"MeshDescription",
+				"RenderCore",
+				"RHI",
+				"SignificanceManager",
+				"StaticMeshDescription",
 				"Slate",
 				"SlateCore",
 				// ... add private dependencies that you statically link with here ...	
@@ -1,6 +1,22 @@
 
 #include "CVars.h"
 #include "HAL/IConsoleManager.h"
+#include "Containers/Ticker.h"
+#include "EngineUtils.h"
+#include "NiagaraDestructionDriver.h"
+#include "NiagaraDestructionDriverActor.h"
+#include "NiagaraDestructionDriverAssetLoader.h"
+#include "NiagaraDestructionDriverAtlasSubsystem.h"
+#include "NiagaraDestructionDriverEntitySubsystem.h"
+#include "NiagaraDestructionDriverInstancingSubsystem.h"
+#include "NiagaraDestructionDriverMaterialCache.h"
+#include "NiagaraDestructionDriverNiagaraComponentPool.h"
+#include "NiagaraDestructionDriverPrewarmSubsystem.h"
+#include "NiagaraDestructionDriverRenderTargetPool.h"
+#include "NiagaraDestructionDriverSharedSimulationSubsystem.h"
+#include "NiagaraDestructionDriverSignificanceSubsystem.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
 
 TAutoConsoleVariable<int32> CVarNDD_DebugCollisions(
 		TEXT("r.NDD.DebugCollisions"),
@@ -16,4 +32,353 @@ TAutoConsoleVariable<int32> CVarNDD_DebugMaterial(
 		TEXT("Enables use of a debug material on destructibles that shows bones in different colors.\n")
 		TEXT("<=0: OFF\n")
 		TEXT(" 1: ON\n"),
-		ECVF_SetByConsole);
\ No newline at end of file
+		ECVF_SetByConsole);
+
+TAutoConsoleVariable<int32> CVarNDD_UseRuntimeContextCache(
+		TEXT("r.NDD.UseRuntimeContextCache"),
+		1,
+		TEXT("Share one resolved runtime context per data asset between all destructibles instead of rebuilding it in every actor.\n")
+		TEXT("<=0: OFF\n")
+		TEXT(" 1: ON\n"),
+		ECVF_SetByConsole);
+
+TAutoConsoleVariable<int32> CVarNDD_ForceHeadless(
+		TEXT("r.NDD.ForceHeadless"),
+		0,
+		TEXT("Treat destructibles that begin play from now on as if running on a dedicated server: no render targets, materials or niagara setup, only the logical destruction state.\n")
+		TEXT("<=0: OFF (headless only on dedicated servers and -nullrhi)\n")
+		TEXT(" 1: ON\n"),
+		ECVF_SetByConsole);
+
+static FAutoConsoleCommandWithWorld CmdNDD_DumpAtlasStats(
+		TEXT("r.NDD.DumpAtlasStats"),
+		TEXT("Logs occupancy and fragmentation of the destructible render target atlas of the current world."),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (const UNiagaraDestructionDriverAtlasSubsystem* Atlas = World ? World->GetSubsystem<UNiagaraDestructionDriverAtlasSubsystem>() : nullptr)
+			{
+				Atlas->DumpAtlasStats();
+			}
+		}));
+
+static FAutoConsoleCommandWithWorld CmdNDD_DumpRenderTargetPoolStats(
+		TEXT("r.NDD.DumpRenderTargetPoolStats"),
+		TEXT("Logs hits, misses and peak residency of the destructible render target pool of the current world."),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (const UNiagaraDestructionDriverRenderTargetPool* Pool = World ? World->GetSubsystem<UNiagaraDestructionDriverRenderTargetPool>() : nullptr)
+			{
+				Pool->DumpPoolStats();
+			}
+		}));
+
+static FAutoConsoleCommandWithWorld CmdNDD_DumpMemoryStats(
+		TEXT("r.NDD.DumpMemoryStats"),
+		TEXT("Logs the estimated render resource memory (render targets, dynamic materials, niagara component) held by the destructibles of the current world."),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (World == nullptr)
+			{
+				return;
+			}
+			int32 NumActors = 0;
+			int32 NumHeadless = 0;
+			int32 NumActivated = 0;
+			SIZE_T TotalBytes = 0;
+			for (TActorIterator<ANiagaraDestructionDriverActor> It(World); It; ++It)
+			{
+				NumActors++;
+				NumHeadless += It->IsHeadless() ? 1 : 0;
+				NumActivated += It->IsActivated() ? 1 : 0;
+				TotalBytes += It->GetRenderResourceSizeBytes();
+			}
+			UE_LOG(LogNiagaraDestructionDriver, Log, TEXT("Niagara destructibles: %d (%d headless, %d activated), render resources: %.2f KB total, %.2f KB per actor."),
+				NumActors, NumHeadless, NumActivated, TotalBytes / 1024.0, NumActors > 0 ? TotalBytes / 1024.0 / NumActors : 0.0);
+			if (const UNiagaraDestructionDriverMaterialCache* MaterialCache = World->GetSubsystem<UNiagaraDestructionDriverMaterialCache>())
+			{
+				UE_LOG(LogNiagaraDestructionDriver, Log, TEXT("Shared destructible materials: %d."), MaterialCache->GetNumMaterials());
+			}
+		}));
+
+static FAutoConsoleCommandWithWorld CmdNDD_DumpPrewarmStats(
+		TEXT("r.NDD.DumpPrewarmStats"),
+		TEXT("Logs how many destructible data assets, material PSOs and niagara systems were prewarmed in the current world and how many activations found them warm."),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (const UNiagaraDestructionDriverPrewarmSubsystem* Prewarm = World ? World->GetSubsystem<UNiagaraDestructionDriverPrewarmSubsystem>() : nullptr)
+			{
+				Prewarm->DumpPrewarmStats();
+			}
+		}));
+
+static FAutoConsoleCommandWithWorld CmdNDD_DumpSnapshotStats(
+		TEXT("r.NDD.DumpSnapshotStats"),
+		TEXT("Saves a snapshot of every destroyed destructible in the current world and logs its size and last restore time, plus the totals."),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (World == nullptr)
+			{
+				return;
+			}
+			int32 NumSnapshots = 0;
+			int32 NumSimulating = 0;
+			int64 TotalBytes = 0;
+			TArray<uint8> Snapshot;
+			for (TActorIterator<ANiagaraDestructionDriverActor> It(World); It; ++It)
+			{
+				if (!It->SaveSnapshot(Snapshot))
+				{
+					continue;
+				}
+				NumSnapshots++;
+				NumSimulating += It->IsSettled() ? 0 : 1;
+				TotalBytes += Snapshot.Num();
+				UE_LOG(LogNiagaraDestructionDriver, Log, TEXT("  %s: %d bytes%s, last restore %.3f ms"), *It->GetName(), Snapshot.Num(),
+					It->IsSettled() ? TEXT("") : TEXT(" (still simulating, forces only)"), It->GetLastRestoreTimeMs());
+			}
+			UE_LOG(LogNiagaraDestructionDriver, Log, TEXT("Destruction snapshots: %d destroyed destructibles (%d still simulating), %.2f KB total, %.1f bytes per destructible."),
+				NumSnapshots, NumSimulating, TotalBytes / 1024.0, NumSnapshots > 0 ? static_cast<double>(TotalBytes) / NumSnapshots : 0.0);
+		}));
+
+static FAutoConsoleCommandWithWorld CmdNDD_DumpStreamingStats(
+		TEXT("r.NDD.DumpStreamingStats"),
+		TEXT("Logs which destructible data assets of the current world keep their streamed mesh and bone texture resident, and the memory resident vs. released."),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			const UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+			if (const UNiagaraDestructionDriverAssetLoader* AssetLoader = GameInstance ? GameInstance->GetSubsystem<UNiagaraDestructionDriverAssetLoader>() : nullptr)
+			{
+				AssetLoader->DumpStreamingStats(World);
+			}
+		}));
+
+static FAutoConsoleCommandWithWorld CmdNDD_DumpInstancingStats(
+		TEXT("r.NDD.DumpInstancingStats"),
+		TEXT("Logs the instance groups of the current world: slots used, instances drawn and simulating, forces and page size per instanced data asset."),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (const UNiagaraDestructionDriverInstancingSubsystem* Instancing = World ? World->GetSubsystem<UNiagaraDestructionDriverInstancingSubsystem>() : nullptr)
+			{
+				Instancing->DumpInstancingStats();
+			}
+		}));
+
+static FAutoConsoleCommandWithWorld CmdNDD_DumpSharedSimulationStats(
+		TEXT("r.NDD.DumpSharedSimulationStats"),
+		TEXT("Logs the shared simulations of the current world: ranges, simulating ranges, forces and bones used per atlas page."),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (const UNiagaraDestructionDriverSharedSimulationSubsystem* SharedSimulation = World ? World->GetSubsystem<UNiagaraDestructionDriverSharedSimulationSubsystem>() : nullptr)
+			{
+				SharedSimulation->DumpSharedSimulationStats();
+			}
+		}));
+
+static FAutoConsoleCommandWithWorld CmdNDD_DumpNiagaraComponentPoolStats(
+		TEXT("r.NDD.DumpNiagaraComponentPoolStats"),
+		TEXT("Logs hits, misses, evictions and peak residency of the niagara component pool of the current world."),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (const UNiagaraDestructionDriverNiagaraComponentPool* Pool = World ? World->GetSubsystem<UNiagaraDestructionDriverNiagaraComponentPool>() : nullptr)
+			{
+				Pool->DumpPoolStats();
+			}
+		}));
+
+static FAutoConsoleCommandWithWorld CmdNDD_DumpSignificanceStats(
+		TEXT("r.NDD.DumpSignificanceStats"),
+		TEXT("Logs how many destroyed destructibles of the current world simulate at full rate, reduced rate or frozen, and the tier thresholds of this platform."),
+		FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+		{
+			if (const UNiagaraDestructionDriverSignificanceSubsystem* Significance = World ? World->GetSubsystem<UNiagaraDestructionDriverSignificanceSubsystem>() : nullptr)
+			{
+				Significance->DumpSignificanceStats();
+			}
+		}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdNDD_BenchmarkActivation(
+		TEXT("r.NDD.BenchmarkActivation"),
+		TEXT("Spawns [Count] (default 5000) copies of the first destructible in the world with and without r.NDD.UseRuntimeContextCache and logs the average spawn + activation cost."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			if (World == nullptr)
+			{
+				return;
+			}
+			const int32 NumActors = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 5000;
+
+			// use an already activated destructible as the template so its destruction assets are in memory
+			ANiagaraDestructionDriverActor* Template = nullptr;
+			for (TActorIterator<ANiagaraDestructionDriverActor> It(World); It; ++It)
+			{
+				if (It->IsActivated())
+				{
+					Template = *It;
+					break;
+				}
+			}
+			if (Template == nullptr)
+			{
+				UE_LOG(LogNiagaraDestructionDriver, Warning, TEXT("r.NDD.BenchmarkActivation needs an activated niagara destructible in the world to copy."));
+				return;
+			}
+
+			IConsoleVariable* CacheCVar = CVarNDD_UseRuntimeContextCache.AsVariable();
+			const int32 PreviousCacheValue = CVarNDD_UseRuntimeContextCache.GetValueOnGameThread();
+			for (const int32 UseCache : { 0, 1 })
+			{
+				CacheCVar->Set(UseCache, ECVF_SetByConsole);
+				Template->NiagaraDestructionDriverParams->InvalidateRuntimeContext();
+
+				TArray<ANiagaraDestructionDriverActor*> SpawnedActors;
+				SpawnedActors.Reserve(NumActors);
+				const FTransform SpawnTransform = Template->GetActorTransform();
+				const double StartTime = FPlatformTime::Seconds();
+				for (int32 Idx = 0; Idx < NumActors; Idx++)
+				{
+					ANiagaraDestructionDriverActor* Actor = World->SpawnActorDeferred<ANiagaraDestructionDriverActor>(Template->GetClass(), SpawnTransform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+					Actor->NiagaraDestructionDriverParams = Template->NiagaraDestructionDriverParams;
+					Actor->bLazyActivation = false;
+					Actor->FinishSpawning(SpawnTransform);
+					SpawnedActors.Add(Actor);
+				}
+				const double ElapsedMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+				UE_LOG(LogNiagaraDestructionDriver, Log, TEXT("Spawned and activated %d destructibles with runtime context cache %s: %.2f ms total, %.4f ms per actor."),
+					NumActors, UseCache ? TEXT("ON") : TEXT("OFF"), ElapsedMs, ElapsedMs / NumActors);
+
+				for (ANiagaraDestructionDriverActor* Actor : SpawnedActors)
+				{
+					Actor->Destroy();
+				}
+			}
+			CacheCVar->Set(PreviousCacheValue, ECVF_SetByConsole);
+		}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdNDD_BenchmarkEntities(
+		TEXT("r.NDD.BenchmarkEntities"),
+		TEXT("Places [Count] (default 10000) intact copies of the first entity capable destructible in the world, first as actors and then as entities (UNiagaraDestructionDriverEntitySubsystem), and logs placement time, memory and the average frame time over [Frames] (default 120) frames of each."),
+		FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+		{
+			UNiagaraDestructionDriverEntitySubsystem* EntitySubsystem = World ? World->GetSubsystem<UNiagaraDestructionDriverEntitySubsystem>() : nullptr;
+			if (EntitySubsystem == nullptr)
+			{
+				return;
+			}
+
+			// the class needs SourceGeometryContainer meshes to be drawn as an entity
+			ANiagaraDestructionDriverActor* Template = nullptr;
+			for (TActorIterator<ANiagaraDestructionDriverActor> It(World); It && Template == nullptr; ++It)
+			{
+				TArray<const UStaticMeshComponent*> Templates;
+				TArray<FTransform> RelativeTransforms;
+				UNiagaraDestructionDriverEntitySubsystem::GetProxyTemplates(It->GetClass(), Templates, RelativeTransforms);
+				Template = Templates.Num() > 0 ? *It : nullptr;
+			}
+			if (Template == nullptr)
+			{
+				UE_LOG(LogNiagaraDestructionDriver, Warning, TEXT("r.NDD.BenchmarkEntities needs a niagara destructible blueprint made by the chaos-to-niagara tool in the world to copy."));
+				return;
+			}
+
+			struct FBenchmark
+			{
+				TWeakObjectPtr<UWorld> World;
+				TWeakObjectPtr<UNiagaraDestructionDriverEntitySubsystem> EntitySubsystem;
+				TSubclassOf<ANiagaraDestructionDriverActor> DestructibleClass;
+				TWeakObjectPtr<UNiagaraDestructionDriverDataAsset> DataAsset;
+				TArray<FTransform> Transforms;
+				int32 NumFrames = 120;
+				bool bEntities = false;
+				int32 Frame = 0;
+				double FrameTimeSum = 0.0;
+				TArray<TWeakObjectPtr<ANiagaraDestructionDriverActor>> Actors;
+				TArray<FMassEntityHandle> Entities;
+				double PlaceMs = 0.0;
+				int64 PlaceMemoryBytes = 0;
+			};
+			TSharedRef<FBenchmark> Benchmark = MakeShared<FBenchmark>();
+			Benchmark->World = World;
+			Benchmark->EntitySubsystem = EntitySubsystem;
+			Benchmark->DestructibleClass = Template->GetClass();
+			Benchmark->DataAsset = Template->NiagaraDestructionDriverParams;
+			Benchmark->NumFrames = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 120;
+
+			// a grid next to the template, one bounds size apart
+			const int32 NumCopies = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10000;
+			const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumCopies)));
+			const FBox Bounds = Template->GetComponentsBoundingBox();
+			const double Spacing = FMath::Max(Bounds.GetSize().GetMax(), 100.0);
+			for (int32 Idx = 0; Idx < NumCopies; Idx++)
+			{
+				const FVector Offset((Idx % GridSize + 1) * Spacing, (Idx / GridSize) * Spacing, 0.0);
+				Benchmark->Transforms.Add(FTransform(Template->GetActorQuat(), Template->GetActorLocation() + Offset, Template->GetActorScale3D()));
+			}
+
+			FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Benchmark](float DeltaTime)
+			{
+				UWorld* BenchmarkWorld = Benchmark->World.Get();
+				UNiagaraDestructionDriverEntitySubsystem* BenchmarkEntitySubsystem = Benchmark->EntitySubsystem.Get();
+				if (BenchmarkWorld == nullptr || BenchmarkEntitySubsystem == nullptr)
+				{
+					return false;
+				}
+
+				if (Benchmark->Frame == 0)
+				{
+					const int64 MemoryBefore = FPlatformMemory::GetStats().UsedPhysical;
+					const double StartTime = FPlatformTime::Seconds();
+					for (const FTransform& Transform : Benchmark->Transforms)
+					{
+						if (Benchmark->bEntities)
+						{
+							Benchmark->Entities.Add(BenchmarkEntitySubsystem->AddEntity(Benchmark->DestructibleClass, Benchmark->DataAsset.Get(), Transform));
+						}
+						else
+						{
+							ANiagaraDestructionDriverActor* Actor = BenchmarkWorld->SpawnActorDeferred<ANiagaraDestructionDriverActor>(Benchmark->DestructibleClass, Transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+							Actor->NiagaraDestructionDriverParams = Benchmark->DataAsset.Get();
+							Actor->bLazyActivation = true;
+							Actor->FinishSpawning(Transform);
+							Benchmark->Actors.Add(Actor);
+						}
+					}
+					Benchmark->PlaceMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+					Benchmark->PlaceMemoryBytes = static_cast<int64>(FPlatformMemory::GetStats().UsedPhysical) - MemoryBefore;
+				}
+				else if (Benchmark->Frame > 2)
+				{
+					// the first frames pay for registering the new primitives
+					Benchmark->FrameTimeSum += DeltaTime;
+				}
+				if (Benchmark->Frame++ < Benchmark->NumFrames + 2)
+				{
+					return true;
+				}
+
+				UE_LOG(LogNiagaraDestructionDriver, Log, TEXT("%d intact destructibles as %s: placed in %.2f ms, %.2f MB, %.3f ms average frame time over %d frames."),
+					Benchmark->Transforms.Num(), Benchmark->bEntities ? TEXT("entities") : TEXT("actors"), Benchmark->PlaceMs,
+					Benchmark->PlaceMemoryBytes / (1024.0 * 1024.0), Benchmark->FrameTimeSum * 1000.0 / Benchmark->NumFrames, Benchmark->NumFrames);
+
+				for (const TWeakObjectPtr<ANiagaraDestructionDriverActor>& Actor : Benchmark->Actors)
+				{
+					if (Actor.IsValid())
+					{
+						Actor->Destroy();
+					}
+				}
+				for (const FMassEntityHandle Entity : Benchmark->Entities)
+				{
+					BenchmarkEntitySubsystem->RemoveEntity(Entity);
+				}
+				Benchmark->Actors.Empty();
+				Benchmark->Entities.Empty();
+
+				// actors first, then the same copies as entities
+				const bool bDone = Benchmark->bEntities;
+				Benchmark->bEntities = true;
+				Benchmark->Frame = 0;
+				Benchmark->FrameTimeSum = 0.0;
+				return !bDone;
+			}));
+		}));
@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverActivationScheduler.h"
+
+#include "NiagaraDestructionDriver.h"
+#include "NiagaraDestructionDriverActor.h"
+#include "NiagaraDestructionDriverHelper.h"
+#include "NiagaraDestructionDriverSettings.h"
+#include "Camera/PlayerCameraManager.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("NDD Scheduled Hot Swaps"), STAT_NDD_ScheduledHotSwaps, STATGROUP_NiagaraDestructionDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("NDD Pending Hot Swaps"), STAT_NDD_PendingHotSwaps, STATGROUP_NiagaraDestructionDriver);
+
+void UNiagaraDestructionDriverActivationScheduler::ScheduleHotSwap(ANiagaraDestructionDriverActor* Destructible, const FVector& ForceOrigin)
+{
+	if (Destructible == nullptr)
+	{
+		return;
+	}
+
+	FPendingHotSwap& PendingHotSwap = PendingHotSwaps.AddDefaulted_GetRef();
+	PendingHotSwap.Destructible = Destructible;
+	PendingHotSwap.ForceOrigin = ForceOrigin;
+}
+
+void UNiagaraDestructionDriverActivationScheduler::CancelHotSwap(ANiagaraDestructionDriverActor* Destructible)
+{
+	// may be called while Tick runs the queue, cleared entries are dropped there
+	for (FPendingHotSwap& PendingHotSwap : PendingHotSwaps)
+	{
+		if (PendingHotSwap.Destructible.Get() == Destructible)
+		{
+			PendingHotSwap.Destructible.Reset();
+		}
+	}
+}
+
+void UNiagaraDestructionDriverActivationScheduler::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NDD_ScheduledHotSwaps);
+
+	const UNiagaraDestructionDriverSettings* Settings = GetDefault<UNiagaraDestructionDriverSettings>();
+	const int32 MaxHotSwaps = Settings->MaxHotSwapsPerFrame > 0 ? Settings->MaxHotSwapsPerFrame : MAX_int32;
+	const double TimeBudgetSeconds = Settings->HotSwapTimeBudgetMs / 1000.0;
+
+	// only worth sorting if some of them have to wait
+	if (PendingHotSwaps.Num() > 1 && (PendingHotSwaps.Num() > MaxHotSwaps || TimeBudgetSeconds > 0.0))
+	{
+		TArray<FVector, TInlineAllocator<4>> CameraLocations;
+		for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+		{
+			const APlayerController* PlayerController = It->Get();
+			if (PlayerController && PlayerController->PlayerCameraManager)
+			{
+				CameraLocations.Add(PlayerController->PlayerCameraManager->GetCameraLocation());
+			}
+		}
+
+		// visible destruction near the player and the debris closest to the blast first
+		for (FPendingHotSwap& PendingHotSwap : PendingHotSwaps)
+		{
+			const ANiagaraDestructionDriverActor* Destructible = PendingHotSwap.Destructible.Get();
+			if (Destructible == nullptr)
+			{
+				continue;
+			}
+			const FVector Location = Destructible->GetActorLocation();
+			double CameraDistance = CameraLocations.Num() > 0 ? TNumericLimits<double>::Max() : 0.0;
+			for (const FVector& CameraLocation : CameraLocations)
+			{
+				CameraDistance = FMath::Min(CameraDistance, FVector::Dist(CameraLocation, Location));
+			}
+			PendingHotSwap.Priority = CameraDistance + FVector::Dist(PendingHotSwap.ForceOrigin, Location);
+		}
+		PendingHotSwaps.StableSort([](const FPendingHotSwap& A, const FPendingHotSwap& B)
+		{
+			return A.Priority < B.Priority;
+		});
+	}
+
+	// always make progress, even if a single hot swap blows the time budget
+	const double StartTime = FPlatformTime::Seconds();
+	int32 NumProcessed = 0;
+	int32 NumHotSwaps = 0;
+	while (NumProcessed < PendingHotSwaps.Num())
+	{
+		ANiagaraDestructionDriverActor* Destructible = PendingHotSwaps[NumProcessed].Destructible.Get();
+		if (Destructible == nullptr)
+		{
+			NumProcessed++;
+			continue;
+		}
+		if (NumHotSwaps >= MaxHotSwaps || (NumHotSwaps > 0 && TimeBudgetSeconds > 0.0 && FPlatformTime::Seconds() - StartTime >= TimeBudgetSeconds))
+		{
+			break;
+		}
+		Destructible->RunScheduledHotSwap();
+		NumHotSwaps++;
+		NumProcessed++;
+	}
+	PendingHotSwaps.RemoveAt(0, NumProcessed, EAllowShrinking::No);
+
+	SET_DWORD_STAT(STAT_NDD_PendingHotSwaps, PendingHotSwaps.Num());
+}
+
+TStatId UNiagaraDestructionDriverActivationScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNiagaraDestructionDriverActivationScheduler, STATGROUP_NiagaraDestructionDriver);
+}
+
+void UNiagaraDestructionDriverActivationScheduler::Deinitialize()
+{
+	PendingHotSwaps.Empty();
+	Super::Deinitialize();
+}
+
+bool UNiagaraDestructionDriverActivationScheduler::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// headless destructibles never hot swap
+	return Super::ShouldCreateSubsystem(Outer) && UNiagaraDestructionDriverHelper::ShouldCreateRenderResources(Outer);
+}
+
+bool UNiagaraDestructionDriverActivationScheduler::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
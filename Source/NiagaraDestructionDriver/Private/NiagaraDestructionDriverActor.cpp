@@ -1,34 +1,68 @@
-﻿#include "NiagaraDestructionDriverActor.h"
+#include "NiagaraDestructionDriverActor.h"
 
 #include "CVars.h"
 #include "NiagaraDestructionDriver.h"
 #include "NiagaraComponent.h"
+#include "NiagaraDestructionDriverActivationScheduler.h"
+#include "NiagaraDestructionDriverAssetLoader.h"
+#include "NiagaraDestructionDriverHelper.h"
+#include "NiagaraDestructionDriverInstancingSubsystem.h"
+#include "NiagaraDestructionDriverMaterialCache.h"
+#include "NiagaraDestructionDriverMeshBaker.h"
+#include "NiagaraDestructionDriverNiagaraComponentPool.h"
+#include "NiagaraDestructionDriverPrewarmSubsystem.h"
+#include "NiagaraDestructionDriverProxySubsystem.h"
+#include "NiagaraDestructionDriverReadback.h"
+#include "NiagaraDestructionDriverRenderTargetPool.h"
+#include "NiagaraDestructionDriverRuntimeContext.h"
 #include "NiagaraDestructionDriverSettings.h"
+#include "NiagaraDestructionDriverSharedSimulationSubsystem.h"
+#include "NiagaraDestructionDriverSignificanceSubsystem.h"
+#include "NiagaraDestructionDriverSnapshot.h"
+#include "NiagaraDestructionDriverStreamingSubsystem.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/GameInstance.h"
+#include "Engine/Texture2D.h"
 #include "Engine/TextureRenderTarget2D.h"
+#include "GameFramework/PlayerController.h"
+#include "Misc/ScopeExit.h"
+#include "TimerManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("NDD BeginPlay"), STAT_NDD_BeginPlay, STATGROUP_NiagaraDestructionDriver);
+DECLARE_CYCLE_STAT(TEXT("NDD FinishActivation"), STAT_NDD_FinishActivation, STATGROUP_NiagaraDestructionDriver);
+DECLARE_CYCLE_STAT(TEXT("NDD RestoreState"), STAT_NDD_RestoreState, STATGROUP_NiagaraDestructionDriver);
 
 void SetDebugMaterial(ANiagaraDestructionDriverActor* ForActor)
 {
 	if (const UNiagaraDestructionDriverSettings* Settings = GetDefault<UNiagaraDestructionDriverSettings>())
 	{
-		const auto MeshMaterial = Settings->DebugMaterialForNiagaraDestructibles;
-		const auto BaseMaterial = MeshMaterial.LoadSynchronous();
+		// loaded up front by ANiagaraDestructionDriverActor::ActivateDestructible
+		const auto BaseMaterial = Settings->DebugMaterialForNiagaraDestructibles.Get();
+		if (BaseMaterial == nullptr)
+		{
+			return;
+		}
+		const FNiagaraDestructionDriverParameterNames& ParameterNames = FNiagaraDestructionDriverParameterNames::Get();
 		UMaterialInstanceDynamic* DynamicMaterial = UMaterialInstanceDynamic::Create(BaseMaterial, ForActor);
-		DynamicMaterial->SetScalarParameterValue(FName("RT_Size"), ForActor->NiagaraDestructionDriverParams->RenderTargetTextureSize);
-		DynamicMaterial->SetTextureParameterValue(FName("RT_Position"), ForActor->PositionsTexture);
-		DynamicMaterial->SetTextureParameterValue(FName("RT_Rotation"), ForActor->RotationsTexture);
-		DynamicMaterial->SetTextureParameterValue(FName("InitialBoneLocations"), ForActor->NiagaraDestructionDriverParams->InitialBoneLocationsTexture);
-		uint32 Idx = 0;
-		for (const auto MaterialSlot : ForActor->MeshComponent->GetMaterialSlotNames())
+		DynamicMaterial->SetScalarParameterValue(ParameterNames.RT_Size, ForActor->NiagaraDestructionDriverParams->RenderTargetTextureSize);
+		DynamicMaterial->SetTextureParameterValue(ParameterNames.RT_Position, ForActor->PositionsTexture);
+		DynamicMaterial->SetTextureParameterValue(ParameterNames.RT_Rotation, ForActor->RotationsTexture);
+		DynamicMaterial->SetVectorParameterValue(ParameterNames.RT_TileOffsetScale, ForActor->RenderTargetTileOffsetScale);
+		DynamicMaterial->SetTextureParameterValue(ParameterNames.InitialBoneLocations, ForActor->NiagaraDestructionDriverParams->InitialBoneLocationsTexture.Get());
+		const int32 NumMaterials = ForActor->MeshComponent->GetNumMaterials();
+		for (int32 Idx = 0; Idx < NumMaterials; Idx++)
 		{
 			ForActor->MeshComponent->SetMaterial(Idx, DynamicMaterial);
-			Idx++;
 		}
 	}
 }
 
 ANiagaraDestructionDriverActor::ANiagaraDestructionDriverActor()
 {
-	PrimaryActorTick.bCanEverTick = false;
+	// only ticks while waiting for a player to come within LazyActivationDistance
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 	bIsInRestingState = true;
 	
 	// Create and set up the scene component as the root
@@ -50,7 +84,8 @@ ANiagaraDestructionDriverActor::ANiagaraDestructionDriverActor()
 
 	// Create and attach the Niagara component to the root
 	// this is the particle system that spawns a particle per bone of the destructible
-	// by using the initial bones locations texture AND it will drive the physics simulation
+	// by using the initial bones locations texture AND it will drive the physics simulation.
+	// With pooled niagara components it is dropped in BeginPlay and borrowed on the first hit instead (see BorrowNiagaraComponent)
 	NiagaraComponent = CreateDefaultSubobject<UNiagaraComponent>(TEXT("NiagaraComponent"));
 	NiagaraComponent->SetupAttachment(RootSceneComponent);
 	NiagaraComponent->SetRelativeLocation(FVector(0.0f, 0.0f, 0.0f));
@@ -67,13 +102,75 @@ ANiagaraDestructionDriverActor::ANiagaraDestructionDriverActor()
 
 void ANiagaraDestructionDriverActor::InitiateDestructionForce(FVector ForceOrigin, float ForceRadius, float ForceDuration)
 {
+	// nothing left to push, so the force isn't part of the history either
+	if (bFragmentsDespawned)
+	{
+		return;
+	}
+	if (bIsSettled)
+	{
+		WakeFromSettled();
+	}
+
+	// streaming states and save snapshots carry the history, keep it bounded however often we're hit
+	const FNiagaraDestructionDriverForce Force(ForceOrigin, ForceRadius, ForceDuration, GetWorld()->GetTimeSeconds());
+	DestructionForceHistory.Add(Force);
+	const int32 MaxForceHistory = GetDefault<UNiagaraDestructionDriverSettings>()->MaxDestructionForceHistory;
+	if (MaxForceHistory > 0 && DestructionForceHistory.Num() > MaxForceHistory)
+	{
+		DestructionForceHistory.RemoveAt(0, DestructionForceHistory.Num() - MaxForceHistory, EAllowShrinking::No);
+	}
+	LastForceEndTime = FMath::Max(LastForceEndTime, Force.StartTime + Force.Duration);
+	ScheduleSettleCheck();
+
+	// nothing is rendered on dedicated servers, only remember that we've been hit
+	if (bIsHeadless)
+	{
+		bIsInRestingState = false;
+		return;
+	}
+
+	ApplyDestructionForce(Force);
+}
+
+void ANiagaraDestructionDriverActor::ApplyDestructionForce(const FNiagaraDestructionDriverForce& Force, const bool bAllowDeferral)
+{
+	// the first hit is the expensive one, let the scheduler spread those over frames
+	if (bIsInRestingState && bIsHotSwapScheduled)
+	{
+		QueuedDestructionForces.Add(Force);
+		return;
+	}
+	if (bIsInRestingState && bAllowDeferral && GetDefault<UNiagaraDestructionDriverSettings>()->bUseActivationBudget)
+	{
+		if (UNiagaraDestructionDriverActivationScheduler* Scheduler = GetWorld()->GetSubsystem<UNiagaraDestructionDriverActivationScheduler>())
+		{
+			bIsHotSwapScheduled = true;
+			QueuedDestructionForces.Add(Force);
+			Scheduler->ScheduleHotSwap(this, Force.Origin);
+			return;
+		}
+	}
+
+	// lazily activated destructibles set up their render targets, materials and niagara system on the first hit
+	ActivateDestructible();
+	if (!bIsActivated)
+	{
+		// the niagara system is still streaming in, replay this force once it's ready
+		if (bIsLoadingAssets)
+		{
+			QueuedDestructionForces.Add(Force);
+		}
+		return;
+	}
+
 	// if this is the first time we are initiating destruction force on this mesh, hot swap with the true destructible.
 	if (bIsInRestingState)
 	{
-		MeshComponent->SetVisibility(true, true);
+		ShowDestructibleMesh();
 		// MeshComponent->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
 		
-		SourceGeometryContainer->SetVisibility(false,true);
+		SetSourceGeometryVisible(false);
 		// TArray<USceneComponent*> SourceMeshes;
 		// SourceGeometryContainer->GetChildrenComponents(false, SourceMeshes);
 		// for (const auto Child : SourceMeshes)
@@ -82,30 +179,66 @@ void ANiagaraDestructionDriverActor::InitiateDestructionForce(FVector ForceOrigi
 		// }
 		
 		// increase the bounds scale of the mesh to allow for shadows and culling to work correctly
-		MeshComponent->SetBoundsScale(CullingBoundsMultiplier);
-		for (const auto DynamicMaterial : MeshMaterialsWithParamsSet)
+		ApplyBoundsScale(CullingBoundsMultiplier, true);
+
+		bIsInRestingState = false;
+
+		// simulated at the rate its screen size deserves from now on
+		EnterSignificance();
+
+		// fragments only live for so long after the first hit
+		const float FragmentLifetime = NiagaraDestructionDriverParams->GetFragmentLifetime();
+		if (FragmentLifetime > 0.f)
 		{
-			DynamicMaterial->SetScalarParameterValue(FName("ObjectBoundsScale"), CullingBoundsMultiplier);
+			GetWorldTimerManager().SetTimer(DespawnTimerHandle, this, &ANiagaraDestructionDriverActor::StartFragmentDespawn, FragmentLifetime, false);
 		}
-		
-		bIsInRestingState = false;
 	}
 
-	const auto ForceStartTime = GetWorld()->GetTimeSeconds();
+	// then follow the actual debris, again if it had stopped moving before this force
+	StartDynamicBounds();
+
+	// deferred forces (asset loading, activation budget) keep their start time, unless they would already be over
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+	const float ForceStartTime = Force.StartTime + Force.Duration >= WorldTime ? Force.StartTime : WorldTime;
 
 	// provide the force parameters to the underlying particle system that drives the destruction simulation
-	NiagaraComponent->SetVariableVec3("ForceCenter", ForceOrigin);
-	NiagaraComponent->SetVariableFloat("ForceRadius", ForceRadius);
-	NiagaraComponent->SetVariableFloat("ForceStartTime", ForceStartTime);
-	NiagaraComponent->SetVariableFloat("ForceDuration", ForceDuration);
+	if (InstanceSlot != INDEX_NONE)
+	{
+		// the instance group's simulation takes every force of the frame at once
+		if (UNiagaraDestructionDriverInstancingSubsystem* Instancing = GetInstancing())
+		{
+			Instancing->ApplyForce(this, FNiagaraDestructionDriverForce(Force.Origin, Force.Radius, Force.Duration, ForceStartTime));
+		}
+	}
+	else if (bUsesSharedSimulation)
+	{
+		// routed to our bone range, sent with the rest of the page's forces
+		if (UNiagaraDestructionDriverSharedSimulationSubsystem* SharedSimulation = GetSharedSimulation())
+		{
+			SharedSimulation->ApplyForce(this, FNiagaraDestructionDriverForce(Force.Origin, Force.Radius, Force.Duration, ForceStartTime));
+		}
+	}
+	else if (NiagaraComponent || BorrowNiagaraComponent())
+	{
+		// our own component lost its system instance when we settled
+		if (!NiagaraComponent->IsActive())
+		{
+			NiagaraComponent->Activate(true);
+		}
+		const FNiagaraDestructionDriverParameterNames& ParameterNames = FNiagaraDestructionDriverParameterNames::Get();
+		NiagaraComponent->SetVariableVec3(ParameterNames.ForceCenter, Force.Origin);
+		NiagaraComponent->SetVariableFloat(ParameterNames.ForceRadius, Force.Radius);
+		NiagaraComponent->SetVariableFloat(ParameterNames.ForceStartTime, ForceStartTime);
+		NiagaraComponent->SetVariableFloat(ParameterNames.ForceDuration, Force.Duration);
+	}
 
 	UE_LOG(LogNiagaraDestructionDriver, Log, TEXT("Destruction Force Generated at (%f, %f, %f) with radius: %f, start time: %f, and duration: %f"),
-			ForceOrigin.X,
-			ForceOrigin.Y,
-			ForceOrigin.Z,
-			ForceRadius,
+			Force.Origin.X,
+			Force.Origin.Y,
+			Force.Origin.Z,
+			Force.Radius,
 			ForceStartTime,
-			ForceDuration);
+			Force.Duration);
 }
 
 void ANiagaraDestructionDriverActor::PostInitProperties()
@@ -120,41 +253,208 @@ void ANiagaraDestructionDriverActor::PostInitializeComponents()
 
 void ANiagaraDestructionDriverActor::BeginPlay()
 {
+	SCOPE_CYCLE_COUNTER(STAT_NDD_BeginPlay);
+
 	Super::BeginPlay();
 
 	ensureMsgf(NiagaraDestructionDriverParams != nullptr, TEXT("Niagara Destruction Driver Actor has no data asset specified. Make sure you set NiagaraDestructionDriverParams property."));
-	ensureMsgf(NiagaraDestructionDriverParams->InitialBoneLocationsTexture != nullptr, TEXT("Niagara Destruction Driver data asset is missing the required initial bones locations texture. This should have been auto generated."));
+	ensureMsgf(NiagaraDestructionDriverParams->InitialBoneLocationsTexture.IsNull() == false, TEXT("Niagara Destruction Driver data asset is missing the required initial bones locations texture. This should have been auto generated."));
 	ensureMsgf(NiagaraDestructionDriverParams->ParticleSystemDriver.IsNull() == false, TEXT("Niagara Destruction Driver data asset is missing the required particle system property. This should have been auto generated."));
 
-	if (NiagaraDestructionDriverParams != nullptr)
-	{
-		// Create the rotations render target object
-		RotationsTexture = NewObject<UTextureRenderTarget2D>();
-		RotationsTexture->RenderTargetFormat = RTF_RGBA16f;
-		RotationsTexture->ClearColor = FLinearColor::Black;
-		RotationsTexture->bAutoGenerateMips = false;
-		RotationsTexture->bCanCreateUAV = false;
-		RotationsTexture->InitAutoFormat(NiagaraDestructionDriverParams->RenderTargetTextureSize, NiagaraDestructionDriverParams->RenderTargetTextureSize);	
-		RotationsTexture->LODGroup = TEXTUREGROUP_16BitData;
-		RotationsTexture->UpdateResourceImmediate(true);
-
-		// Create the positions render target object
-		PositionsTexture = NewObject<UTextureRenderTarget2D>();
-		PositionsTexture->RenderTargetFormat = RTF_RGBA16f;
-		PositionsTexture->ClearColor = FLinearColor::Black;
-		PositionsTexture->bAutoGenerateMips = false;
-		PositionsTexture->bCanCreateUAV = false;
-		PositionsTexture->InitAutoFormat(NiagaraDestructionDriverParams->RenderTargetTextureSize, NiagaraDestructionDriverParams->RenderTargetTextureSize);	
-		PositionsTexture->LODGroup = TEXTUREGROUP_16BitData;
-		PositionsTexture->UpdateResourceImmediate(true);
+	bIsHeadless = !UNiagaraDestructionDriverHelper::ShouldCreateRenderResources(this);
+
+	// the subobject always exists so the class layout doesn't depend on the setting, pooled destructibles borrow one when hit
+	if (GetDefault<UNiagaraDestructionDriverSettings>()->bPoolNiagaraComponents && NiagaraComponent)
+	{
+		NiagaraComponent->DestroyComponent();
+		NiagaraComponent = nullptr;
+	}
+
+	// destroyed before its level streamed out last time, or loaded from a save game before play (which wins)
+	FNiagaraDestructionDriverSavedState SavedState;
+	bool bHasSavedState = false;
+	if (UNiagaraDestructionDriverStreamingSubsystem* Streaming = GetWorld()->GetSubsystem<UNiagaraDestructionDriverStreamingSubsystem>())
+	{
+		bHasSavedState = Streaming->ConsumeState(this, SavedState);
+	}
+	if (bHasPendingSavedState)
+	{
+		SavedState = MoveTemp(PendingSavedState);
+		bHasSavedState = true;
+		bHasPendingSavedState = false;
+	}
+
+	if (!bIsHeadless)
+	{
+		BatchSourceGeometry();
+	}
+
+	if (bIsHeadless)
+	{
+		// never rendered, so don't load the niagara system or create render targets / materials at all
+		if (NiagaraComponent)
+		{
+			NiagaraComponent->DeactivateImmediate();
+		}
+		if (bHasSavedState)
+		{
+			RestoreState(SavedState);
+		}
+		return;
+	}
+
+	if (bTrackTransformChanges)
+	{
+		TransformUpdatedHandle = MeshComponent->TransformUpdated.AddUObject(this, &ANiagaraDestructionDriverActor::OnMeshTransformUpdated);
+	}
+
+	// without streaming the mesh and bone texture stay resident for as long as we're around, like hard references
+	if (!GetDefault<UNiagaraDestructionDriverSettings>()->bStreamDestructibleMeshes)
+	{
+		RetainStreamedAssets();
+	}
+
+	if (bHasSavedState)
+	{
+		RestoreState(SavedState);
+	}
+	else if (!bLazyActivation)
+	{
+		ActivateDestructible();
+	}
+	else if (LazyActivationDistance > 0.f || AssetStreamingDistance > 0.f)
+	{
+		// poll player proximity until something activates us
+		SetActorTickInterval(GetDefault<UNiagaraDestructionDriverSettings>()->LazyActivationCheckInterval);
+		SetActorTickEnabled(true);
+	}
+}
+
+void ANiagaraDestructionDriverActor::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (!bIsActivated && bLazyActivation)
+	{
+		double ClosestDistanceSquared = TNumericLimits<double>::Max();
+		for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+		{
+			const APlayerController* PlayerController = It->Get();
+			if (PlayerController && PlayerController->PlayerCameraManager)
+			{
+				ClosestDistanceSquared = FMath::Min(ClosestDistanceSquared, FVector::DistSquared(PlayerController->PlayerCameraManager->GetCameraLocation(), GetActorLocation()));
+			}
+		}
+
+		if (LazyActivationDistance > 0.f && ClosestDistanceSquared <= FMath::Square(static_cast<double>(LazyActivationDistance)))
+		{
+			ActivateDestructible();
+		}
+		else if (AssetStreamingDistance > 0.f && ClosestDistanceSquared <= FMath::Square(static_cast<double>(AssetStreamingDistance)))
+		{
+			PrefetchDestructionAssets();
+		}
+		else if (AssetStreamingDistance > 0.f && bIsInRestingState && !bIsLoadingAssets && !bIsHotSwapScheduled
+			&& ClosestDistanceSquared > FMath::Square(1.5 * AssetStreamingDistance))
+		{
+			// everyone walked past without destroying us
+			ReleaseStreamedAssets();
+		}
+	}
+}
+
+void ANiagaraDestructionDriverActor::ActivateDestructible()
+{
+	if (bIsActivated || bIsLoadingAssets || bIsHeadless || NiagaraDestructionDriverParams == nullptr)
+	{
+		return;
+	}
+	SetActorTickEnabled(false);
+
+	TArray<FSoftObjectPath> AssetsToLoad;
+	NiagaraDestructionDriverParams->GetDestructionAssetPaths(AssetsToLoad);
+	if (CVarNDD_DebugMaterial.GetValueOnGameThread() == 1)
+	{
+		AssetsToLoad.AddUnique(GetDefault<UNiagaraDestructionDriverSettings>()->DebugMaterialForNiagaraDestructibles.ToSoftObjectPath());
+	}
+
+	UNiagaraDestructionDriverAssetLoader* AssetLoader = GetAssetLoader();
+	if (AssetLoader == nullptr)
+	{
+		// no game instance (editor preview worlds), nothing to batch with
+		for (const FSoftObjectPath& AssetPath : AssetsToLoad)
+		{
+			AssetPath.TryLoad();
+		}
+		FinishActivation();
+		return;
+	}
+
+	// keeps the mesh and bone texture resident until a reset, the settle bake, the last fragment despawning or EndPlay
+	RetainStreamedAssets();
+
+	// executes right away if everything is already in memory
+	bIsLoadingAssets = true;
+	AssetLoader->RequestAssets(AssetsToLoad, FSimpleDelegate::CreateWeakLambda(this, [this]()
+	{
+		bIsLoadingAssets = false;
+		if (HasActorBegunPlay() && !IsActorBeingDestroyed())
+		{
+			FinishActivation();
+		}
+	}));
+}
+
+void ANiagaraDestructionDriverActor::FinishActivation()
+{
+	SCOPE_CYCLE_COUNTER(STAT_NDD_FinishActivation);
+
+	bIsActivated = true;
+
+	if (UNiagaraDestructionDriverPrewarmSubsystem* Prewarm = GetWorld()->GetSubsystem<UNiagaraDestructionDriverPrewarmSubsystem>())
+	{
+		Prewarm->NoteActivation(NiagaraDestructionDriverParams);
+	}
+
+	// resolved once per data asset and shared between all actors using it
+	FNiagaraDestructionDriverRuntimeContext UncachedContext;
+	if (CVarNDD_UseRuntimeContextCache.GetValueOnGameThread() != 1)
+	{
+		UncachedContext = FNiagaraDestructionDriverRuntimeContext::Build(NiagaraDestructionDriverParams);
+	}
+	const FNiagaraDestructionDriverRuntimeContext& Context = UncachedContext.IsValid() ? UncachedContext : NiagaraDestructionDriverParams->GetRuntimeContext();
+	const FNiagaraDestructionDriverParameterNames& ParameterNames = FNiagaraDestructionDriverParameterNames::Get();
+
+	// instanced data assets draw and simulate through their group, nothing of our own to set up
+	if (AcquireInstance(Context))
+	{
+		if (RestoredBonePositions.Num() > 0)
+		{
+			ApplyRestoredPose();
+		}
+		ReplayQueuedDestructionForces();
+		return;
 	}
+
+	AcquireRenderTargets();
 	
-	if (NiagaraDestructionDriverParams && NiagaraDestructionDriverParams->StaticMesh)
+	if (Context.StaticMesh)
 	{
-		MeshComponent->SetStaticMesh(NiagaraDestructionDriverParams->StaticMesh);
+		MeshComponent->SetStaticMesh(Context.StaticMesh);
 		MeshComponent->SetVisibility(false, true);
 	}
 
+	// per bone scale the material shrinks despawning fragments with
+	if (NiagaraDestructionDriverParams->GetFragmentLifetime() > 0.f && Context.RenderTargetTextureSize > 0)
+	{
+		BoneScaleMask = UTexture2D::CreateTransient(Context.RenderTargetTextureSize, Context.RenderTargetTextureSize, PF_G8);
+		BoneScaleMask->Filter = TF_Nearest;
+		BoneScaleMask->SRGB = false;
+		BoneScaleMask->UpdateResource();
+		BoneScales.Init(255, Context.RenderTargetTextureSize * Context.RenderTargetTextureSize);
+		UpdateBoneScaleMask();
+	}
+
 	// Create the dynamic material instance for our mesh and set the relevant parameters
 	if (CVarNDD_DebugMaterial.GetValueOnGameThread() == 1)
 	{
@@ -165,62 +465,1617 @@ void ANiagaraDestructionDriverActor::BeginPlay()
 		// Use quaternion for material parameter - best for smooth interpolation
 		const FQuat QuatRotation = GetActorRotation().Quaternion();
 		const FVector4 QuatVector = FVector4(QuatRotation.X, QuatRotation.Y, QuatRotation.Z, QuatRotation.W);
-		const FVector Extents = MeshComponent->GetStaticMesh()->GetBoundingBox().GetExtent();
+		AppliedActorRotation = QuatRotation;
+
+		// with custom primitive data, actors binding the same textures share their materials
+		UNiagaraDestructionDriverMaterialCache* MaterialCache = GetDefault<UNiagaraDestructionDriverSettings>()->bUseCustomPrimitiveData
+			? GetWorld()->GetSubsystem<UNiagaraDestructionDriverMaterialCache>()
+			: nullptr;
 		
 		// Create the dynamic material instance for our mesh and set the relevant parameters
-		uint32 Idx = 0;
-		MeshMaterialsWithParamsSet.Empty();
-		MeshMaterialsWithParamsSet.Reserve(MeshComponent->GetMaterialSlotNames().Num());
-		for (const auto MaterialSlot : MeshComponent->GetMaterialSlotNames())
+		const int32 NumMaterialSlots = Context.SlotMaterials.Num();
+		ReleaseMaterials();
+		MeshMaterialsWithParamsSet.Reserve(NumMaterialSlots);
+		bMaterialsAreShared = MaterialCache != nullptr;
+		for (int32 Idx = 0; Idx < NumMaterialSlots; Idx++)
 		{
-			const auto SlotMaterial = MeshComponent->GetMaterial(Idx);
+			// respect per component material overrides, otherwise use the cached slot material
+			const bool bHasOverrideMaterial = MeshComponent->OverrideMaterials.IsValidIndex(Idx) && MeshComponent->OverrideMaterials[Idx] != nullptr;
+			UMaterialInterface* SlotMaterial = bHasOverrideMaterial ? MeshComponent->OverrideMaterials[Idx].Get() : Context.SlotMaterials[Idx].Get();
+			if (MaterialCache)
+			{
+				UMaterialInstanceDynamic* SharedMaterial = MaterialCache->AcquireMaterial(SlotMaterial, Context, PositionsTexture, RotationsTexture, BoneScaleMask);
+				MeshMaterialsWithParamsSet.Add(SharedMaterial);
+				MeshComponent->SetMaterial(Idx, SharedMaterial);
+				continue;
+			}
 			UMaterialInstanceDynamic* DynamicMaterial = UMaterialInstanceDynamic::Create(SlotMaterial, this, FName(GetName()+"_Material"+FString::FromInt(Idx)));
-			DynamicMaterial->SetScalarParameterValue(FName("RT_Size"), NiagaraDestructionDriverParams->RenderTargetTextureSize);
-			DynamicMaterial->SetTextureParameterValue(FName("RT_Position"), PositionsTexture);
-			DynamicMaterial->SetTextureParameterValue(FName("RT_Rotation"), RotationsTexture);
-			DynamicMaterial->SetTextureParameterValue(FName("InitialBoneLocations"), NiagaraDestructionDriverParams->InitialBoneLocationsTexture);
-			DynamicMaterial->SetVectorParameterValue(FName("ActorRotationQuat"), QuatVector);
-			DynamicMaterial->SetVectorParameterValue(FName("MeshHalfExtents"), Extents);
+			DynamicMaterial->SetScalarParameterValue(ParameterNames.RT_Size, Context.RenderTargetTextureSize);
+			DynamicMaterial->SetTextureParameterValue(ParameterNames.RT_Position, PositionsTexture);
+			DynamicMaterial->SetTextureParameterValue(ParameterNames.RT_Rotation, RotationsTexture);
+			DynamicMaterial->SetVectorParameterValue(ParameterNames.RT_TileOffsetScale, RenderTargetTileOffsetScale);
+			DynamicMaterial->SetTextureParameterValue(ParameterNames.InitialBoneLocations, Context.InitialBoneLocationsTexture);
+			DynamicMaterial->SetVectorParameterValue(ParameterNames.ActorRotationQuat, QuatVector);
+			DynamicMaterial->SetVectorParameterValue(ParameterNames.MeshHalfExtents, Context.MeshHalfExtents);
+			if (BoneScaleMask)
+			{
+				DynamicMaterial->SetTextureParameterValue(ParameterNames.BoneScaleMask, BoneScaleMask);
+			}
 			MeshMaterialsWithParamsSet.Add(DynamicMaterial);
 			MeshComponent->SetMaterial(Idx, DynamicMaterial);
-			Idx++;
 		}
 
-		// uint32 Index = 0;
-		// for (const auto DynamicMaterial : MeshMaterialsWithParamsSet)
-		// {
-		// 	DynamicMaterial->SetScalarParameterValue(FName("RT_Size"), NiagaraDestructionDriverParams->RenderTargetTextureSize);
-		// 	DynamicMaterial->SetTextureParameterValue(FName("RT_Position"), PositionsTexture);
-		// 	DynamicMaterial->SetTextureParameterValue(FName("RT_Rotation"), RotationsTexture);
-		// 	DynamicMaterial->SetTextureParameterValue(FName("InitialBoneLocations"), NiagaraDestructionDriverParams->InitialBoneLocationsTexture);
-		// 	MeshComponent->SetMaterial(Index, DynamicMaterial);
-		// 	Index++;
-		// }
+		if (bMaterialsAreShared)
+		{
+			MeshComponent->SetCustomPrimitiveDataVector4(FNiagaraDestructionDriverPrimitiveData::RT_TileOffsetScale, RenderTargetTileOffsetScale);
+			MeshComponent->SetCustomPrimitiveDataVector4(FNiagaraDestructionDriverPrimitiveData::ActorRotationQuat, QuatVector);
+			MeshComponent->SetCustomPrimitiveDataFloat(FNiagaraDestructionDriverPrimitiveData::ObjectBoundsScale, CurrentBoundsScale);
+		}
 	}
 
-	// set niagara asset variables
-	if (!NiagaraDestructionDriverParams->ParticleSystemDriver.IsNull())
+	// set niagara asset variables, unless the shared simulation of our atlas page simulates us.
+	// Pooled niagara components are only borrowed once we're hit.
+	if (Context.ParticleSystem && !AcquireSharedSimulation(Context) && NiagaraComponent && !bNiagaraComponentIsPooled)
 	{
-		UNiagaraSystem* BaseNiagaraAsset = NiagaraDestructionDriverParams->ParticleSystemDriver.LoadSynchronous();
-		NiagaraComponent->SetAsset(BaseNiagaraAsset);
-		NiagaraComponent->SetVariableStaticMesh("DestructibleMesh", MeshComponent->GetStaticMesh());
-		NiagaraComponent->SetVariableTexture("InitialBonePositionsTexture", NiagaraDestructionDriverParams->InitialBoneLocationsTexture);
-		NiagaraComponent->SetVariableTextureRenderTarget("SimulatedParticlePositionsOut", PositionsTexture);
-		NiagaraComponent->SetVariableTextureRenderTarget("SimulatedParticleRotationsOut", RotationsTexture);
-		NiagaraComponent->SetVariableVec3(FName("DestructibleMeshLocalHalfExtents"), this->MeshComponent->GetStaticMesh()->GetBoundingBox().GetExtent());
-
-		// moves the particle system to be centered against the destructible mesh and so that all the local space ([-1,1] space) particles are correctly aligned.
-		NiagaraComponent->SetRelativeLocation(-NiagaraDestructionDriverParams->PivotOffset);
+		NiagaraComponent->SetAsset(Context.ParticleSystem);
+		ConfigureNiagaraComponent(Context);
 		// NiagaraComponent->ResetSystem();
 	}
+
+	if (RestoredBonePositions.Num() > 0)
+	{
+		ApplyRestoredPose();
+	}
+	ReplayQueuedDestructionForces();
 }
 
-#if WITH_EDITOR
-void ANiagaraDestructionDriverActor::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+void ANiagaraDestructionDriverActor::ReplayQueuedDestructionForces()
 {
-	Super::PostEditChangeProperty(PropertyChangedEvent);
+	// replay the forces that arrived while we were loading
+	TArray<FNiagaraDestructionDriverForce> ForcesToReplay = MoveTemp(QueuedDestructionForces);
+	for (const FNiagaraDestructionDriverForce& Force : ForcesToReplay)
+	{
+		ApplyDestructionForce(Force);
+	}
+}
 
-	const FName PropertyName = PropertyChangedEvent.GetPropertyName();
+void ANiagaraDestructionDriverActor::BatchSourceGeometry()
+{
+	// moving destructibles would leave their instances behind
+	UNiagaraDestructionDriverProxySubsystem* ProxySubsystem = GetWorld()->GetSubsystem<UNiagaraDestructionDriverProxySubsystem>();
+	if (!GetDefault<UNiagaraDestructionDriverSettings>()->bBatchSourceGeometry || bTrackTransformChanges || ProxySubsystem == nullptr)
+	{
+		return;
+	}
+
+	TArray<USceneComponent*> SourceMeshes;
+	SourceGeometryContainer->GetChildrenComponents(false, SourceMeshes);
+	for (USceneComponent* Child : SourceMeshes)
+	{
+		// already instanced meshes are left alone
+		UStaticMeshComponent* SourceMesh = Cast<UStaticMeshComponent>(Child);
+		if (SourceMesh == nullptr || SourceMesh->IsA<UInstancedStaticMeshComponent>() || SourceMesh->GetStaticMesh() == nullptr)
+		{
+			continue;
+		}
+		FNiagaraDestructionDriverProxyMesh& ProxyMesh = BatchedSourceGeometry.AddDefaulted_GetRef();
+		ProxyMesh.RelativeTransform = SourceMesh->GetComponentTransform().GetRelativeTransform(GetActorTransform());
+		ProxyMesh.BatchIndex = ProxySubsystem->FindOrAddBatch(SourceMesh);
+		SourceMesh->DestroyComponent();
+	}
+
+	if (BatchedSourceGeometry.Num() > 0 && SourceGeometryContainer->IsVisible())
+	{
+		SetSourceGeometryVisible(true);
+	}
+}
+
+void ANiagaraDestructionDriverActor::SetSourceGeometryVisible(const bool bVisible)
+{
+	if (BatchedSourceGeometry.Num() == 0)
+	{
+		SourceGeometryContainer->SetVisibility(bVisible, true);
+		return;
+	}
+
+	UNiagaraDestructionDriverProxySubsystem* ProxySubsystem = GetWorld()->GetSubsystem<UNiagaraDestructionDriverProxySubsystem>();
+	if (ProxySubsystem == nullptr)
+	{
+		return;
+	}
+	for (const int32 ProxyId : SourceGeometryProxies)
+	{
+		ProxySubsystem->RemoveProxy(ProxyId);
+	}
+	SourceGeometryProxies.Reset();
+
+	// added again where we are now, pooled destructibles are reset after being moved
+	if (bVisible)
+	{
+		FNiagaraDestructionDriverProxyOwner Owner;
+		Owner.Destructible = this;
+		const FTransform ActorTransform = GetActorTransform();
+		for (const FNiagaraDestructionDriverProxyMesh& ProxyMesh : BatchedSourceGeometry)
+		{
+			SourceGeometryProxies.Add(ProxySubsystem->AddProxy(ProxyMesh.BatchIndex, ProxyMesh.RelativeTransform * ActorTransform, Owner));
+		}
+	}
+}
+
+bool ANiagaraDestructionDriverActor::AcquireInstance(const FNiagaraDestructionDriverRuntimeContext& Context)
+{
+	// bone scales and the debug material are per actor
+	if (!NiagaraDestructionDriverParams->bInstanced || NiagaraDestructionDriverParams->GetFragmentLifetime() > 0.f || CVarNDD_DebugMaterial.GetValueOnGameThread() == 1)
+	{
+		return false;
+	}
+	UNiagaraDestructionDriverInstancingSubsystem* Instancing = GetInstancing();
+	InstanceSlot = Instancing ? Instancing->AcquireInstance(this, Context) : INDEX_NONE;
+	if (InstanceSlot == INDEX_NONE)
+	{
+		return false;
+	}
+
+	// the group's pages, our tile in them. Readbacks, restores and bakes go through these like with the atlas.
+	PositionsTexture = Instancing->GetPositionsTexture(this);
+	RotationsTexture = Instancing->GetRotationsTexture(this);
+	RenderTargetTileOffsetScale = Instancing->GetTileOffsetScale(this);
+	AppliedActorRotation = GetActorQuat();
+	MeshComponent->SetVisibility(false, true);
+	// the mesh baked before a force woke us up
+	MeshComponent->SetStaticMesh(nullptr);
+	return true;
+}
+
+void ANiagaraDestructionDriverActor::ReleaseInstance()
+{
+	if (InstanceSlot == INDEX_NONE)
+	{
+		return;
+	}
+	if (UNiagaraDestructionDriverInstancingSubsystem* Instancing = GetInstancing())
+	{
+		Instancing->ReleaseInstance(this);
+	}
+	InstanceSlot = INDEX_NONE;
+}
+
+UNiagaraDestructionDriverInstancingSubsystem* ANiagaraDestructionDriverActor::GetInstancing() const
+{
+	return GetWorld()->GetSubsystem<UNiagaraDestructionDriverInstancingSubsystem>();
+}
+
+bool ANiagaraDestructionDriverActor::AcquireSharedSimulation(const FNiagaraDestructionDriverRuntimeContext& Context)
+{
+	if (bUsesSharedSimulation)
+	{
+		return true;
+	}
+	if (!GetDefault<UNiagaraDestructionDriverSettings>()->bUseSharedSimulation || !RenderTargetAtlasTile.IsValid())
+	{
+		return false;
+	}
+	UNiagaraDestructionDriverSharedSimulationSubsystem* SharedSimulation = GetSharedSimulation();
+	bUsesSharedSimulation = SharedSimulation && SharedSimulation->AcquireRange(this, Context, RenderTargetAtlasTile);
+	if (bUsesSharedSimulation && NiagaraComponent && !bNiagaraComponentIsPooled)
+	{
+		// a system set up before (shared simulation was full back then) must not write our tile as well
+		NiagaraComponent->DeactivateImmediate();
+		NiagaraComponent->SetAsset(nullptr);
+	}
+	return bUsesSharedSimulation;
+}
+
+void ANiagaraDestructionDriverActor::ReleaseSharedSimulation()
+{
+	if (!bUsesSharedSimulation)
+	{
+		return;
+	}
+	if (UNiagaraDestructionDriverSharedSimulationSubsystem* SharedSimulation = GetSharedSimulation())
+	{
+		SharedSimulation->ReleaseRange(this);
+	}
+	bUsesSharedSimulation = false;
+}
+
+UNiagaraDestructionDriverSharedSimulationSubsystem* ANiagaraDestructionDriverActor::GetSharedSimulation() const
+{
+	return GetWorld()->GetSubsystem<UNiagaraDestructionDriverSharedSimulationSubsystem>();
+}
+
+void ANiagaraDestructionDriverActor::ConfigureNiagaraComponent(const FNiagaraDestructionDriverRuntimeContext& Context)
+{
+	const FNiagaraDestructionDriverParameterNames& ParameterNames = FNiagaraDestructionDriverParameterNames::Get();
+	NiagaraComponent->SetVariableStaticMesh(ParameterNames.DestructibleMesh, Context.StaticMesh);
+	NiagaraComponent->SetVariableTexture(ParameterNames.InitialBonePositionsTexture, Context.InitialBoneLocationsTexture);
+	NiagaraComponent->SetVariableTextureRenderTarget(ParameterNames.SimulatedParticlePositionsOut, PositionsTexture);
+	NiagaraComponent->SetVariableTextureRenderTarget(ParameterNames.SimulatedParticleRotationsOut, RotationsTexture);
+	NiagaraComponent->SetVariableVec4(ParameterNames.RenderTargetTileOffsetScale, RenderTargetTileOffsetScale);
+	NiagaraComponent->SetVariableVec3(ParameterNames.DestructibleMeshLocalHalfExtents, Context.MeshHalfExtents);
+
+	// moves the particle system to be centered against the destructible mesh and so that all the local space ([-1,1] space) particles are correctly aligned.
+	NiagaraComponent->SetRelativeLocation(-Context.PivotOffset);
+}
+
+bool ANiagaraDestructionDriverActor::BorrowNiagaraComponent()
+{
+	const FNiagaraDestructionDriverRuntimeContext& Context = NiagaraDestructionDriverParams->GetRuntimeContext();
+	if (Context.ParticleSystem == nullptr)
+	{
+		UE_LOG(LogNiagaraDestructionDriver, Warning, TEXT("%s: data asset %s has no particle system to simulate with, the destruction force is dropped."),
+				*GetName(), *GetNameSafe(NiagaraDestructionDriverParams));
+		return false;
+	}
+
+	UNiagaraDestructionDriverNiagaraComponentPool* Pool = GetWorld()->GetSubsystem<UNiagaraDestructionDriverNiagaraComponentPool>();
+	UNiagaraComponent* Component = Pool ? Pool->AcquireComponent(this, Context.ParticleSystem) : nullptr;
+	if (Component)
+	{
+		NiagaraComponent = Component;
+		bNiagaraComponentIsPooled = true;
+		NiagaraComponent->AttachToComponent(RootComponent, FAttachmentTransformRules::SnapToTargetIncludingScale);
+	}
+	else
+	{
+		// the fragments are already shown, simulate them with a component of our own like without pooling
+		UE_LOG(LogNiagaraDestructionDriver, Warning, TEXT("%s: no niagara component could be borrowed from the pool, creating one of its own."), *GetName());
+		NiagaraComponent = NewObject<UNiagaraComponent>(this);
+		NiagaraComponent->SetAutoActivate(false);
+		NiagaraComponent->SetAsset(Context.ParticleSystem);
+		NiagaraComponent->SetupAttachment(RootComponent);
+		NiagaraComponent->RegisterComponent();
+	}
+	ConfigureNiagaraComponent(Context);
+	NiagaraComponent->Activate(true);
+	return true;
+}
+
+void ANiagaraDestructionDriverActor::ReturnNiagaraComponent()
+{
+	if (!bNiagaraComponentIsPooled)
+	{
+		return;
+	}
+	// cleared first, the pool may ask for it again while we give it back
+	UNiagaraComponent* Component = NiagaraComponent;
+	NiagaraComponent = nullptr;
+	bNiagaraComponentIsPooled = false;
+	if (UNiagaraDestructionDriverNiagaraComponentPool* Pool = GetWorld()->GetSubsystem<UNiagaraDestructionDriverNiagaraComponentPool>())
+	{
+		Pool->ReleaseComponent(Component);
+	}
+}
+
+void ANiagaraDestructionDriverActor::SetSignificanceTier(const ENiagaraDestructionDriverSignificanceTier Tier)
+{
+	if (Tier == SignificanceTier || bIsInRestingState || bIsSettled)
+	{
+		return;
+	}
+	const ENiagaraDestructionDriverSignificanceTier PreviousTier = SignificanceTier;
+	SignificanceTier = Tier;
+	if (Tier == ENiagaraDestructionDriverSignificanceTier::Baked)
+	{
+		// the render targets keep the pose, or it's baked with bBakeSettledDestructibles
+		SettleNow();
+		return;
+	}
+
+	// instance groups and shared simulations are paused as a whole, once none of their destructibles simulates
+	if (NiagaraComponent == nullptr || InstanceSlot != INDEX_NONE || bUsesSharedSimulation)
+	{
+		return;
+	}
+	NiagaraComponent->SetCustomTimeDilation(1.f);
+	NiagaraComponent->SetPaused(Tier == ENiagaraDestructionDriverSignificanceTier::Frozen);
+	if (Tier == ENiagaraDestructionDriverSignificanceTier::Frozen)
+	{
+		// frozen fragments don't move, that's not settling
+		GetWorldTimerManager().ClearTimer(SettleTimerHandle);
+		SettlePositionsSnapshot.Empty();
+		SettleReadback.Reset();
+	}
+	else if (PreviousTier == ENiagaraDestructionDriverSignificanceTier::Frozen)
+	{
+		ScheduleSettleCheck();
+	}
+}
+
+void ANiagaraDestructionDriverActor::EnterSignificance()
+{
+	if (!GetDefault<UNiagaraDestructionDriverSettings>()->bUseSignificance)
+	{
+		return;
+	}
+	if (UNiagaraDestructionDriverSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UNiagaraDestructionDriverSignificanceSubsystem>())
+	{
+		Significance->RegisterDestructible(this);
+	}
+}
+
+void ANiagaraDestructionDriverActor::ExitSignificance()
+{
+	if (UNiagaraDestructionDriverSignificanceSubsystem* Significance = GetWorld()->GetSubsystem<UNiagaraDestructionDriverSignificanceSubsystem>())
+	{
+		Significance->UnregisterDestructible(this);
+	}
+	if (SignificanceTier != ENiagaraDestructionDriverSignificanceTier::Full && NiagaraComponent)
+	{
+		NiagaraComponent->SetCustomTimeDilation(1.f);
+		NiagaraComponent->SetPaused(false);
+	}
+	SignificanceTier = ENiagaraDestructionDriverSignificanceTier::Full;
+}
+
+void ANiagaraDestructionDriverActor::SettleNow()
+{
+	if (bIsInRestingState || bIsSettled)
+	{
+		return;
+	}
+	Settle();
+}
+
+void ANiagaraDestructionDriverActor::ShowDestructibleMesh()
+{
+	if (InstanceSlot == INDEX_NONE)
+	{
+		MeshComponent->SetVisibility(true, true);
+	}
+	else if (UNiagaraDestructionDriverInstancingSubsystem* Instancing = GetInstancing())
+	{
+		Instancing->ShowInstance(this);
+	}
+}
+
+void ANiagaraDestructionDriverActor::ResetToRestingState()
+{
+	CancelScheduledHotSwap();
+	GetWorldTimerManager().ClearTimer(SettleTimerHandle);
+	GetWorldTimerManager().ClearTimer(DespawnTimerHandle);
+	bIsSettled = false;
+	LastForceEndTime = 0.f;
+	DespawningBones.Reset();
+	SettlePositionsSnapshot.Empty();
+	SettleReadback.Reset();
+	CancelSettledPoseReadback();
+	SettledBonePositions.Empty();
+	SettledBoneRotations.Empty();
+	QueuedDestructionForces.Empty();
+	DestructionForceHistory.Empty();
+	RestoredBonePositions.Empty();
+	RestoredBoneRotations.Empty();
+	bIsInRestingState = true;
+	ExitSignificance();
+
+	if (bIsHeadless)
+	{
+		return;
+	}
+
+	// back to the proxy geometry
+	StopDynamicBounds();
+	CurrentBoundsScale = 1.f;
+	MeshComponent->SetVisibility(false, true);
+	MeshComponent->SetBoundsScale(1.f);
+	SetSourceGeometryVisible(true);
+
+	if (BakedStaticMesh || bFragmentsDespawned || (bIsActivated && bLazyActivation && GetDefault<UNiagaraDestructionDriverSettings>()->bStreamDestructibleMeshes))
+	{
+		// the render targets were given back when baking / despawning, set everything up again.
+		// Lazily activated destructibles go all the way back to their proxies and let go of the streamed assets.
+		bFragmentsDespawned = false;
+		DeactivateDestructible();
+	}
+
+	if (bIsActivated)
+	{
+		if (BoneScaleMask)
+		{
+			FMemory::Memset(BoneScales.GetData(), 255, BoneScales.Num());
+			UpdateBoneScaleMask();
+		}
+
+		// the actor may have been moved (pooled spawn)
+		ApplyBoundsScale(1.f, true);
+		ApplyActorRotation();
+
+		// respawns the particles at their initial bone locations
+		if (InstanceSlot != INDEX_NONE)
+		{
+			if (UNiagaraDestructionDriverInstancingSubsystem* Instancing = GetInstancing())
+			{
+				Instancing->ResetInstance(this);
+			}
+		}
+		else if (bUsesSharedSimulation)
+		{
+			if (UNiagaraDestructionDriverSharedSimulationSubsystem* SharedSimulation = GetSharedSimulation())
+			{
+				SharedSimulation->ResetRange(this);
+			}
+		}
+		else if (bNiagaraComponentIsPooled)
+		{
+			// the next hit borrows one again
+			ReturnNiagaraComponent();
+		}
+		else if (NiagaraComponent)
+		{
+			NiagaraComponent->ResetSystem();
+		}
+	}
+	else if (!bLazyActivation)
+	{
+		ActivateDestructible();
+	}
+	else if ((LazyActivationDistance > 0.f || AssetStreamingDistance > 0.f) && !bIsLoadingAssets)
+	{
+		SetActorTickEnabled(true);
+	}
+}
+
+void ANiagaraDestructionDriverActor::DeactivateDestructible()
+{
+	bIsActivated = false;
+	StopDynamicBounds();
+	CurrentBoundsScale = 1.f;
+	MeshComponent->SetBoundsScale(1.f);
+
+	ReturnNiagaraComponent();
+	if (NiagaraComponent)
+	{
+		NiagaraComponent->DeactivateImmediate();
+		NiagaraComponent->DestroyInstance();
+
+		// the user parameters would keep the streamed assets loaded
+		const FNiagaraDestructionDriverParameterNames& ParameterNames = FNiagaraDestructionDriverParameterNames::Get();
+		NiagaraComponent->SetVariableStaticMesh(ParameterNames.DestructibleMesh, nullptr);
+		NiagaraComponent->SetVariableTexture(ParameterNames.InitialBonePositionsTexture, nullptr);
+	}
+	MeshComponent->SetVisibility(false, true);
+	MeshComponent->EmptyOverrideMaterials();
+	MeshComponent->SetStaticMesh(nullptr);
+	ReleaseMaterials();
+	BakedStaticMesh = nullptr;
+	CancelSettledPoseReadback();
+	SettledBonePositions.Empty();
+	SettledBoneRotations.Empty();
+	BoneScaleMask = nullptr;
+	BoneScales.Empty();
+	ReleaseInstance();
+	ReleaseRenderTargets();
+	ReleaseStreamedAssets();
+}
+
+void ANiagaraDestructionDriverActor::PrefetchDestructionAssets()
+{
+	if (bIsHeadless || !HasActorBegunPlay() || NiagaraDestructionDriverParams == nullptr)
+	{
+		return;
+	}
+	RetainStreamedAssets();
+}
+
+UNiagaraDestructionDriverAssetLoader* ANiagaraDestructionDriverActor::GetAssetLoader() const
+{
+	const UGameInstance* GameInstance = GetGameInstance();
+	return GameInstance ? GameInstance->GetSubsystem<UNiagaraDestructionDriverAssetLoader>() : nullptr;
+}
+
+void ANiagaraDestructionDriverActor::RetainStreamedAssets()
+{
+	if (StreamedAssetsDataAsset != nullptr || NiagaraDestructionDriverParams == nullptr)
+	{
+		return;
+	}
+	if (UNiagaraDestructionDriverAssetLoader* AssetLoader = GetAssetLoader())
+	{
+		StreamedAssetsDataAsset = NiagaraDestructionDriverParams;
+		AssetLoader->RetainStreamedAssets(StreamedAssetsDataAsset);
+	}
+}
+
+void ANiagaraDestructionDriverActor::LoadStreamedAssets(FSimpleDelegate OnLoaded)
+{
+	TArray<FSoftObjectPath> AssetsToLoad;
+	NiagaraDestructionDriverParams->GetStreamedAssetPaths(AssetsToLoad);
+
+	UNiagaraDestructionDriverAssetLoader* AssetLoader = GetAssetLoader();
+	if (AssetLoader == nullptr)
+	{
+		for (const FSoftObjectPath& AssetPath : AssetsToLoad)
+		{
+			AssetPath.TryLoad();
+		}
+		OnLoaded.ExecuteIfBound();
+		return;
+	}
+	RetainStreamedAssets();
+	AssetLoader->RequestAssets(AssetsToLoad, MoveTemp(OnLoaded));
+}
+
+void ANiagaraDestructionDriverActor::ReleaseStreamedAssets(const bool bForce)
+{
+	if (StreamedAssetsDataAsset == nullptr || (!bForce && !GetDefault<UNiagaraDestructionDriverSettings>()->bStreamDestructibleMeshes))
+	{
+		return;
+	}
+	if (UNiagaraDestructionDriverAssetLoader* AssetLoader = GetAssetLoader())
+	{
+		AssetLoader->ReleaseStreamedAssets(StreamedAssetsDataAsset);
+	}
+	StreamedAssetsDataAsset = nullptr;
+}
+
+void ANiagaraDestructionDriverActor::SuspendSimulation()
+{
+	CancelScheduledHotSwap();
+	StopDynamicBounds();
+	CancelSettledPoseReadback();
+	GetWorldTimerManager().ClearTimer(SettleTimerHandle);
+	GetWorldTimerManager().ClearTimer(DespawnTimerHandle);
+	SetActorTickEnabled(false);
+
+	// pooled destructibles are hidden, their batched proxies would still be drawn
+	if (BatchedSourceGeometry.Num() > 0)
+	{
+		SetSourceGeometryVisible(false);
+	}
+	if (InstanceSlot != INDEX_NONE)
+	{
+		if (UNiagaraDestructionDriverInstancingSubsystem* Instancing = GetInstancing())
+		{
+			Instancing->SettleInstance(this);
+		}
+	}
+	else if (bUsesSharedSimulation)
+	{
+		if (UNiagaraDestructionDriverSharedSimulationSubsystem* SharedSimulation = GetSharedSimulation())
+		{
+			SharedSimulation->SettleRange(this);
+		}
+	}
+	else if (bNiagaraComponentIsPooled)
+	{
+		ReturnNiagaraComponent();
+	}
+	else if (bIsActivated && NiagaraComponent)
+	{
+		NiagaraComponent->DeactivateImmediate();
+	}
+}
+
+void ANiagaraDestructionDriverActor::RunScheduledHotSwap()
+{
+	bIsHotSwapScheduled = false;
+	TArray<FNiagaraDestructionDriverForce> ForcesToApply = MoveTemp(QueuedDestructionForces);
+	for (const FNiagaraDestructionDriverForce& Force : ForcesToApply)
+	{
+		ApplyDestructionForce(Force, false);
+	}
+}
+
+void ANiagaraDestructionDriverActor::CancelScheduledHotSwap()
+{
+	if (!bIsHotSwapScheduled)
+	{
+		return;
+	}
+	bIsHotSwapScheduled = false;
+	if (UNiagaraDestructionDriverActivationScheduler* Scheduler = GetWorld()->GetSubsystem<UNiagaraDestructionDriverActivationScheduler>())
+	{
+		Scheduler->CancelHotSwap(this);
+	}
+}
+
+bool ANiagaraDestructionDriverActor::CaptureState(FNiagaraDestructionDriverSavedState& OutState) const
+{
+	if (bIsInRestingState)
+	{
+		return false;
+	}
+
+	OutState = FNiagaraDestructionDriverSavedState();
+	OutState.DestructionForceHistory = DestructionForceHistory;
+	OutState.bFragmentsDespawned = bFragmentsDespawned;
+	OutState.bSettled = bIsSettled;
+	for (TConstSetBitIterator<> It(DespawningBones); It; ++It)
+	{
+		OutState.DespawnedBones.Add(It.GetIndex());
+	}
+	if (bIsHeadless || bFragmentsDespawned)
+	{
+		return true;
+	}
+
+	// the pose read back once settled (or restored). Still simulating, or settled only a few frames ago, there is none yet:
+	// restoring replays the force history then, like for states captured headless
+	const TArray<FFloat16Color>& BonePositions = SettledBonePositions;
+	const TArray<FFloat16Color>& BoneRotations = SettledBoneRotations;
+	if (BonePositions.Num() == 0 || BoneRotations.Num() == 0)
+	{
+		return true;
+	}
+
+	// only the bones the mesh has, the rest of the render target region is unused
+	const int32 NumBones = NiagaraDestructionDriverParams->InitialBoneLocations.Num() > 0 ? NiagaraDestructionDriverParams->InitialBoneLocations.Num() : BonePositions.Num();
+	const int32 NumSavedBones = FMath::Min3(NumBones, BonePositions.Num(), BoneRotations.Num());
+	OutState.BonePositions.Reserve(NumSavedBones);
+	OutState.BoneRotations.Reserve(NumSavedBones);
+	for (int32 BoneIdx = 0; BoneIdx < NumSavedBones; BoneIdx++)
+	{
+		const FFloat16Color& Position = BonePositions[BoneIdx];
+		const FFloat16Color& Rotation = BoneRotations[BoneIdx];
+		OutState.BonePositions.Add(FVector3f(Position.R.GetFloat(), Position.G.GetFloat(), Position.B.GetFloat()));
+		OutState.BoneRotations.Add(FQuat4f(Rotation.R.GetFloat(), Rotation.G.GetFloat(), Rotation.B.GetFloat(), Rotation.A.GetFloat()));
+	}
+	return true;
+}
+
+void ANiagaraDestructionDriverActor::RestoreState(const FNiagaraDestructionDriverSavedState& State)
+{
+	if (!bIsInRestingState || NiagaraDestructionDriverParams == nullptr)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_NDD_RestoreState);
+	const double RestoreStartTime = FPlatformTime::Seconds();
+	ON_SCOPE_EXIT
+	{
+		LastRestoreTimeMs = static_cast<float>((FPlatformTime::Seconds() - RestoreStartTime) * 1000.0);
+	};
+
+	CancelScheduledHotSwap();
+	DestructionForceHistory = State.DestructionForceHistory;
+	bIsInRestingState = false;
+	for (const FNiagaraDestructionDriverForce& Force : DestructionForceHistory)
+	{
+		LastForceEndTime = FMath::Max(LastForceEndTime, Force.StartTime + Force.Duration);
+	}
+	if (bIsHeadless)
+	{
+		// still simulating when captured: keep taking forces (late joiners get the grown history) and settle as usual
+		bIsSettled = State.bSettled;
+		if (!bIsSettled)
+		{
+			ScheduleSettleCheck();
+		}
+		return;
+	}
+
+	if (State.BonePositions.Num() == 0 && !State.bFragmentsDespawned)
+	{
+		// captured without a pose (on a server), the best we can do is run the forces again
+		bIsInRestingState = true;
+		DestructionForceHistory.Empty();
+		for (const FNiagaraDestructionDriverForce& Force : State.DestructionForceHistory)
+		{
+			InitiateDestructionForce(Force.Origin, Force.Radius, Force.Duration);
+		}
+		return;
+	}
+
+	bIsSettled = true;
+	SetActorTickEnabled(false);
+	SetSourceGeometryVisible(false);
+	if (State.bFragmentsDespawned)
+	{
+		bFragmentsDespawned = true;
+		MeshComponent->SetVisibility(false, true);
+		if (bIsActivated)
+		{
+			ReleaseDestroyedMesh();
+		}
+		return;
+	}
+
+	// back to the render target layout, bones past the saved ones stay at the origin
+	const int32 RenderTargetTextureSize = NiagaraDestructionDriverParams->RenderTargetTextureSize;
+	const int32 NumPixels = RenderTargetTextureSize * RenderTargetTextureSize;
+	RestoredBonePositions.Init(FFloat16Color(FLinearColor::Transparent), NumPixels);
+	RestoredBoneRotations.Init(FFloat16Color(FLinearColor(0.f, 0.f, 0.f, 1.f)), NumPixels);
+	for (int32 BoneIdx = 0; BoneIdx < FMath::Min(State.BonePositions.Num(), NumPixels); BoneIdx++)
+	{
+		const FVector3f& Position = State.BonePositions[BoneIdx];
+		RestoredBonePositions[BoneIdx] = FFloat16Color(FLinearColor(Position.X, Position.Y, Position.Z, 1.f));
+		if (State.BoneRotations.IsValidIndex(BoneIdx))
+		{
+			const FQuat4f& Rotation = State.BoneRotations[BoneIdx];
+			RestoredBoneRotations[BoneIdx] = FFloat16Color(FLinearColor(Rotation.X, Rotation.Y, Rotation.Z, Rotation.W));
+		}
+	}
+	DespawningBones.Init(false, NumPixels);
+	for (const int32 BoneIdx : State.DespawnedBones)
+	{
+		if (DespawningBones.IsValidIndex(BoneIdx))
+		{
+			DespawningBones[BoneIdx] = true;
+		}
+	}
+
+	// baking needs neither render targets nor the niagara system, only the (streamed) source mesh
+	const UNiagaraDestructionDriverDataAsset* DataAsset = NiagaraDestructionDriverParams;
+	if (GetDefault<UNiagaraDestructionDriverSettings>()->bBakeSettledDestructibles
+		&& DataAsset->InitialBoneLocations.Num() > 0 && DataAsset->BakedMaterials.Num() > 0 && !DataAsset->StaticMesh.IsNull())
+	{
+		if (DataAsset->StaticMesh.Get() == nullptr)
+		{
+			LoadStreamedAssets(FSimpleDelegate::CreateWeakLambda(this, [this]()
+			{
+				// not reset or woken up by a force in the meantime
+				if (bIsSettled && RestoredBonePositions.Num() > 0 && !BakeRestoredPose())
+				{
+					ActivateDestructible();
+				}
+			}));
+			return;
+		}
+		if (BakeRestoredPose())
+		{
+			return;
+		}
+	}
+
+	// the render targets get the pose as soon as they exist
+	if (bIsActivated)
+	{
+		ApplyRestoredPose();
+	}
+	else
+	{
+		ActivateDestructible();
+	}
+}
+
+void ANiagaraDestructionDriverActor::ApplyRestoredPose()
+{
+	SCOPE_CYCLE_COUNTER(STAT_NDD_RestoreState);
+	const double RestoreStartTime = FPlatformTime::Seconds();
+	ON_SCOPE_EXIT
+	{
+		LastRestoreTimeMs += static_cast<float>((FPlatformTime::Seconds() - RestoreStartTime) * 1000.0);
+	};
+
+	// the simulation would overwrite the pose with the initial bone locations
+	if (InstanceSlot != INDEX_NONE)
+	{
+		if (UNiagaraDestructionDriverInstancingSubsystem* Instancing = GetInstancing())
+		{
+			Instancing->SettleInstance(this);
+		}
+	}
+	else if (bUsesSharedSimulation)
+	{
+		if (UNiagaraDestructionDriverSharedSimulationSubsystem* SharedSimulation = GetSharedSimulation())
+		{
+			SharedSimulation->SettleRange(this);
+		}
+	}
+	else if (bNiagaraComponentIsPooled)
+	{
+		ReturnNiagaraComponent();
+	}
+	else if (NiagaraComponent)
+	{
+		NiagaraComponent->DeactivateImmediate();
+		NiagaraComponent->DestroyInstance();
+	}
+
+	ApplyBoundsScale(FMath::Min(ComputeBoundsScale(RestoredBonePositions) * 1.1f, GetDefault<UNiagaraDestructionDriverSettings>()->MaxDynamicBoundsScale), true);
+	UNiagaraDestructionDriverHelper::WriteRenderTargetRegion(PositionsTexture, GetSimulationRegion(PositionsTexture), RestoredBonePositions);
+	UNiagaraDestructionDriverHelper::WriteRenderTargetRegion(RotationsTexture, GetSimulationRegion(RotationsTexture), RestoredBoneRotations);
+	// kept as the settled pose, the next capture (streaming out again, a save) needs no readback.
+	// Woken up by a force in the meantime (WakeFromSettled), the queued force simulates the fragments again instead.
+	if (bIsSettled)
+	{
+		SettledBonePositions = MoveTemp(RestoredBonePositions);
+		SettledBoneRotations = MoveTemp(RestoredBoneRotations);
+	}
+	RestoredBonePositions.Empty();
+	RestoredBoneRotations.Empty();
+
+	// despawned fragments stay gone
+	if (BoneScaleMask)
+	{
+		for (TConstSetBitIterator<> It(DespawningBones); It; ++It)
+		{
+			if (BoneScales.IsValidIndex(It.GetIndex()))
+			{
+				BoneScales[It.GetIndex()] = 0;
+			}
+		}
+		UpdateBoneScaleMask();
+	}
+
+	ShowDestructibleMesh();
+	SetSourceGeometryVisible(false);
+}
+
+bool ANiagaraDestructionDriverActor::BakeRestoredPose()
+{
+	SCOPE_CYCLE_COUNTER(STAT_NDD_RestoreState);
+	const double RestoreStartTime = FPlatformTime::Seconds();
+	ON_SCOPE_EXIT
+	{
+		LastRestoreTimeMs += static_cast<float>((FPlatformTime::Seconds() - RestoreStartTime) * 1000.0);
+	};
+
+	UStaticMesh* BakedMesh = FNiagaraDestructionDriverMeshBaker::BakeStaticMesh(this, NiagaraDestructionDriverParams, RestoredBonePositions, RestoredBoneRotations, DespawningBones);
+	if (BakedMesh == nullptr)
+	{
+		return false;
+	}
+
+	// the baked mesh needs none of the render targets, WPO materials or streamed assets
+	DeactivateDestructible();
+	BakedStaticMesh = BakedMesh;
+	SettledBonePositions = MoveTemp(RestoredBonePositions);
+	SettledBoneRotations = MoveTemp(RestoredBoneRotations);
+	RestoredBonePositions.Empty();
+	RestoredBoneRotations.Empty();
+	MeshComponent->SetStaticMesh(BakedStaticMesh);
+	MeshComponent->SetVisibility(true, true);
+	return true;
+}
+
+bool ANiagaraDestructionDriverActor::SaveSnapshot(TArray<uint8>& OutSnapshot) const
+{
+	OutSnapshot.Reset();
+	FNiagaraDestructionDriverSavedState State;
+	if (CaptureState(State))
+	{
+		FNiagaraDestructionDriverSnapshot::Write(State, OutSnapshot);
+	}
+	LastSnapshotSizeBytes = OutSnapshot.Num();
+	return OutSnapshot.Num() > 0;
+}
+
+bool ANiagaraDestructionDriverActor::LoadSnapshot(const TArray<uint8>& Snapshot)
+{
+	FNiagaraDestructionDriverSavedState State;
+	if (Snapshot.Num() > 0 && !FNiagaraDestructionDriverSnapshot::Read(Snapshot, State))
+	{
+		UE_LOG(LogNiagaraDestructionDriver, Warning, TEXT("%s: ignoring malformed destruction snapshot (%d bytes)."), *GetName(), Snapshot.Num());
+		return false;
+	}
+
+	if (!HasActorBegunPlay())
+	{
+		PendingSavedState = MoveTemp(State);
+		bHasPendingSavedState = Snapshot.Num() > 0;
+		return true;
+	}
+
+	if (!bIsInRestingState)
+	{
+		ResetToRestingState();
+	}
+	if (Snapshot.Num() > 0)
+	{
+		RestoreState(State);
+	}
+	return true;
+}
+
+void ANiagaraDestructionDriverActor::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	// save games carry the destruction snapshot (the pose cached at settle time), never the render state
+	if (Ar.IsSaveGame() && !Ar.IsObjectReferenceCollector())
+	{
+		TArray<uint8> Snapshot;
+		if (Ar.IsSaving())
+		{
+			SaveSnapshot(Snapshot);
+		}
+		Ar << Snapshot;
+		if (Ar.IsLoading())
+		{
+			LoadSnapshot(Snapshot);
+		}
+	}
+}
+
+void ANiagaraDestructionDriverActor::ScheduleSettleCheck()
+{
+	const float SettleQuietTime = GetDefault<UNiagaraDestructionDriverSettings>()->SettleQuietTime;
+	if (SettleQuietTime <= 0.f)
+	{
+		return;
+	}
+	SettlePositionsSnapshot.Reset();
+	SettleReadback.Reset();
+	const float Delay = FMath::Max(LastForceEndTime + SettleQuietTime - GetWorld()->GetTimeSeconds(), KINDA_SMALL_NUMBER);
+	GetWorldTimerManager().SetTimer(SettleTimerHandle, this, &ANiagaraDestructionDriverActor::CheckSettled, Delay, false);
+}
+
+void ANiagaraDestructionDriverActor::CheckSettled()
+{
+	// the simulation hasn't even started yet, give it the full quiet time once it does
+	if (bIsLoadingAssets)
+	{
+		LastForceEndTime = GetWorld()->GetTimeSeconds();
+		ScheduleSettleCheck();
+		return;
+	}
+
+	const UNiagaraDestructionDriverSettings* Settings = GetDefault<UNiagaraDestructionDriverSettings>();
+	if (bIsHeadless || !bIsActivated || !Settings->bConfirmSettleWithVelocity || PositionsTexture == nullptr)
+	{
+		Settle();
+		return;
+	}
+
+	// sampled without stalling: each check collects the positions the previous one requested and requests the next
+	if (!SettleReadback.IsValid())
+	{
+		SettleReadback = MakeShared<FNiagaraDestructionDriverRegionReadback>();
+	}
+	TArray<FFloat16Color> Positions;
+	if (SettleReadback->Poll(Positions))
+	{
+		if (SettlePositionsSnapshot.Num() == Positions.Num() && SettleReadbackTime > SettlePositionsSnapshotTime)
+		{
+			// positions are stored in [-1,1] mesh local space, scale back to units
+			const FVector3f HalfExtents = FVector3f(NiagaraDestructionDriverParams->GetRuntimeContext().MeshHalfExtents);
+			float MaxDistanceSquared = 0.f;
+			for (int32 Idx = 0; Idx < Positions.Num(); Idx++)
+			{
+				const FVector3f Delta(
+					Positions[Idx].R.GetFloat() - SettlePositionsSnapshot[Idx].R.GetFloat(),
+					Positions[Idx].G.GetFloat() - SettlePositionsSnapshot[Idx].G.GetFloat(),
+					Positions[Idx].B.GetFloat() - SettlePositionsSnapshot[Idx].B.GetFloat());
+				MaxDistanceSquared = FMath::Max(MaxDistanceSquared, (Delta * HalfExtents).SizeSquared());
+			}
+			const float MaxSpeed = FMath::Sqrt(MaxDistanceSquared) / (SettleReadbackTime - SettlePositionsSnapshotTime);
+			if (MaxSpeed <= Settings->SettleVelocityThreshold)
+			{
+				Settle();
+				return;
+			}
+		}
+		SettlePositionsSnapshot = MoveTemp(Positions);
+		SettlePositionsSnapshotTime = SettleReadbackTime;
+	}
+
+	if (!SettleReadback->IsBusy())
+	{
+		// nothing to read back, settle like without the check
+		if (!SettleReadback->Request(PositionsTexture, GetSimulationRegion(PositionsTexture)))
+		{
+			Settle();
+			return;
+		}
+		SettleReadbackTime = GetWorld()->GetTimeSeconds();
+	}
+
+	// first sample, still moving or still on its way back, measure again in a bit
+	GetWorldTimerManager().SetTimer(SettleTimerHandle, this, &ANiagaraDestructionDriverActor::CheckSettled, Settings->SettleVelocityCheckInterval, false);
+}
+
+void ANiagaraDestructionDriverActor::Settle()
+{
+	bIsSettled = true;
+	GetWorldTimerManager().ClearTimer(SettleTimerHandle);
+	SettlePositionsSnapshot.Empty();
+	SettleReadback.Reset();
+	ExitSignificance();
+
+	if (!bIsHeadless)
+	{
+		// stop writing the render targets and free the system instance, the render targets keep showing the last pose.
+		// Instances only stop being simulated, the group pauses its system once none of them is.
+		// Pooled components go back to the pool.
+		if (InstanceSlot != INDEX_NONE)
+		{
+			if (UNiagaraDestructionDriverInstancingSubsystem* Instancing = GetInstancing())
+			{
+				Instancing->SettleInstance(this);
+			}
+		}
+		else if (bUsesSharedSimulation)
+		{
+			if (UNiagaraDestructionDriverSharedSimulationSubsystem* SharedSimulation = GetSharedSimulation())
+			{
+				SharedSimulation->SettleRange(this);
+			}
+		}
+		else if (bNiagaraComponentIsPooled)
+		{
+			ReturnNiagaraComponent();
+		}
+		else if (NiagaraComponent)
+		{
+			NiagaraComponent->DeactivateImmediate();
+			NiagaraComponent->DestroyInstance();
+		}
+
+		// kept for CaptureState and baked once it's back, many destructibles settling in the same frame must not each stall on a readback
+		if (bIsActivated)
+		{
+			ReadSettledPose();
+		}
+	}
+
+	OnSettled.Broadcast(this);
+}
+
+void ANiagaraDestructionDriverActor::WakeFromSettled()
+{
+	bIsSettled = false;
+	if (bIsHeadless)
+	{
+		return;
+	}
+
+	// settling left the significance subsystem at Full (a Baked tier included), pick the tier from scratch again
+	EnterSignificance();
+
+	// the pose we're about to leave must not be baked or captured anymore
+	CancelSettledPoseReadback();
+	if (BakedStaticMesh)
+	{
+		// the force activates us again (render targets, materials, simulation) and FinishActivation uploads the baked pose.
+		// The baked mesh stays up until then.
+		RestoredBonePositions = MoveTemp(SettledBonePositions);
+		RestoredBoneRotations = MoveTemp(SettledBoneRotations);
+		BakedStaticMesh = nullptr;
+	}
+
+	// otherwise the render targets still show the pose. Instance groups and shared simulations kept their particles and
+	// continue from it, a reactivated or borrowed niagara component respawns the fragments at their initial bone locations.
+	SettledBonePositions.Empty();
+	SettledBoneRotations.Empty();
+}
+
+void ANiagaraDestructionDriverActor::BakeSettledMesh()
+{
+	if (!FNiagaraDestructionDriverMeshBaker::CanBake(NiagaraDestructionDriverParams) || SettledBonePositions.Num() == 0 || SettledBoneRotations.Num() == 0)
+	{
+		return;
+	}
+
+	UStaticMesh* BakedMesh = FNiagaraDestructionDriverMeshBaker::BakeStaticMesh(this, NiagaraDestructionDriverParams, SettledBonePositions, SettledBoneRotations, DespawningBones);
+	if (BakedMesh == nullptr)
+	{
+		return;
+	}
+
+	// the baked mesh has real bounds and no render target, material or streamed asset dependencies
+	TArray<FFloat16Color> BonePositions = MoveTemp(SettledBonePositions);
+	TArray<FFloat16Color> BoneRotations = MoveTemp(SettledBoneRotations);
+	DeactivateDestructible();
+	BakedStaticMesh = BakedMesh;
+	SettledBonePositions = MoveTemp(BonePositions);
+	SettledBoneRotations = MoveTemp(BoneRotations);
+	MeshComponent->SetStaticMesh(BakedStaticMesh);
+	MeshComponent->SetVisibility(true, true);
+}
+
+void ANiagaraDestructionDriverActor::ReadSettledPose()
+{
+	CancelSettledPoseReadback();
+	SettledBonePositions.Empty();
+	SettledBoneRotations.Empty();
+	if (PositionsTexture == nullptr || RotationsTexture == nullptr)
+	{
+		return;
+	}
+
+	SettledPositionsReadback = MakeShared<FNiagaraDestructionDriverRegionReadback>();
+	SettledRotationsReadback = MakeShared<FNiagaraDestructionDriverRegionReadback>();
+	if (!SettledPositionsReadback->Request(PositionsTexture, GetSimulationRegion(PositionsTexture))
+		|| !SettledRotationsReadback->Request(RotationsTexture, GetSimulationRegion(RotationsTexture)))
+	{
+		CancelSettledPoseReadback();
+		return;
+	}
+	GetWorldTimerManager().SetTimer(SettledPoseTimerHandle, this, &ANiagaraDestructionDriverActor::PollSettledPose, 1.f / 30.f, true);
+}
+
+void ANiagaraDestructionDriverActor::PollSettledPose()
+{
+	if (!SettledPositionsReadback.IsValid() || !SettledRotationsReadback.IsValid())
+	{
+		CancelSettledPoseReadback();
+		return;
+	}
+
+	// each readback hands its pixels over once, keep the first until the other one is back as well
+	if (SettledPositionsReadback->IsBusy())
+	{
+		SettledPositionsReadback->Poll(SettledBonePositions);
+	}
+	if (SettledRotationsReadback->IsBusy())
+	{
+		SettledRotationsReadback->Poll(SettledBoneRotations);
+	}
+	if (SettledPositionsReadback->IsBusy() || SettledRotationsReadback->IsBusy())
+	{
+		return;
+	}
+
+	CancelSettledPoseReadback();
+	if (GetDefault<UNiagaraDestructionDriverSettings>()->bBakeSettledDestructibles)
+	{
+		BakeSettledMesh();
+	}
+}
+
+void ANiagaraDestructionDriverActor::CancelSettledPoseReadback()
+{
+	GetWorldTimerManager().ClearTimer(SettledPoseTimerHandle);
+	SettledPositionsReadback.Reset();
+	SettledRotationsReadback.Reset();
+}
+
+void ANiagaraDestructionDriverActor::StartFragmentDespawn()
+{
+	if ((!bIsActivated && BakedStaticMesh == nullptr) || bFragmentsDespawned)
+	{
+		return;
+	}
+
+	// pick the fragments small enough to go
+	const UNiagaraDestructionDriverDataAsset* DataAsset = NiagaraDestructionDriverParams;
+	const int32 NumBones = FMath::Max(DataAsset->BoneSizes.Num(), DataAsset->InitialBoneLocations.Num());
+	const float SizeThreshold = DataAsset->FragmentDespawnSizeThreshold;
+	const bool bDespawnAll = SizeThreshold <= 0.f;
+	DespawningBones.Init(bDespawnAll, FMath::Max(NumBones, BoneScales.Num()));
+	int32 NumDespawning = bDespawnAll ? DespawningBones.Num() : 0;
+	if (!bDespawnAll)
+	{
+		for (int32 BoneIdx = 0; BoneIdx < DataAsset->BoneSizes.Num(); BoneIdx++)
+		{
+			if (DataAsset->BoneSizes[BoneIdx] <= SizeThreshold)
+			{
+				DespawningBones[BoneIdx] = true;
+				NumDespawning++;
+			}
+		}
+	}
+	if (NumDespawning == 0)
+	{
+		return;
+	}
+
+	if (bDespawnAll || (DataAsset->BoneSizes.Num() > 0 && NumDespawning >= DataAsset->BoneSizes.Num()))
+	{
+		// shrink everything away (if we can), then drop the whole mesh
+		DespawningBones.Init(true, DespawningBones.Num());
+	}
+
+	if (BakedStaticMesh)
+	{
+		// baked materials can't shrink fragments, rebuild the mesh without them instead
+		if (DespawningBones.Find(false) == INDEX_NONE)
+		{
+			ReleaseDestroyedMesh();
+			return;
+		}
+		// the source mesh was let go after baking, rebake once it streamed back in
+		if (DataAsset->StaticMesh.Get() == nullptr)
+		{
+			LoadStreamedAssets(FSimpleDelegate::CreateWeakLambda(this, [this]()
+			{
+				if (BakedStaticMesh && NiagaraDestructionDriverParams->StaticMesh.Get())
+				{
+					StartFragmentDespawn();
+				}
+			}));
+			return;
+		}
+		BakedStaticMesh = FNiagaraDestructionDriverMeshBaker::BakeStaticMesh(this, DataAsset, SettledBonePositions, SettledBoneRotations, DespawningBones);
+		MeshComponent->SetStaticMesh(BakedStaticMesh);
+		ReleaseStreamedAssets();
+		return;
+	}
+
+	DespawnStartTime = GetWorld()->GetTimeSeconds();
+	UpdateFragmentDespawn();
+	if (!bFragmentsDespawned && DataAsset->FragmentShrinkDuration > 0.f)
+	{
+		GetWorldTimerManager().SetTimer(DespawnTimerHandle, this, &ANiagaraDestructionDriverActor::UpdateFragmentDespawn, 1.f / 30.f, true);
+	}
+}
+
+void ANiagaraDestructionDriverActor::UpdateFragmentDespawn()
+{
+	const float ShrinkDuration = NiagaraDestructionDriverParams->FragmentShrinkDuration;
+	const float Alpha = ShrinkDuration > 0.f ? FMath::Clamp((GetWorld()->GetTimeSeconds() - DespawnStartTime) / ShrinkDuration, 0.f, 1.f) : 1.f;
+	const uint8 Scale = static_cast<uint8>(FMath::RoundToInt((1.f - Alpha) * 255.f));
+	for (int32 BoneIdx = 0; BoneIdx < BoneScales.Num(); BoneIdx++)
+	{
+		if (DespawningBones.IsValidIndex(BoneIdx) && DespawningBones[BoneIdx])
+		{
+			BoneScales[BoneIdx] = Scale;
+		}
+	}
+	UpdateBoneScaleMask();
+
+	if (Alpha >= 1.f)
+	{
+		GetWorldTimerManager().ClearTimer(DespawnTimerHandle);
+		if (DespawningBones.Find(false) == INDEX_NONE)
+		{
+			ReleaseDestroyedMesh();
+		}
+	}
+}
+
+void ANiagaraDestructionDriverActor::UpdateBoneScaleMask()
+{
+	if (BoneScaleMask == nullptr || BoneScales.Num() == 0)
+	{
+		return;
+	}
+
+	// the render thread owns the copies until the upload is done
+	const int32 Size = BoneScaleMask->GetSizeX();
+	FUpdateTextureRegion2D* Region = new FUpdateTextureRegion2D(0, 0, 0, 0, Size, Size);
+	uint8* Data = static_cast<uint8*>(FMemory::Malloc(BoneScales.Num()));
+	FMemory::Memcpy(Data, BoneScales.GetData(), BoneScales.Num());
+	BoneScaleMask->UpdateTextureRegions(0, 1, Region, Size, 1, Data, [](uint8* SrcData, const FUpdateTextureRegion2D* Regions)
+	{
+		FMemory::Free(SrcData);
+		delete Regions;
+	});
+}
+
+void ANiagaraDestructionDriverActor::ReleaseDestroyedMesh()
+{
+	bFragmentsDespawned = true;
+	bIsSettled = true;
+	GetWorldTimerManager().ClearTimer(SettleTimerHandle);
+	GetWorldTimerManager().ClearTimer(DespawnTimerHandle);
+	ExitSignificance();
+	DeactivateDestructible();
+}
+
+FIntRect ANiagaraDestructionDriverActor::GetSimulationRegion(const UTextureRenderTarget2D* RenderTarget) const
+{
+	FIntPoint Origin = RenderTargetAtlasTile.IsValid() ? RenderTargetAtlasTile.Origin : FIntPoint::ZeroValue;
+	if (InstanceSlot != INDEX_NONE)
+	{
+		Origin = FIntPoint(FMath::RoundToInt32(RenderTargetTileOffsetScale.X * RenderTarget->SizeX), FMath::RoundToInt32(RenderTargetTileOffsetScale.Y * RenderTarget->SizeY));
+	}
+	const int32 Size = FMath::Min(NiagaraDestructionDriverParams->RenderTargetTextureSize, static_cast<int32>(RenderTarget->SizeX));
+	return FIntRect(Origin, Origin + FIntPoint(Size));
+}
+
+float ANiagaraDestructionDriverActor::ComputeBoundsScale(const TArray<FFloat16Color>& Positions) const
+{
+	// positions are stored in [-1,1] mesh local space around the mesh center, which is also where the bounds scale pivots
+	const UNiagaraDestructionDriverDataAsset* DataAsset = NiagaraDestructionDriverParams;
+	const FVector3f HalfExtents = FVector3f(NiagaraDestructionDriverParams->GetRuntimeContext().MeshHalfExtents);
+	const float FragmentRadius = DataAsset->BoneSizes.Num() > 0 ? 0.5f * FMath::Max(DataAsset->BoneSizes) : 0.f;
+	const int32 NumBones = DataAsset->BoneSizes.Num() > 0 ? FMath::Min(DataAsset->BoneSizes.Num(), Positions.Num()) : Positions.Num();
+	float BoundsScale = 1.f;
+	for (int32 BoneIdx = 0; BoneIdx < NumBones; BoneIdx++)
+	{
+		if (DespawningBones.IsValidIndex(BoneIdx) && DespawningBones[BoneIdx])
+		{
+			continue;
+		}
+		const FFloat16Color& Position = Positions[BoneIdx];
+		const float Offsets[3] = { FMath::Abs(Position.R.GetFloat()), FMath::Abs(Position.G.GetFloat()), FMath::Abs(Position.B.GetFloat()) };
+		for (int32 Axis = 0; Axis < 3; Axis++)
+		{
+			if (HalfExtents[Axis] > UE_KINDA_SMALL_NUMBER)
+			{
+				BoundsScale = FMath::Max(BoundsScale, (Offsets[Axis] * HalfExtents[Axis] + FragmentRadius) / HalfExtents[Axis]);
+			}
+		}
+	}
+	return BoundsScale;
+}
+
+void ANiagaraDestructionDriverActor::UpdateDynamicBounds()
+{
+	if (!BoundsReadback.IsValid())
+	{
+		StopDynamicBounds();
+		return;
+	}
+
+	TArray<FFloat16Color> Positions;
+	if (BoundsReadback->Poll(Positions))
+	{
+		// a little headroom so debris moving between readbacks doesn't pop out
+		const float BoundsScale = FMath::Min(ComputeBoundsScale(Positions) * 1.1f, GetDefault<UNiagaraDestructionDriverSettings>()->MaxDynamicBoundsScale);
+		ApplyBoundsScale(BoundsScale);
+
+		// settling may be off or far away, so also stop once the debris stopped spreading after the last force
+		const bool bBoundsStable = bBoundsReadbackAfterForces && LastBoundsSampleScale > 0.f
+			&& FMath::Abs(BoundsScale - LastBoundsSampleScale) <= 0.05f * LastBoundsSampleScale;
+		LastBoundsSampleScale = bBoundsReadbackAfterForces ? BoundsScale : 0.f;
+		if (bBoundsReadbackWhileSettled || bBoundsStable)
+		{
+			StopDynamicBounds();
+			return;
+		}
+	}
+
+	if (!BoundsReadback->IsBusy())
+	{
+		bBoundsReadbackWhileSettled = bIsSettled;
+		bBoundsReadbackAfterForces = GetWorld()->GetTimeSeconds() > LastForceEndTime;
+		if (PositionsTexture == nullptr || !BoundsReadback->Request(PositionsTexture, GetSimulationRegion(PositionsTexture)))
+		{
+			StopDynamicBounds();
+		}
+	}
+}
+
+void ANiagaraDestructionDriverActor::StartDynamicBounds()
+{
+	if (!GetDefault<UNiagaraDestructionDriverSettings>()->bUseDynamicBounds || BoundsReadback.IsValid())
+	{
+		return;
+	}
+
+	BoundsReadback = MakeShared<FNiagaraDestructionDriverRegionReadback>();
+	GetWorldTimerManager().SetTimer(DynamicBoundsTimerHandle, this, &ANiagaraDestructionDriverActor::UpdateDynamicBounds, GetDefault<UNiagaraDestructionDriverSettings>()->DynamicBoundsUpdateInterval, true);
+}
+
+void ANiagaraDestructionDriverActor::StopDynamicBounds()
+{
+	GetWorldTimerManager().ClearTimer(DynamicBoundsTimerHandle);
+	BoundsReadback.Reset();
+	bBoundsReadbackWhileSettled = false;
+	bBoundsReadbackAfterForces = false;
+	LastBoundsSampleScale = 0.f;
+}
+
+void ANiagaraDestructionDriverActor::ApplyBoundsScale(const float BoundsScale, const bool bForce)
+{
+	// small changes aren't worth a render state update
+	if (!bForce && FMath::Abs(BoundsScale - CurrentBoundsScale) <= 0.05f * CurrentBoundsScale)
+	{
+		return;
+	}
+
+	CurrentBoundsScale = BoundsScale;
+	if (InstanceSlot != INDEX_NONE)
+	{
+		if (UNiagaraDestructionDriverInstancingSubsystem* Instancing = GetInstancing())
+		{
+			Instancing->SetInstanceBoundsScale(this, BoundsScale);
+		}
+		return;
+	}
+	MeshComponent->SetBoundsScale(BoundsScale);
+	if (bMaterialsAreShared)
+	{
+		MeshComponent->SetCustomPrimitiveDataFloat(FNiagaraDestructionDriverPrimitiveData::ObjectBoundsScale, BoundsScale);
+		return;
+	}
+	const FName ObjectBoundsScaleName = FNiagaraDestructionDriverParameterNames::Get().ObjectBoundsScale;
+	for (UMaterialInstanceDynamic* DynamicMaterial : MeshMaterialsWithParamsSet)
+	{
+		DynamicMaterial->SetScalarParameterValue(ObjectBoundsScaleName, BoundsScale);
+	}
+}
+
+void ANiagaraDestructionDriverActor::ApplyActorRotation()
+{
+	const FQuat QuatRotation = GetActorRotation().Quaternion();
+	const FVector4 QuatVector = FVector4(QuatRotation.X, QuatRotation.Y, QuatRotation.Z, QuatRotation.W);
+	AppliedActorRotation = QuatRotation;
+	if (InstanceSlot != INDEX_NONE)
+	{
+		if (UNiagaraDestructionDriverInstancingSubsystem* Instancing = GetInstancing())
+		{
+			Instancing->UpdateInstanceTransform(this);
+		}
+		return;
+	}
+	if (bUsesSharedSimulation)
+	{
+		if (UNiagaraDestructionDriverSharedSimulationSubsystem* SharedSimulation = GetSharedSimulation())
+		{
+			SharedSimulation->UpdateRangeTransform(this);
+		}
+	}
+	if (bMaterialsAreShared)
+	{
+		MeshComponent->SetCustomPrimitiveDataVector4(FNiagaraDestructionDriverPrimitiveData::ActorRotationQuat, QuatVector);
+		return;
+	}
+	const FName ActorRotationQuatName = FNiagaraDestructionDriverParameterNames::Get().ActorRotationQuat;
+	for (UMaterialInstanceDynamic* DynamicMaterial : MeshMaterialsWithParamsSet)
+	{
+		DynamicMaterial->SetVectorParameterValue(ActorRotationQuatName, QuatVector);
+	}
+}
+
+void ANiagaraDestructionDriverActor::OnMeshTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	// instances don't move with us
+	if (InstanceSlot != INDEX_NONE)
+	{
+		ApplyActorRotation();
+		return;
+	}
+
+	// neither does our bone range
+	if (bUsesSharedSimulation)
+	{
+		if (UNiagaraDestructionDriverSharedSimulationSubsystem* SharedSimulation = GetSharedSimulation())
+		{
+			SharedSimulation->UpdateRangeTransform(this);
+		}
+	}
+
+	// fragment positions are local to the mesh, only a rotation changes what the materials need to know
+	if (MeshMaterialsWithParamsSet.Num() == 0 || GetActorQuat().Equals(AppliedActorRotation, UE_KINDA_SMALL_NUMBER))
+	{
+		return;
+	}
+	ApplyActorRotation();
+}
+
+void ANiagaraDestructionDriverActor::ReleaseMaterials()
+{
+	if (bMaterialsAreShared)
+	{
+		if (UNiagaraDestructionDriverMaterialCache* MaterialCache = GetWorld()->GetSubsystem<UNiagaraDestructionDriverMaterialCache>())
+		{
+			for (UMaterialInstanceDynamic* SharedMaterial : MeshMaterialsWithParamsSet)
+			{
+				MaterialCache->ReleaseMaterial(SharedMaterial);
+			}
+		}
+		bMaterialsAreShared = false;
+	}
+	MeshMaterialsWithParamsSet.Empty();
+}
+
+void ANiagaraDestructionDriverActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// keep what happened to us for when our level streams back in
+	if (EndPlayReason == EEndPlayReason::RemovedFromWorld)
+	{
+		if (UNiagaraDestructionDriverStreamingSubsystem* Streaming = GetWorld()->GetSubsystem<UNiagaraDestructionDriverStreamingSubsystem>())
+		{
+			Streaming->StoreState(this);
+		}
+	}
+
+	GetWorldTimerManager().ClearTimer(SettleTimerHandle);
+	GetWorldTimerManager().ClearTimer(DespawnTimerHandle);
+	StopDynamicBounds();
+	CancelSettledPoseReadback();
+	CancelScheduledHotSwap();
+	ExitSignificance();
+	if (TransformUpdatedHandle.IsValid())
+	{
+		MeshComponent->TransformUpdated.Remove(TransformUpdatedHandle);
+		TransformUpdatedHandle.Reset();
+	}
+	ReleaseMaterials();
+	ReleaseInstance();
+	if (BatchedSourceGeometry.Num() > 0)
+	{
+		SetSourceGeometryVisible(false);
+	}
+	ReleaseRenderTargets();
+	ReleaseStreamedAssets(true);
+	Super::EndPlay(EndPlayReason);
+}
+
+void ANiagaraDestructionDriverActor::AcquireRenderTargets()
+{
+	const int32 RenderTargetTextureSize = NiagaraDestructionDriverParams->RenderTargetTextureSize;
+
+	// try to get a tile in the shared world atlas first
+	if (GetDefault<UNiagaraDestructionDriverSettings>()->bUseRenderTargetAtlas)
+	{
+		if (UNiagaraDestructionDriverAtlasSubsystem* Atlas = GetWorld()->GetSubsystem<UNiagaraDestructionDriverAtlasSubsystem>())
+		{
+			if (Atlas->AcquireTile(RenderTargetTextureSize, RenderTargetAtlasTile))
+			{
+				PositionsTexture = Atlas->GetPositionsPage(RenderTargetAtlasTile);
+				RotationsTexture = Atlas->GetRotationsPage(RenderTargetAtlasTile);
+				RenderTargetTileOffsetScale = Atlas->GetTileOffsetScale(RenderTargetAtlasTile);
+				return;
+			}
+		}
+	}
+
+	// fall back to a dedicated pair of render targets for this actor
+	RenderTargetTileOffsetScale = FVector4(0.f, 0.f, 1.f, 1.f);
+	if (GetDefault<UNiagaraDestructionDriverSettings>()->bUseRenderTargetPool)
+	{
+		if (UNiagaraDestructionDriverRenderTargetPool* Pool = GetWorld()->GetSubsystem<UNiagaraDestructionDriverRenderTargetPool>())
+		{
+			RotationsTexture = Pool->AcquireRenderTarget(RenderTargetTextureSize);
+			PositionsTexture = Pool->AcquireRenderTarget(RenderTargetTextureSize);
+			bRenderTargetsArePooled = true;
+			return;
+		}
+	}
+	RotationsTexture = UNiagaraDestructionDriverHelper::CreateSimulationRenderTarget(nullptr, RenderTargetTextureSize);
+	PositionsTexture = UNiagaraDestructionDriverHelper::CreateSimulationRenderTarget(nullptr, RenderTargetTextureSize);
+}
+
+void ANiagaraDestructionDriverActor::ReleaseRenderTargets()
+{
+	// our bone range (or a borrowed niagara component) writes into the tile as well
+	ReleaseSharedSimulation();
+	ReturnNiagaraComponent();
+
+	// stop the simulation first so it no longer writes into render targets (or atlas tiles) that now belong to someone else
+	if (NiagaraComponent && (RenderTargetAtlasTile.IsValid() || bRenderTargetsArePooled))
+	{
+		NiagaraComponent->DeactivateImmediate();
+	}
+
+	if (RenderTargetAtlasTile.IsValid())
+	{
+		if (UNiagaraDestructionDriverAtlasSubsystem* Atlas = GetWorld()->GetSubsystem<UNiagaraDestructionDriverAtlasSubsystem>())
+		{
+			Atlas->ReleaseTile(RenderTargetAtlasTile);
+		}
+	}
+	else if (bRenderTargetsArePooled)
+	{
+		if (UNiagaraDestructionDriverRenderTargetPool* Pool = GetWorld()->GetSubsystem<UNiagaraDestructionDriverRenderTargetPool>())
+		{
+			Pool->ReleaseRenderTarget(PositionsTexture);
+			Pool->ReleaseRenderTarget(RotationsTexture);
+		}
+		bRenderTargetsArePooled = false;
+	}
+	PositionsTexture = nullptr;
+	RotationsTexture = nullptr;
+}
+
+SIZE_T ANiagaraDestructionDriverActor::GetRenderResourceSizeBytes() const
+{
+	SIZE_T TotalBytes = 0;
+	if (RenderTargetAtlasTile.IsValid() || InstanceSlot != INDEX_NONE)
+	{
+		// only count our share of the shared atlas (or instance group) pages
+		const double TileShare = RenderTargetTileOffsetScale.Z * RenderTargetTileOffsetScale.W;
+		for (const UTextureRenderTarget2D* Page : { PositionsTexture.Get(), RotationsTexture.Get() })
+		{
+			TotalBytes += Page ? static_cast<SIZE_T>(Page->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal) * TileShare) : 0;
+		}
+	}
+	else
+	{
+		for (const UTextureRenderTarget2D* RenderTarget : { PositionsTexture.Get(), RotationsTexture.Get() })
+		{
+			TotalBytes += RenderTarget ? RenderTarget->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal) : 0;
+		}
+	}
+	for (const UMaterialInstanceDynamic* DynamicMaterial : MeshMaterialsWithParamsSet)
+	{
+		TotalBytes += DynamicMaterial && !bMaterialsAreShared ? DynamicMaterial->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal) : 0;
+	}
+	if (NiagaraComponent && NiagaraComponent->GetAsset())
+	{
+		TotalBytes += NiagaraComponent->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+	}
+	return TotalBytes;
+}
+
+#if WITH_EDITOR
+void ANiagaraDestructionDriverActor::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	const FName PropertyName = PropertyChangedEvent.GetPropertyName();
+	if (PropertyName == GET_MEMBER_NAME_CHECKED(ANiagaraDestructionDriverActor, bTrackTransformChanges) && bTrackTransformChanges && RootComponent)
+	{
+		// tracking a static destructible would never fire
+		RootComponent->SetMobility(EComponentMobility::Movable);
+	}
 	if (PropertyName == GET_MEMBER_NAME_CHECKED(ANiagaraDestructionDriverActor, bDebugMaterial))
 	{
 		/*
@@ -0,0 +1,93 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverActorPool.h"
+
+#include "NiagaraDestructionDriverActor.h"
+#include "NiagaraDestructionDriverSettings.h"
+#include "Engine/World.h"
+
+ANiagaraDestructionDriverActor* UNiagaraDestructionDriverActorPool::SpawnDestructible(UNiagaraDestructionDriverDataAsset* DataAsset, const FTransform& Transform, TSubclassOf<ANiagaraDestructionDriverActor> DestructibleClass)
+{
+	if (DestructibleClass == nullptr)
+	{
+		DestructibleClass = ANiagaraDestructionDriverActor::StaticClass();
+	}
+
+	if (FNiagaraDestructionDriverActorBucket* Bucket = Buckets.Find(DataAsset))
+	{
+		for (int32 Idx = Bucket->FreeActors.Num() - 1; Idx >= 0; Idx--)
+		{
+			ANiagaraDestructionDriverActor* Destructible = Bucket->FreeActors[Idx];
+			if (!IsValid(Destructible))
+			{
+				// destroyed by someone else while pooled
+				Bucket->FreeActors.RemoveAtSwap(Idx);
+				continue;
+			}
+			if (Destructible->GetClass() != DestructibleClass)
+			{
+				continue;
+			}
+
+			Bucket->FreeActors.RemoveAtSwap(Idx);
+			Destructible->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+			Destructible->SetActorHiddenInGame(false);
+			Destructible->SetActorEnableCollision(true);
+			Destructible->ResetToRestingState();
+			return Destructible;
+		}
+	}
+
+	ANiagaraDestructionDriverActor* Destructible = GetWorld()->SpawnActorDeferred<ANiagaraDestructionDriverActor>(DestructibleClass, Transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	if (Destructible)
+	{
+		if (DataAsset)
+		{
+			Destructible->NiagaraDestructionDriverParams = DataAsset;
+		}
+		Destructible->FinishSpawning(Transform);
+	}
+	return Destructible;
+}
+
+void UNiagaraDestructionDriverActorPool::ReleaseDestructible(ANiagaraDestructionDriverActor* Destructible)
+{
+	if (!IsValid(Destructible) || Destructible->IsActorBeingDestroyed())
+	{
+		return;
+	}
+
+	FNiagaraDestructionDriverActorBucket& Bucket = Buckets.FindOrAdd(Destructible->NiagaraDestructionDriverParams);
+	if (Bucket.FreeActors.Contains(Destructible))
+	{
+		return;
+	}
+	if (Bucket.FreeActors.Num() >= GetDefault<UNiagaraDestructionDriverSettings>()->MaxPooledDestructiblesPerDataAsset)
+	{
+		Destructible->Destroy();
+		return;
+	}
+
+	// keep the materials and render targets, but stop simulating while pooled
+	Destructible->ResetToRestingState();
+	Destructible->SuspendSimulation();
+	Destructible->SetActorHiddenInGame(true);
+	Destructible->SetActorEnableCollision(false);
+	Bucket.FreeActors.Add(Destructible);
+}
+
+int32 UNiagaraDestructionDriverActorPool::GetNumFreeDestructibles() const
+{
+	int32 NumFree = 0;
+	for (const TPair<TObjectPtr<UNiagaraDestructionDriverDataAsset>, FNiagaraDestructionDriverActorBucket>& Bucket : Buckets)
+	{
+		NumFree += Bucket.Value.FreeActors.Num();
+	}
+	return NumFree;
+}
+
+bool UNiagaraDestructionDriverActorPool::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -0,0 +1,265 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverAssetLoader.h"
+
+#include "EngineUtils.h"
+#include "NiagaraDestructionDriver.h"
+#include "NiagaraDestructionDriverActor.h"
+#include "NiagaraDestructionDriverDataAsset.h"
+#include "Engine/AssetManager.h"
+#include "Engine/World.h"
+
+DECLARE_MEMORY_STAT(TEXT("NDD Resident Streamed Assets"), STAT_NDD_ResidentStreamedAssets, STATGROUP_NiagaraDestructionDriver);
+
+const FName UNiagaraDestructionDriverAssetLoader::DestructionBundleName = FName("Destruction");
+
+void UNiagaraDestructionDriverAssetLoader::RequestAssets(const TArray<FSoftObjectPath>& AssetPaths, FSimpleDelegate OnLoaded)
+{
+	TArray<FSoftObjectPath> MissingAssets;
+	for (const FSoftObjectPath& AssetPath : AssetPaths)
+	{
+		if (!AssetPath.IsNull() && AssetPath.ResolveObject() == nullptr)
+		{
+			MissingAssets.AddUnique(AssetPath);
+		}
+	}
+
+	if (MissingAssets.Num() == 0)
+	{
+		OnLoaded.ExecuteIfBound();
+		return;
+	}
+
+	const TSharedRef<FPendingRequest> Request = MakeShared<FPendingRequest>();
+	Request->NumOutstanding = MissingAssets.Num();
+	Request->OnLoaded = MoveTemp(OnLoaded);
+
+	FStreamableManager& StreamableManager = UAssetManager::GetStreamableManager();
+	for (const FSoftObjectPath& AssetPath : MissingAssets)
+	{
+		if (FPendingAsset* PendingAsset = PendingAssets.Find(AssetPath))
+		{
+			// someone already started loading this asset, just wait on it
+			PendingAsset->Requests.Add(Request);
+			Request->Handles.Add(PendingAsset->Handle);
+			continue;
+		}
+
+		PendingAssets.Add(AssetPath).Requests.Add(Request);
+		const TSharedPtr<FStreamableHandle> Handle = StreamableManager.RequestAsyncLoad(
+			AssetPath,
+			FStreamableDelegate::CreateUObject(this, &UNiagaraDestructionDriverAssetLoader::OnAssetLoaded, AssetPath),
+			FStreamableManager::AsyncLoadHighPriority);
+		Request->Handles.Add(Handle);
+
+		// the load may have completed synchronously and already removed the pending entry
+		if (FPendingAsset* PendingAsset = PendingAssets.Find(AssetPath))
+		{
+			PendingAsset->Handle = Handle;
+		}
+	}
+}
+
+void UNiagaraDestructionDriverAssetLoader::PreloadDataAssets(const TArray<UNiagaraDestructionDriverDataAsset*>& DataAssets)
+{
+	UAssetManager& AssetManager = UAssetManager::Get();
+	TArray<FSoftObjectPath> AssetPaths;
+	for (const UNiagaraDestructionDriverDataAsset* DataAsset : DataAssets)
+	{
+		if (DataAsset == nullptr)
+		{
+			continue;
+		}
+
+		// prefer the asset manager bundle if the data asset type is registered as a primary asset type
+		const FPrimaryAssetId PrimaryAssetId = DataAsset->GetPrimaryAssetId();
+		if (PrimaryAssetId.IsValid() && AssetManager.GetPrimaryAssetPath(PrimaryAssetId).IsValid())
+		{
+			if (TSharedPtr<FStreamableHandle> Handle = AssetManager.LoadPrimaryAsset(PrimaryAssetId, { DestructionBundleName }))
+			{
+				PreloadHandles.Add(Handle);
+			}
+			continue;
+		}
+
+		DataAsset->GetDestructionAssetPaths(AssetPaths);
+	}
+
+	if (AssetPaths.Num() > 0)
+	{
+		if (TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(AssetPaths, FStreamableDelegate(), FStreamableManager::DefaultAsyncLoadPriority, true))
+		{
+			PreloadHandles.Add(Handle);
+		}
+	}
+}
+
+void UNiagaraDestructionDriverAssetLoader::RetainStreamedAssets(UNiagaraDestructionDriverDataAsset* DataAsset)
+{
+	if (DataAsset == nullptr)
+	{
+		return;
+	}
+	FRetainedAssets& Retained = RetainedAssets.FindOrAdd(DataAsset);
+	if (Retained.NumRetains++ > 0)
+	{
+		return;
+	}
+
+	TArray<FSoftObjectPath> AssetPaths;
+	DataAsset->GetStreamedAssetPaths(AssetPaths);
+	if (AssetPaths.Num() == 0)
+	{
+		return;
+	}
+
+	// the handle is what keeps them resident, it completes right away if they are already loaded
+	const TSharedPtr<FStreamableHandle> Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+		AssetPaths,
+		FStreamableDelegate::CreateUObject(this, &UNiagaraDestructionDriverAssetLoader::OnStreamedAssetsLoaded, TWeakObjectPtr<UNiagaraDestructionDriverDataAsset>(DataAsset)),
+		FStreamableManager::DefaultAsyncLoadPriority);
+	if (FRetainedAssets* RetainedAfterLoad = RetainedAssets.Find(DataAsset))
+	{
+		RetainedAfterLoad->Handle = Handle;
+	}
+}
+
+void UNiagaraDestructionDriverAssetLoader::ReleaseStreamedAssets(UNiagaraDestructionDriverDataAsset* DataAsset)
+{
+	FRetainedAssets* Retained = DataAsset ? RetainedAssets.Find(DataAsset) : nullptr;
+	if (Retained == nullptr || --Retained->NumRetains > 0)
+	{
+		return;
+	}
+
+	// still loading handles are released once they complete
+	if (Retained->Handle.IsValid())
+	{
+		Retained->Handle->ReleaseHandle();
+	}
+	DEC_MEMORY_STAT_BY(STAT_NDD_ResidentStreamedAssets, Retained->ResidentBytes);
+	RetainedAssets.Remove(DataAsset);
+
+	// the shared runtime context would keep them alive otherwise
+	DataAsset->ReleaseStreamedAssets();
+}
+
+void UNiagaraDestructionDriverAssetLoader::OnStreamedAssetsLoaded(TWeakObjectPtr<UNiagaraDestructionDriverDataAsset> WeakDataAsset)
+{
+	const UNiagaraDestructionDriverDataAsset* DataAsset = WeakDataAsset.Get();
+	FRetainedAssets* Retained = DataAsset ? RetainedAssets.Find(DataAsset) : nullptr;
+	if (Retained == nullptr || Retained->ResidentBytes > 0)
+	{
+		return;
+	}
+	Retained->ResidentBytes = DataAsset->GetStreamedAssetSizeBytes();
+	KnownStreamedAssetBytes.Add(DataAsset, Retained->ResidentBytes);
+	INC_MEMORY_STAT_BY(STAT_NDD_ResidentStreamedAssets, Retained->ResidentBytes);
+}
+
+void UNiagaraDestructionDriverAssetLoader::DumpStreamingStats(UWorld* World) const
+{
+	if (World == nullptr)
+	{
+		return;
+	}
+
+	// every data asset placed in this world, with the number of destructibles using it
+	TMap<UNiagaraDestructionDriverDataAsset*, int32> PlacedDataAssets;
+	for (TActorIterator<ANiagaraDestructionDriverActor> It(World); It; ++It)
+	{
+		if (It->NiagaraDestructionDriverParams)
+		{
+			PlacedDataAssets.FindOrAdd(It->NiagaraDestructionDriverParams)++;
+		}
+	}
+
+	int32 NumResident = 0;
+	int32 NumNeverLoaded = 0;
+	SIZE_T ResidentBytes = 0;
+	SIZE_T ReleasedBytes = 0;
+	for (const TPair<UNiagaraDestructionDriverDataAsset*, int32>& PlacedDataAsset : PlacedDataAssets)
+	{
+		const FRetainedAssets* Retained = RetainedAssets.Find(PlacedDataAsset.Key);
+		const SIZE_T* KnownBytes = KnownStreamedAssetBytes.Find(PlacedDataAsset.Key);
+		if (Retained)
+		{
+			NumResident++;
+			ResidentBytes += Retained->ResidentBytes;
+		}
+		else if (KnownBytes)
+		{
+			ReleasedBytes += *KnownBytes;
+		}
+		else
+		{
+			NumNeverLoaded++;
+		}
+		UE_LOG(LogNiagaraDestructionDriver, Log, TEXT("  %s: %d destructibles, %d retains, %s (%.2f KB)"),
+			*PlacedDataAsset.Key->GetName(),
+			PlacedDataAsset.Value,
+			Retained ? Retained->NumRetains : 0,
+			Retained ? TEXT("resident") : KnownBytes ? TEXT("released") : TEXT("never loaded"),
+			(Retained ? Retained->ResidentBytes : KnownBytes ? *KnownBytes : 0) / 1024.0);
+	}
+	UE_LOG(LogNiagaraDestructionDriver, Log, TEXT("Streamed destructible assets: %d of %d data assets resident, %.2f KB resident, %.2f KB released, %d never loaded (size unknown)."),
+		NumResident, PlacedDataAssets.Num(), ResidentBytes / 1024.0, ReleasedBytes / 1024.0, NumNeverLoaded);
+}
+
+void UNiagaraDestructionDriverAssetLoader::Deinitialize()
+{
+	for (TPair<FSoftObjectPath, FPendingAsset>& PendingAsset : PendingAssets)
+	{
+		if (PendingAsset.Value.Handle.IsValid())
+		{
+			PendingAsset.Value.Handle->CancelHandle();
+		}
+	}
+	PendingAssets.Empty();
+
+	for (const TSharedPtr<FStreamableHandle>& Handle : PreloadHandles)
+	{
+		Handle->ReleaseHandle();
+	}
+	PreloadHandles.Empty();
+
+	for (TPair<TObjectKey<UNiagaraDestructionDriverDataAsset>, FRetainedAssets>& Retained : RetainedAssets)
+	{
+		if (Retained.Value.Handle.IsValid())
+		{
+			Retained.Value.Handle->ReleaseHandle();
+		}
+		DEC_MEMORY_STAT_BY(STAT_NDD_ResidentStreamedAssets, Retained.Value.ResidentBytes);
+		if (UNiagaraDestructionDriverDataAsset* DataAsset = Retained.Key.ResolveObjectPtr())
+		{
+			DataAsset->ReleaseStreamedAssets();
+		}
+	}
+	RetainedAssets.Empty();
+	KnownStreamedAssetBytes.Empty();
+
+	Super::Deinitialize();
+}
+
+void UNiagaraDestructionDriverAssetLoader::OnAssetLoaded(FSoftObjectPath AssetPath)
+{
+	FPendingAsset PendingAsset;
+	if (!PendingAssets.RemoveAndCopyValue(AssetPath, PendingAsset))
+	{
+		return;
+	}
+
+	if (AssetPath.ResolveObject() == nullptr)
+	{
+		UE_LOG(LogNiagaraDestructionDriver, Warning, TEXT("Failed to load niagara destruction driver asset %s."), *AssetPath.ToString());
+	}
+
+	for (const TSharedRef<FPendingRequest>& Request : PendingAsset.Requests)
+	{
+		if (--Request->NumOutstanding == 0)
+		{
+			Request->OnLoaded.ExecuteIfBound();
+		}
+	}
+}
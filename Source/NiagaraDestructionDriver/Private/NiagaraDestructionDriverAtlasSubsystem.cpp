@@ -0,0 +1,258 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverAtlasSubsystem.h"
+
+#include "CanvasItem.h"
+#include "NiagaraDestructionDriver.h"
+#include "NiagaraDestructionDriverHelper.h"
+#include "NiagaraDestructionDriverSettings.h"
+#include "Engine/Canvas.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Kismet/KismetRenderingLibrary.h"
+
+bool UNiagaraDestructionDriverAtlasSubsystem::AcquireTile(const int32 RequestedSize, FNiagaraDestructionDriverAtlasTile& OutTile)
+{
+	const UNiagaraDestructionDriverSettings* Settings = GetDefault<UNiagaraDestructionDriverSettings>();
+	if (PageSize == 0)
+	{
+		PageSize = FMath::RoundUpToPowerOfTwo(FMath::Max(Settings->AtlasPageSize, 1));
+	}
+
+	const int32 TileSize = FMath::RoundUpToPowerOfTwo(FMath::Max(RequestedSize, 1));
+	if (TileSize > PageSize)
+	{
+		UE_LOG(LogNiagaraDestructionDriver, Warning, TEXT("Render target tile of size %d does not fit in atlas pages of size %d."), TileSize, PageSize);
+		return false;
+	}
+
+	const int32 Level = FMath::FloorLog2(TileSize);
+	for (int32 PageIndex = 0; PageIndex <= Pages.Num(); PageIndex++)
+	{
+		if (PageIndex == Pages.Num())
+		{
+			if (Pages.Num() >= Settings->MaxAtlasPages)
+			{
+				UE_LOG(LogNiagaraDestructionDriver, Warning, TEXT("Render target atlas is full (%d pages). Increase AtlasPageSize or MaxAtlasPages in the plugin settings."), Pages.Num());
+				return false;
+			}
+			AddPage();
+		}
+
+		FIntPoint Origin;
+		if (AllocateFromPage(Pages[PageIndex], Level, Origin))
+		{
+			Pages[PageIndex].NumTiles++;
+			Pages[PageIndex].UsedTexels += static_cast<int64>(TileSize) * TileSize;
+
+			OutTile.PageIndex = PageIndex;
+			OutTile.Origin = Origin;
+			OutTile.Size = TileSize;
+			ClearTile(OutTile);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void UNiagaraDestructionDriverAtlasSubsystem::ReleaseTile(FNiagaraDestructionDriverAtlasTile& Tile)
+{
+	if (Tile.IsValid() && Pages.IsValidIndex(Tile.PageIndex))
+	{
+		FAtlasPage& Page = Pages[Tile.PageIndex];
+		FreeToPage(Page, FMath::FloorLog2(Tile.Size), Tile.Origin);
+		Page.NumTiles--;
+		Page.UsedTexels -= static_cast<int64>(Tile.Size) * Tile.Size;
+	}
+	Tile = FNiagaraDestructionDriverAtlasTile();
+}
+
+UTextureRenderTarget2D* UNiagaraDestructionDriverAtlasSubsystem::GetPositionsPage(const FNiagaraDestructionDriverAtlasTile& Tile) const
+{
+	return PositionsPages.IsValidIndex(Tile.PageIndex) ? PositionsPages[Tile.PageIndex].Get() : nullptr;
+}
+
+UTextureRenderTarget2D* UNiagaraDestructionDriverAtlasSubsystem::GetRotationsPage(const FNiagaraDestructionDriverAtlasTile& Tile) const
+{
+	return RotationsPages.IsValidIndex(Tile.PageIndex) ? RotationsPages[Tile.PageIndex].Get() : nullptr;
+}
+
+FVector4 UNiagaraDestructionDriverAtlasSubsystem::GetTileOffsetScale(const FNiagaraDestructionDriverAtlasTile& Tile) const
+{
+	if (!Tile.IsValid() || PageSize == 0)
+	{
+		return FVector4(0.f, 0.f, 1.f, 1.f);
+	}
+	const double InvPageSize = 1.0 / PageSize;
+	return FVector4(Tile.Origin.X * InvPageSize, Tile.Origin.Y * InvPageSize, Tile.Size * InvPageSize, Tile.Size * InvPageSize);
+}
+
+FNiagaraDestructionDriverAtlasStats UNiagaraDestructionDriverAtlasSubsystem::GetAtlasStats() const
+{
+	FNiagaraDestructionDriverAtlasStats Stats;
+	Stats.NumPages = Pages.Num();
+
+	int64 FreeTexels = 0;
+	for (const FAtlasPage& Page : Pages)
+	{
+		Stats.NumTiles += Page.NumTiles;
+		Stats.UsedTexels += Page.UsedTexels;
+		Stats.TotalTexels += static_cast<int64>(PageSize) * PageSize;
+		for (int32 Level = 0; Level < Page.FreeBlocks.Num(); Level++)
+		{
+			if (Page.FreeBlocks[Level].Num() > 0)
+			{
+				const int64 BlockSize = 1ll << Level;
+				FreeTexels += Page.FreeBlocks[Level].Num() * BlockSize * BlockSize;
+				Stats.LargestFreeTileSize = FMath::Max(Stats.LargestFreeTileSize, static_cast<int32>(BlockSize));
+			}
+		}
+	}
+
+	if (Stats.TotalTexels > 0)
+	{
+		Stats.Occupancy = static_cast<float>(static_cast<double>(Stats.UsedTexels) / Stats.TotalTexels);
+	}
+	if (FreeTexels > 0)
+	{
+		const double LargestFreeTexels = static_cast<double>(Stats.LargestFreeTileSize) * Stats.LargestFreeTileSize;
+		Stats.Fragmentation = static_cast<float>(1.0 - LargestFreeTexels / FreeTexels);
+	}
+	return Stats;
+}
+
+void UNiagaraDestructionDriverAtlasSubsystem::DumpAtlasStats() const
+{
+	const FNiagaraDestructionDriverAtlasStats Stats = GetAtlasStats();
+	UE_LOG(LogNiagaraDestructionDriver, Display, TEXT("Render target atlas: %d pages of %dx%d, %d tiles, %lld/%lld texels used (occupancy %.1f%%, fragmentation %.1f%%, largest free tile %d)"),
+			Stats.NumPages,
+			PageSize,
+			PageSize,
+			Stats.NumTiles,
+			Stats.UsedTexels,
+			Stats.TotalTexels,
+			Stats.Occupancy * 100.f,
+			Stats.Fragmentation * 100.f,
+			Stats.LargestFreeTileSize);
+}
+
+void UNiagaraDestructionDriverAtlasSubsystem::Deinitialize()
+{
+	Pages.Empty();
+	PositionsPages.Empty();
+	RotationsPages.Empty();
+	Super::Deinitialize();
+}
+
+bool UNiagaraDestructionDriverAtlasSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// nothing to hand out on dedicated servers / -nullrhi
+	return Super::ShouldCreateSubsystem(Outer) && UNiagaraDestructionDriverHelper::ShouldCreateRenderResources(Outer);
+}
+
+bool UNiagaraDestructionDriverAtlasSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UNiagaraDestructionDriverAtlasSubsystem::AllocateFromPage(FAtlasPage& Page, const int32 Level, FIntPoint& OutOrigin) const
+{
+	// find the smallest free block that can hold the tile
+	int32 SearchLevel = Level;
+	while (SearchLevel < Page.FreeBlocks.Num() && Page.FreeBlocks[SearchLevel].Num() == 0)
+	{
+		SearchLevel++;
+	}
+	if (SearchLevel >= Page.FreeBlocks.Num())
+	{
+		return false;
+	}
+
+	// split it into quadrants until it is the requested size, the unused quadrants go back to the free lists
+	FIntPoint Block = Page.FreeBlocks[SearchLevel].Pop();
+	while (SearchLevel > Level)
+	{
+		SearchLevel--;
+		const int32 Half = 1 << SearchLevel;
+		Page.FreeBlocks[SearchLevel].Add(Block + FIntPoint(Half, 0));
+		Page.FreeBlocks[SearchLevel].Add(Block + FIntPoint(0, Half));
+		Page.FreeBlocks[SearchLevel].Add(Block + FIntPoint(Half, Half));
+	}
+
+	OutOrigin = Block;
+	return true;
+}
+
+void UNiagaraDestructionDriverAtlasSubsystem::FreeToPage(FAtlasPage& Page, const int32 Level, const FIntPoint Origin) const
+{
+	// merge back with the three sibling quadrants when all of them are free
+	if (Level + 1 < Page.FreeBlocks.Num())
+	{
+		const int32 BlockSize = 1 << Level;
+		const int32 ParentMask = ~((BlockSize << 1) - 1);
+		const FIntPoint Parent(Origin.X & ParentMask, Origin.Y & ParentMask);
+		const FIntPoint Siblings[4] = {
+			Parent,
+			Parent + FIntPoint(BlockSize, 0),
+			Parent + FIntPoint(0, BlockSize),
+			Parent + FIntPoint(BlockSize, BlockSize)
+		};
+
+		TArray<FIntPoint>& FreeList = Page.FreeBlocks[Level];
+		bool bAllSiblingsFree = true;
+		for (const FIntPoint& Sibling : Siblings)
+		{
+			if (Sibling != Origin && !FreeList.Contains(Sibling))
+			{
+				bAllSiblingsFree = false;
+				break;
+			}
+		}
+
+		if (bAllSiblingsFree)
+		{
+			for (const FIntPoint& Sibling : Siblings)
+			{
+				FreeList.RemoveSingleSwap(Sibling);
+			}
+			FreeToPage(Page, Level + 1, Parent);
+			return;
+		}
+	}
+
+	Page.FreeBlocks[Level].Add(Origin);
+}
+
+int32 UNiagaraDestructionDriverAtlasSubsystem::AddPage()
+{
+	FAtlasPage& Page = Pages.AddDefaulted_GetRef();
+	const int32 PageLevel = FMath::FloorLog2(PageSize);
+	Page.FreeBlocks.SetNum(PageLevel + 1);
+	Page.FreeBlocks[PageLevel].Add(FIntPoint::ZeroValue);
+
+	PositionsPages.Add(UNiagaraDestructionDriverHelper::CreateSimulationRenderTarget(this, PageSize));
+	RotationsPages.Add(UNiagaraDestructionDriverHelper::CreateSimulationRenderTarget(this, PageSize));
+
+	UE_LOG(LogNiagaraDestructionDriver, Log, TEXT("Added render target atlas page %d (%dx%d)."), Pages.Num() - 1, PageSize, PageSize);
+	return Pages.Num() - 1;
+}
+
+void UNiagaraDestructionDriverAtlasSubsystem::ClearTile(const FNiagaraDestructionDriverAtlasTile& Tile)
+{
+	// a recycled tile still holds the bone transforms of its previous owner, so paint it black before handing it out
+	for (UTextureRenderTarget2D* Page : { GetPositionsPage(Tile), GetRotationsPage(Tile) })
+	{
+		UCanvas* Canvas = nullptr;
+		FVector2D CanvasSize;
+		FDrawToRenderTargetContext Context;
+		UKismetRenderingLibrary::BeginDrawCanvasToRenderTarget(this, Page, Canvas, CanvasSize, Context);
+		if (Canvas)
+		{
+			FCanvasTileItem TileItem(FVector2D(Tile.Origin), FVector2D(Tile.Size, Tile.Size), FLinearColor::Black);
+			TileItem.BlendMode = SE_BLEND_Opaque;
+			Canvas->DrawItem(TileItem);
+		}
+		UKismetRenderingLibrary::EndDrawCanvasToRenderTarget(this, Context);
+	}
+}
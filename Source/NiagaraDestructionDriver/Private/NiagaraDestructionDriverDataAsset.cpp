@@ -2,6 +2,8 @@
 
 #include "NiagaraDestructionDriverDataAsset.h"
 #include "NiagaraDestructionDriverSettings.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/Texture2D.h"
 
 UNiagaraDestructionDriverDataAsset::UNiagaraDestructionDriverDataAsset()
 {
@@ -10,3 +12,86 @@ UNiagaraDestructionDriverDataAsset::UNiagaraDestructionDriverDataAsset()
 		ParticleSystemDriver = Settings->DefaultNiagaraParticleSystem;
 	}
 }
+
+void UNiagaraDestructionDriverDataAsset::GetDestructionAssetPaths(TArray<FSoftObjectPath>& OutAssetPaths) const
+{
+	if (!ParticleSystemDriver.IsNull())
+	{
+		OutAssetPaths.AddUnique(ParticleSystemDriver.ToSoftObjectPath());
+	}
+	GetStreamedAssetPaths(OutAssetPaths);
+}
+
+void UNiagaraDestructionDriverDataAsset::GetStreamedAssetPaths(TArray<FSoftObjectPath>& OutAssetPaths) const
+{
+	if (!StaticMesh.IsNull())
+	{
+		OutAssetPaths.AddUnique(StaticMesh.ToSoftObjectPath());
+	}
+	if (!InitialBoneLocationsTexture.IsNull())
+	{
+		OutAssetPaths.AddUnique(InitialBoneLocationsTexture.ToSoftObjectPath());
+	}
+}
+
+SIZE_T UNiagaraDestructionDriverDataAsset::GetStreamedAssetSizeBytes() const
+{
+	SIZE_T TotalBytes = 0;
+	if (UStaticMesh* Mesh = StaticMesh.Get())
+	{
+		TotalBytes += Mesh->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+	}
+	if (UTexture2D* Texture = InitialBoneLocationsTexture.Get())
+	{
+		TotalBytes += Texture->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+	}
+	return TotalBytes;
+}
+
+float UNiagaraDestructionDriverDataAsset::GetFragmentLifetime() const
+{
+	const UNiagaraDestructionDriverSettings* Settings = GetDefault<UNiagaraDestructionDriverSettings>();
+	const float Lifetime = FragmentLifetime > 0.f ? FragmentLifetime : Settings->DefaultFragmentLifetime;
+	if (Settings->MaxFragmentLifetime > 0.f)
+	{
+		return Lifetime > 0.f ? FMath::Min(Lifetime, Settings->MaxFragmentLifetime) : Settings->MaxFragmentLifetime;
+	}
+	return Lifetime;
+}
+
+const FNiagaraDestructionDriverRuntimeContext& UNiagaraDestructionDriverDataAsset::GetRuntimeContext()
+{
+	// the mesh streams in and out, until it's back the context stays invalid (but keeps the niagara system)
+	if (StaticMesh.Get() == nullptr)
+	{
+		return RuntimeContext;
+	}
+
+	// also rebuild if the context was built before the niagara system finished loading
+	if (!RuntimeContext.IsValid() || (RuntimeContext.ParticleSystem == nullptr && ParticleSystemDriver.Get() != nullptr))
+	{
+		RuntimeContext = FNiagaraDestructionDriverRuntimeContext::Build(this);
+	}
+	return RuntimeContext;
+}
+
+void UNiagaraDestructionDriverDataAsset::InvalidateRuntimeContext()
+{
+	RuntimeContext = FNiagaraDestructionDriverRuntimeContext();
+}
+
+void UNiagaraDestructionDriverDataAsset::ReleaseStreamedAssets()
+{
+	RuntimeContext.StaticMesh = nullptr;
+	RuntimeContext.InitialBoneLocationsTexture = nullptr;
+	RuntimeContext.SlotMaterials.Empty();
+	RuntimeContext.bIsValid = false;
+}
+
+#if WITH_EDITOR
+void UNiagaraDestructionDriverDataAsset::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	InvalidateRuntimeContext();
+}
+#endif
@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverEntitySpawner.h"
+
+#include "EngineUtils.h"
+#include "NiagaraDestructionDriverActor.h"
+#include "NiagaraDestructionDriverEntitySubsystem.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/World.h"
+
+ANiagaraDestructionDriverEntitySpawner::ANiagaraDestructionDriverEntitySpawner()
+{
+	PrimaryActorTick.bCanEverTick = false;
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("RootSceneComponent"));
+}
+
+#if WITH_EDITOR
+void ANiagaraDestructionDriverEntitySpawner::GatherDestructiblesInLevel()
+{
+	TArray<ANiagaraDestructionDriverActor*> GatheredActors;
+	for (TActorIterator<ANiagaraDestructionDriverActor> It(GetWorld()); It; ++It)
+	{
+		TArray<const UStaticMeshComponent*> Templates;
+		TArray<FTransform> RelativeTransforms;
+		UNiagaraDestructionDriverEntitySubsystem::GetProxyTemplates(It->GetClass(), Templates, RelativeTransforms);
+		if (It->GetLevel() == GetLevel() && Templates.Num() > 0)
+		{
+			GatheredActors.Add(*It);
+		}
+	}
+	if (GatheredActors.Num() == 0)
+	{
+		return;
+	}
+
+	Modify();
+	for (ANiagaraDestructionDriverActor* Destructible : GatheredActors)
+	{
+		FNiagaraDestructionDriverEntityPlacement& Placement = Destructibles.AddDefaulted_GetRef();
+		Placement.DestructibleClass = Destructible->GetClass();
+		if (Destructible->NiagaraDestructionDriverParams != Destructible->GetClass()->GetDefaultObject<ANiagaraDestructionDriverActor>()->NiagaraDestructionDriverParams)
+		{
+			Placement.DataAsset = Destructible->NiagaraDestructionDriverParams;
+		}
+		Placement.Transform = Destructible->GetActorTransform().GetRelativeTransform(GetActorTransform());
+		GetWorld()->EditorDestroyActor(Destructible, true);
+	}
+	RerunConstructionScripts();
+}
+#endif
+
+void ANiagaraDestructionDriverEntitySpawner::OnConstruction(const FTransform& Transform)
+{
+	Super::OnConstruction(Transform);
+
+#if WITH_EDITOR
+	// editor preview only, in game the entity subsystem batches the meshes of every spawner
+	if (GetWorld() == nullptr || GetWorld()->IsGameWorld())
+	{
+		return;
+	}
+
+	TMap<const UStaticMeshComponent*, UInstancedStaticMeshComponent*> PreviewComponents;
+	for (const FNiagaraDestructionDriverEntityPlacement& Placement : Destructibles)
+	{
+		TArray<const UStaticMeshComponent*> Templates;
+		TArray<FTransform> RelativeTransforms;
+		UNiagaraDestructionDriverEntitySubsystem::GetProxyTemplates(Placement.DestructibleClass, Templates, RelativeTransforms);
+		for (int32 Idx = 0; Idx < Templates.Num(); Idx++)
+		{
+			UInstancedStaticMeshComponent*& PreviewComponent = PreviewComponents.FindOrAdd(Templates[Idx]);
+			if (PreviewComponent == nullptr)
+			{
+				// construction script components are cleaned up when the construction script reruns
+				PreviewComponent = NewObject<UInstancedStaticMeshComponent>(this, NAME_None, RF_Transient);
+				PreviewComponent->CreationMethod = EComponentCreationMethod::UserConstructionScript;
+				PreviewComponent->bIsEditorOnly = true;
+				PreviewComponent->SetStaticMesh(Templates[Idx]->GetStaticMesh());
+				for (int32 MaterialIdx = 0; MaterialIdx < Templates[Idx]->OverrideMaterials.Num(); MaterialIdx++)
+				{
+					PreviewComponent->SetMaterial(MaterialIdx, Templates[Idx]->OverrideMaterials[MaterialIdx]);
+				}
+				PreviewComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+				PreviewComponent->SetupAttachment(RootComponent);
+				PreviewComponent->RegisterComponent();
+			}
+			PreviewComponent->AddInstance(RelativeTransforms[Idx] * Placement.Transform);
+		}
+	}
+#endif
+}
+
+void ANiagaraDestructionDriverEntitySpawner::BeginPlay()
+{
+	Super::BeginPlay();
+
+	UNiagaraDestructionDriverEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UNiagaraDestructionDriverEntitySubsystem>();
+	if (EntitySubsystem == nullptr)
+	{
+		return;
+	}
+	SpawnedEntities.Reserve(Destructibles.Num());
+	for (const FNiagaraDestructionDriverEntityPlacement& Placement : Destructibles)
+	{
+		const FMassEntityHandle Entity = EntitySubsystem->AddEntity(Placement.DestructibleClass, Placement.DataAsset, Placement.Transform * GetActorTransform());
+		if (Entity.IsSet())
+		{
+			SpawnedEntities.Add(Entity);
+		}
+	}
+}
+
+void ANiagaraDestructionDriverEntitySpawner::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// promoted destructibles live in the persistent level, they go with the spawner's level too
+	if (UNiagaraDestructionDriverEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UNiagaraDestructionDriverEntitySubsystem>())
+	{
+		for (const FMassEntityHandle Entity : SpawnedEntities)
+		{
+			EntitySubsystem->RemoveEntity(Entity);
+		}
+	}
+	SpawnedEntities.Empty();
+
+	Super::EndPlay(EndPlayReason);
+}
@@ -0,0 +1,304 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverEntitySubsystem.h"
+
+#include "MassEntityManager.h"
+#include "MassEntitySubsystem.h"
+#include "NiagaraDestructionDriver.h"
+#include "NiagaraDestructionDriverActor.h"
+#include "NiagaraDestructionDriverActorPool.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Engine/SCS_Node.h"
+#include "Engine/SimpleConstructionScript.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("NDD Entities"), STAT_NDD_Entities, STATGROUP_NiagaraDestructionDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("NDD Promoted Entities"), STAT_NDD_PromotedEntities, STATGROUP_NiagaraDestructionDriver);
+
+FMassEntityHandle UNiagaraDestructionDriverEntitySubsystem::AddEntity(TSubclassOf<ANiagaraDestructionDriverActor> DestructibleClass, UNiagaraDestructionDriverDataAsset* DataAsset, const FTransform& Transform)
+{
+	const int32 TypeIndex = FindOrAddType(DestructibleClass, DataAsset);
+	if (TypeIndex == INDEX_NONE)
+	{
+		return FMassEntityHandle();
+	}
+
+	FMassEntityManager& EntityManager = GetEntityManager();
+	const FMassEntityHandle Entity = EntityManager.CreateEntity(Archetype);
+	FNiagaraDestructionDriverEntityFragment& Fragment = EntityManager.GetFragmentDataChecked<FNiagaraDestructionDriverEntityFragment>(Entity);
+	Fragment.Transform = Transform;
+	Fragment.TypeIndex = TypeIndex;
+	AddProxyInstances(Entity, Fragment);
+	Entities.Add(Entity);
+
+	UpdateStats();
+	return Entity;
+}
+
+void UNiagaraDestructionDriverEntitySubsystem::RemoveEntity(const FMassEntityHandle Entity)
+{
+	if (!Entities.Remove(Entity))
+	{
+		return;
+	}
+
+	FMassEntityManager& EntityManager = GetEntityManager();
+	FNiagaraDestructionDriverEntityFragment& Fragment = EntityManager.GetFragmentDataChecked<FNiagaraDestructionDriverEntityFragment>(Entity);
+	RemoveProxyInstances(Fragment);
+	ANiagaraDestructionDriverActor* PromotedActor = Fragment.PromotedActor.Get();
+	EntityManager.DestroyEntity(Entity);
+
+	if (PromotedActor)
+	{
+		PromotedEntities.Remove(PromotedActor);
+		PromotedActor->OnDestroyed.RemoveDynamic(this, &UNiagaraDestructionDriverEntitySubsystem::OnPromotedDestructibleDestroyed);
+		if (UNiagaraDestructionDriverActorPool* ActorPool = GetWorld()->GetSubsystem<UNiagaraDestructionDriverActorPool>())
+		{
+			ActorPool->ReleaseDestructible(PromotedActor);
+		}
+		else
+		{
+			PromotedActor->Destroy();
+		}
+	}
+	UpdateStats();
+}
+
+FMassEntityHandle UNiagaraDestructionDriverEntitySubsystem::FindEntity(const UPrimitiveComponent* Component, const int32 InstanceIndex) const
+{
+	const FNiagaraDestructionDriverProxyOwner* Owner = GetProxySubsystem().FindProxyOwner(Component, InstanceIndex);
+	return Owner ? Owner->Entity : FMassEntityHandle();
+}
+
+ANiagaraDestructionDriverActor* UNiagaraDestructionDriverEntitySubsystem::PromoteEntity(const FMassEntityHandle Entity)
+{
+	if (!Entities.Contains(Entity))
+	{
+		return nullptr;
+	}
+
+	FMassEntityManager& EntityManager = GetEntityManager();
+	FNiagaraDestructionDriverEntityFragment& Fragment = EntityManager.GetFragmentDataChecked<FNiagaraDestructionDriverEntityFragment>(Entity);
+	if (ANiagaraDestructionDriverActor* PromotedActor = Fragment.PromotedActor.Get())
+	{
+		return PromotedActor;
+	}
+
+	// the destructible shows the same proxies until its hot swap, so the instances can go right away
+	RemoveProxyInstances(Fragment);
+	const FNiagaraDestructionDriverEntityType& Type = Types[Fragment.TypeIndex];
+	const FTransform Transform = Fragment.Transform;
+
+	UNiagaraDestructionDriverActorPool* ActorPool = GetWorld()->GetSubsystem<UNiagaraDestructionDriverActorPool>();
+	ANiagaraDestructionDriverActor* Destructible = ActorPool ? ActorPool->SpawnDestructible(Type.DataAsset, Transform, Type.DestructibleClass) : nullptr;
+
+	// spawning runs BeginPlay, fetch the fragment again in case anything touched the entity manager meanwhile
+	FNiagaraDestructionDriverEntityFragment& PromotedFragment = EntityManager.GetFragmentDataChecked<FNiagaraDestructionDriverEntityFragment>(Entity);
+	if (Destructible == nullptr)
+	{
+		AddProxyInstances(Entity, PromotedFragment);
+		return nullptr;
+	}
+	PromotedFragment.PromotedActor = Destructible;
+	PromotedEntities.Add(Destructible, Entity);
+	Destructible->OnDestroyed.AddUniqueDynamic(this, &UNiagaraDestructionDriverEntitySubsystem::OnPromotedDestructibleDestroyed);
+
+	UpdateStats();
+	return Destructible;
+}
+
+bool UNiagaraDestructionDriverEntitySubsystem::DemoteDestructible(ANiagaraDestructionDriverActor* Destructible)
+{
+	FMassEntityHandle Entity;
+	if (Destructible == nullptr || !PromotedEntities.RemoveAndCopyValue(Destructible, Entity))
+	{
+		return false;
+	}
+
+	// the pool may destroy it when full, that must not take the entity along
+	Destructible->OnDestroyed.RemoveDynamic(this, &UNiagaraDestructionDriverEntitySubsystem::OnPromotedDestructibleDestroyed);
+
+	if (Entities.Contains(Entity))
+	{
+		FNiagaraDestructionDriverEntityFragment& Fragment = GetEntityManager().GetFragmentDataChecked<FNiagaraDestructionDriverEntityFragment>(Entity);
+		Fragment.PromotedActor.Reset();
+		AddProxyInstances(Entity, Fragment);
+	}
+
+	if (UNiagaraDestructionDriverActorPool* ActorPool = GetWorld()->GetSubsystem<UNiagaraDestructionDriverActorPool>())
+	{
+		ActorPool->ReleaseDestructible(Destructible);
+	}
+	else
+	{
+		Destructible->Destroy();
+	}
+	UpdateStats();
+	return true;
+}
+
+void UNiagaraDestructionDriverEntitySubsystem::GetProxyTemplates(TSubclassOf<ANiagaraDestructionDriverActor> DestructibleClass, TArray<const UStaticMeshComponent*>& OutTemplates, TArray<FTransform>& OutRelativeTransforms)
+{
+	UBlueprintGeneratedClass* ActualClass = Cast<UBlueprintGeneratedClass>(DestructibleClass.Get());
+	if (ActualClass == nullptr)
+	{
+		return;
+	}
+
+	const ANiagaraDestructionDriverActor* DefaultActor = DestructibleClass->GetDefaultObject<ANiagaraDestructionDriverActor>();
+	const FName ContainerName = DefaultActor->SourceGeometryContainer->GetFName();
+	const FTransform ContainerTransform = DefaultActor->SourceGeometryContainer->GetRelativeTransform();
+
+	for (const UBlueprintGeneratedClass* Class = ActualClass; Class; Class = Cast<UBlueprintGeneratedClass>(Class->GetSuperClass()))
+	{
+		if (Class->SimpleConstructionScript == nullptr)
+		{
+			continue;
+		}
+		for (const USCS_Node* Node : Class->SimpleConstructionScript->GetAllNodes())
+		{
+			// the chaos-to-niagara tool attaches one mesh per geometry source straight to the native container
+			if (Node == nullptr || !Node->bIsParentComponentNative || Node->ParentComponentOrVariableName != ContainerName)
+			{
+				continue;
+			}
+			const UStaticMeshComponent* Template = Cast<UStaticMeshComponent>(Node->GetActualComponentTemplate(ActualClass));
+			if (Template && Template->GetStaticMesh())
+			{
+				OutTemplates.Add(Template);
+				OutRelativeTransforms.Add(Template->GetRelativeTransform() * ContainerTransform);
+			}
+		}
+	}
+}
+
+void UNiagaraDestructionDriverEntitySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	Collection.InitializeDependency<UMassEntitySubsystem>();
+	Collection.InitializeDependency<UNiagaraDestructionDriverProxySubsystem>();
+
+	TArray<const UScriptStruct*> Fragments;
+	Fragments.Add(FNiagaraDestructionDriverEntityFragment::StaticStruct());
+	Archetype = GetEntityManager().CreateArchetype(Fragments);
+}
+
+void UNiagaraDestructionDriverEntitySubsystem::Deinitialize()
+{
+	// the entity manager and proxy batches go after this subsystem (InitializeDependency)
+	if (UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>())
+	{
+		FMassEntityManager& EntityManager = EntitySubsystem->GetMutableEntityManager();
+		for (const FMassEntityHandle Entity : Entities)
+		{
+			EntityManager.DestroyEntity(Entity);
+		}
+	}
+	Entities.Empty();
+	PromotedEntities.Empty();
+	Types.Empty();
+	UpdateStats();
+	Super::Deinitialize();
+}
+
+bool UNiagaraDestructionDriverEntitySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+FMassEntityManager& UNiagaraDestructionDriverEntitySubsystem::GetEntityManager() const
+{
+	UMassEntitySubsystem* EntitySubsystem = GetWorld()->GetSubsystem<UMassEntitySubsystem>();
+	check(EntitySubsystem);
+	return EntitySubsystem->GetMutableEntityManager();
+}
+
+UNiagaraDestructionDriverProxySubsystem& UNiagaraDestructionDriverEntitySubsystem::GetProxySubsystem() const
+{
+	UNiagaraDestructionDriverProxySubsystem* ProxySubsystem = GetWorld()->GetSubsystem<UNiagaraDestructionDriverProxySubsystem>();
+	check(ProxySubsystem);
+	return *ProxySubsystem;
+}
+
+int32 UNiagaraDestructionDriverEntitySubsystem::FindOrAddType(TSubclassOf<ANiagaraDestructionDriverActor> DestructibleClass, UNiagaraDestructionDriverDataAsset* DataAsset)
+{
+	if (DestructibleClass == nullptr)
+	{
+		return INDEX_NONE;
+	}
+	if (DataAsset == nullptr)
+	{
+		DataAsset = DestructibleClass->GetDefaultObject<ANiagaraDestructionDriverActor>()->NiagaraDestructionDriverParams;
+	}
+
+	const int32 ExistingIndex = Types.IndexOfByPredicate([&](const FNiagaraDestructionDriverEntityType& Type)
+	{
+		return Type.DestructibleClass == DestructibleClass && Type.DataAsset == DataAsset;
+	});
+	if (ExistingIndex != INDEX_NONE)
+	{
+		return ExistingIndex;
+	}
+
+	TArray<const UStaticMeshComponent*> Templates;
+	TArray<FTransform> RelativeTransforms;
+	GetProxyTemplates(DestructibleClass, Templates, RelativeTransforms);
+	if (Templates.Num() == 0)
+	{
+		UE_LOG(LogNiagaraDestructionDriver, Warning, TEXT("%s has no static meshes under SourceGeometryContainer to draw its entities with, place it as an actor instead."), *DestructibleClass->GetName());
+		return INDEX_NONE;
+	}
+
+	FNiagaraDestructionDriverEntityType& Type = Types.AddDefaulted_GetRef();
+	Type.DestructibleClass = DestructibleClass;
+	Type.DataAsset = DataAsset;
+	for (int32 Idx = 0; Idx < Templates.Num(); Idx++)
+	{
+		FNiagaraDestructionDriverProxyMesh& Proxy = Type.Proxies.AddDefaulted_GetRef();
+		Proxy.RelativeTransform = RelativeTransforms[Idx];
+		Proxy.BatchIndex = GetProxySubsystem().FindOrAddBatch(Templates[Idx]);
+	}
+	return Types.Num() - 1;
+}
+
+void UNiagaraDestructionDriverEntitySubsystem::AddProxyInstances(const FMassEntityHandle Entity, FNiagaraDestructionDriverEntityFragment& Fragment)
+{
+	const FNiagaraDestructionDriverEntityType& Type = Types[Fragment.TypeIndex];
+	UNiagaraDestructionDriverProxySubsystem& ProxySubsystem = GetProxySubsystem();
+	FNiagaraDestructionDriverProxyOwner Owner;
+	Owner.Entity = Entity;
+	Fragment.ProxyInstances.SetNum(Type.Proxies.Num());
+	for (int32 ProxyIdx = 0; ProxyIdx < Type.Proxies.Num(); ProxyIdx++)
+	{
+		const FNiagaraDestructionDriverProxyMesh& Proxy = Type.Proxies[ProxyIdx];
+		Fragment.ProxyInstances[ProxyIdx] = ProxySubsystem.AddProxy(Proxy.BatchIndex, Proxy.RelativeTransform * Fragment.Transform, Owner);
+	}
+}
+
+void UNiagaraDestructionDriverEntitySubsystem::RemoveProxyInstances(FNiagaraDestructionDriverEntityFragment& Fragment)
+{
+	UNiagaraDestructionDriverProxySubsystem& ProxySubsystem = GetProxySubsystem();
+	for (const int32 ProxyId : Fragment.ProxyInstances)
+	{
+		ProxySubsystem.RemoveProxy(ProxyId);
+	}
+	Fragment.ProxyInstances.Reset();
+}
+
+void UNiagaraDestructionDriverEntitySubsystem::OnPromotedDestructibleDestroyed(AActor* DestroyedActor)
+{
+	FMassEntityHandle Entity;
+	if (PromotedEntities.RemoveAndCopyValue(Cast<ANiagaraDestructionDriverActor>(DestroyedActor), Entity) && Entities.Remove(Entity))
+	{
+		// promoted entities have no instances left to remove
+		GetEntityManager().DestroyEntity(Entity);
+		UpdateStats();
+	}
+}
+
+void UNiagaraDestructionDriverEntitySubsystem::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_NDD_Entities, Entities.Num());
+	SET_DWORD_STAT(STAT_NDD_PromotedEntities, PromotedEntities.Num());
+}
@@ -5,7 +5,13 @@
 
 #include "CVars.h"
 #include "NiagaraDestructionDriverActor.h"
+#include "NiagaraDestructionDriverEntitySubsystem.h"
+#include "NiagaraDestructionDriverProxySubsystem.h"
+#include "RenderingThread.h"
+#include "RHICommandList.h"
+#include "TextureResource.h"
 #include "Engine/OverlapResult.h"
+#include "Misc/App.h"
 
 void UNiagaraDestructionDriverHelper::InitiateDestructionForce(const UObject* WorldContextObject, const FVector Location, const float Radius, const float Force)
 {
@@ -32,18 +38,127 @@ void UNiagaraDestructionDriverHelper::InitiateDestructionForce(const UObject* Wo
 
 	if (bHasOverlap)
 	{
-		for (FOverlapResult& Result: OverlapResults)
+		TArray<ANiagaraDestructionDriverActor*> HitDestructibles;
+
+		// batched proxies stand in for destructibles or entities. Look up every hit instance before promoting or hot swapping
+		// anything, both remove instances
+		TArray<FMassEntityHandle> HitEntities;
+		if (const UNiagaraDestructionDriverProxySubsystem* ProxySubsystem = WorldContextObject->GetWorld()->GetSubsystem<UNiagaraDestructionDriverProxySubsystem>())
 		{
-			if (Result.OverlapObjectHandle.DoesRepresentClass(ANiagaraDestructionDriverActor::StaticClass()))
+			for (const FOverlapResult& Result : OverlapResults)
 			{
-				ANiagaraDestructionDriverActor* NDDActor = Result.OverlapObjectHandle.FetchActor<ANiagaraDestructionDriverActor>();
-				NDDActor->InitiateDestructionForce(Location, Radius);
+				if (const FNiagaraDestructionDriverProxyOwner* Owner = ProxySubsystem->FindProxyOwner(Result.GetComponent(), Result.ItemIndex))
+				{
+					if (Owner->Entity.IsSet())
+					{
+						HitEntities.AddUnique(Owner->Entity);
+					}
+					else if (ANiagaraDestructionDriverActor* NDDActor = Owner->Destructible.Get())
+					{
+						HitDestructibles.AddUnique(NDDActor);
+					}
+				}
+			}
+		}
 
-				if (CVarNDD_DebugCollisions.GetValueOnGameThread() == 1)
+		// intact entities become destructibles first
+		if (UNiagaraDestructionDriverEntitySubsystem* EntitySubsystem = WorldContextObject->GetWorld()->GetSubsystem<UNiagaraDestructionDriverEntitySubsystem>())
+		{
+			for (const FMassEntityHandle Entity : HitEntities)
+			{
+				if (ANiagaraDestructionDriverActor* NDDActor = EntitySubsystem->PromoteEntity(Entity))
 				{
-					DrawDebugSphere(NDDActor->GetWorld(), Location, Radius, 32, FColor::Yellow, true, 2.f, 0, 1);
+					HitDestructibles.AddUnique(NDDActor);
 				}
 			}
 		}
+
+		for (FOverlapResult& Result: OverlapResults)
+		{
+			if (Result.OverlapObjectHandle.DoesRepresentClass(ANiagaraDestructionDriverActor::StaticClass()))
+			{
+				HitDestructibles.AddUnique(Result.OverlapObjectHandle.FetchActor<ANiagaraDestructionDriverActor>());
+			}
+		}
+
+		for (ANiagaraDestructionDriverActor* NDDActor : HitDestructibles)
+		{
+			NDDActor->InitiateDestructionForce(Location, Radius);
+
+			if (CVarNDD_DebugCollisions.GetValueOnGameThread() == 1)
+			{
+				DrawDebugSphere(NDDActor->GetWorld(), Location, Radius, 32, FColor::Yellow, true, 2.f, 0, 1);
+			}
+		}
+	}
+}
+
+void UNiagaraDestructionDriverHelper::PrefetchDestructionAssets(const UObject* WorldContextObject, const FVector Location, const float Radius)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	if (World == nullptr)
+	{
+		return;
+	}
+
+	// same query as InitiateDestructionForce, so everything the force will hit gets prefetched
+	FCollisionQueryParams QueryParams;
+	QueryParams.bTraceComplex = false;
+	QueryParams.bReturnPhysicalMaterial = false;
+	TArray<FOverlapResult> OverlapResults;
+	World->OverlapMultiByChannel(OverlapResults, Location, FQuat::Identity, ECC_WorldDynamic, FCollisionShape::MakeSphere(Radius), QueryParams);
+	const UNiagaraDestructionDriverProxySubsystem* ProxySubsystem = World->GetSubsystem<UNiagaraDestructionDriverProxySubsystem>();
+	for (const FOverlapResult& Result : OverlapResults)
+	{
+		const FNiagaraDestructionDriverProxyOwner* Owner = ProxySubsystem ? ProxySubsystem->FindProxyOwner(Result.GetComponent(), Result.ItemIndex) : nullptr;
+		if (ANiagaraDestructionDriverActor* NDDActor = Owner ? Owner->Destructible.Get() : nullptr)
+		{
+			NDDActor->PrefetchDestructionAssets();
+		}
+		else if (Result.OverlapObjectHandle.DoesRepresentClass(ANiagaraDestructionDriverActor::StaticClass()))
+		{
+			if (ANiagaraDestructionDriverActor* NDDActor = Result.OverlapObjectHandle.FetchActor<ANiagaraDestructionDriverActor>())
+			{
+				NDDActor->PrefetchDestructionAssets();
+			}
+		}
+	}
+}
+
+UTextureRenderTarget2D* UNiagaraDestructionDriverHelper::CreateSimulationRenderTarget(UObject* Outer, const int32 Size, const ETextureRenderTargetFormat Format)
+{
+	UTextureRenderTarget2D* RenderTarget = NewObject<UTextureRenderTarget2D>(Outer ? Outer : GetTransientPackage());
+	RenderTarget->RenderTargetFormat = Format;
+	RenderTarget->ClearColor = FLinearColor::Black;
+	RenderTarget->bAutoGenerateMips = false;
+	RenderTarget->bCanCreateUAV = false;
+	RenderTarget->InitAutoFormat(Size, Size);
+	RenderTarget->LODGroup = TEXTUREGROUP_16BitData;
+	RenderTarget->UpdateResourceImmediate(true);
+	return RenderTarget;
+}
+
+void UNiagaraDestructionDriverHelper::WriteRenderTargetRegion(UTextureRenderTarget2D* RenderTarget, const FIntRect& Rect, TArray<FFloat16Color> Pixels)
+{
+	FTextureRenderTargetResource* Resource = RenderTarget ? RenderTarget->GameThread_GetRenderTargetResource() : nullptr;
+	if (Resource == nullptr || Rect.Area() <= 0 || Pixels.Num() < Rect.Area())
+	{
+		return;
+	}
+
+	ENQUEUE_RENDER_COMMAND(NDD_WriteRenderTargetRegion)([Resource, Rect, Pixels = MoveTemp(Pixels)](FRHICommandListImmediate& RHICmdList)
+	{
+		const FUpdateTextureRegion2D Region(Rect.Min.X, Rect.Min.Y, 0, 0, Rect.Width(), Rect.Height());
+		RHICmdList.UpdateTexture2D(Resource->GetRenderTargetTexture(), 0, Region, Rect.Width() * sizeof(FFloat16Color), reinterpret_cast<const uint8*>(Pixels.GetData()));
+	});
+}
+
+bool UNiagaraDestructionDriverHelper::ShouldCreateRenderResources(const UObject* WorldContextObject)
+{
+	if (IsRunningDedicatedServer() || !FApp::CanEverRender() || CVarNDD_ForceHeadless.GetValueOnGameThread() == 1)
+	{
+		return false;
 	}
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	return World == nullptr || World->GetNetMode() != NM_DedicatedServer;
 }
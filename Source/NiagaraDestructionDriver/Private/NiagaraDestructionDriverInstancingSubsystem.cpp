@@ -0,0 +1,522 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverInstancingSubsystem.h"
+
+#include "NiagaraComponent.h"
+#include "NiagaraDataInterfaceArrayFunctionLibrary.h"
+#include "NiagaraDestructionDriver.h"
+#include "NiagaraDestructionDriverHelper.h"
+#include "NiagaraDestructionDriverRuntimeContext.h"
+#include "NiagaraDestructionDriverSettings.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/World.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+DECLARE_CYCLE_STAT(TEXT("NDD Instancing Tick"), STAT_NDD_InstancingTick, STATGROUP_NiagaraDestructionDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("NDD Instance Groups"), STAT_NDD_InstanceGroups, STATGROUP_NiagaraDestructionDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("NDD Instanced Destructibles"), STAT_NDD_InstancedDestructibles, STATGROUP_NiagaraDestructionDriver);
+
+// largest render target size supported everywhere
+static constexpr int32 MaxInstancePageSize = 8192;
+
+int32 UNiagaraDestructionDriverInstancingSubsystem::AcquireInstance(ANiagaraDestructionDriverActor* Destructible, const FNiagaraDestructionDriverRuntimeContext& Context)
+{
+	UNiagaraDestructionDriverDataAsset* DataAsset = Destructible ? Destructible->NiagaraDestructionDriverParams.Get() : nullptr;
+	if (DataAsset == nullptr || !Context.IsValid() || Context.ParticleSystem == nullptr)
+	{
+		return INDEX_NONE;
+	}
+
+	FNiagaraDestructionDriverInstanceGroup* Group = Groups.Find(DataAsset);
+	if (Group == nullptr)
+	{
+		Group = AddGroup(DataAsset, Context);
+		if (Group == nullptr)
+		{
+			return INDEX_NONE;
+		}
+	}
+	if (Group->FreeSlots.Num() == 0)
+	{
+		UE_LOG(LogNiagaraDestructionDriver, Log, TEXT("Instance group of %s is full (%d slots), %s is drawn on its own. Increase MaxInstancesPerDataAsset in the plugin settings."),
+				*DataAsset->GetName(),
+				Group->Owners.Num(),
+				*Destructible->GetName());
+		return INDEX_NONE;
+	}
+
+	const int32 Slot = Group->FreeSlots.Pop(EAllowShrinking::No);
+	Group->Owners[Slot] = Destructible;
+	Group->InstanceVisible[Slot] = false;
+	Group->InstanceSimulating[Slot] = false;
+	Group->InstanceBoundsScales[Slot] = 1.f;
+	// the tile may still hold the bones of the previous owner
+	Group->InstanceResetCounts[Slot]++;
+	SetSlotTransform(*Group, Slot, Destructible);
+	UpdateInstance(*Group, Slot);
+	Group->bParametersDirty = true;
+
+	UpdateStats();
+	return Slot;
+}
+
+void UNiagaraDestructionDriverInstancingSubsystem::ReleaseInstance(const ANiagaraDestructionDriverActor* Destructible)
+{
+	int32 Slot;
+	FNiagaraDestructionDriverInstanceGroup* Group = FindGroup(Destructible, Slot);
+	if (Group == nullptr)
+	{
+		return;
+	}
+
+	RemoveForces(*Group, Slot);
+	Group->Owners[Slot].Reset();
+	Group->InstanceVisible[Slot] = false;
+	Group->InstanceSimulating[Slot] = false;
+	Group->InstanceBoundsScales[Slot] = 1.f;
+	Group->FreeSlots.Add(Slot);
+	Group->bParametersDirty = true;
+	Group->bBoundsDirty = true;
+	UpdateInstance(*Group, Slot);
+
+	// nothing left to draw, let go of the mesh, materials and render targets so they can stream out
+	if (Group->FreeSlots.Num() == Group->Owners.Num())
+	{
+		RemoveGroup(Destructible->NiagaraDestructionDriverParams);
+	}
+	UpdateStats();
+}
+
+void UNiagaraDestructionDriverInstancingSubsystem::ShowInstance(const ANiagaraDestructionDriverActor* Destructible)
+{
+	int32 Slot;
+	if (FNiagaraDestructionDriverInstanceGroup* Group = FindGroup(Destructible, Slot))
+	{
+		Group->InstanceVisible[Slot] = true;
+		SetSlotTransform(*Group, Slot, Destructible);
+		UpdateInstance(*Group, Slot);
+		Group->bParametersDirty = true;
+	}
+}
+
+void UNiagaraDestructionDriverInstancingSubsystem::ResetInstance(const ANiagaraDestructionDriverActor* Destructible)
+{
+	int32 Slot;
+	if (FNiagaraDestructionDriverInstanceGroup* Group = FindGroup(Destructible, Slot))
+	{
+		RemoveForces(*Group, Slot);
+		Group->InstanceVisible[Slot] = false;
+		Group->InstanceSimulating[Slot] = false;
+		Group->InstanceBoundsScales[Slot] = 1.f;
+		Group->InstanceResetCounts[Slot]++;
+		SetSlotTransform(*Group, Slot, Destructible);
+		UpdateInstance(*Group, Slot);
+		Group->bParametersDirty = true;
+		Group->bBoundsDirty = true;
+	}
+}
+
+void UNiagaraDestructionDriverInstancingSubsystem::UpdateInstanceTransform(const ANiagaraDestructionDriverActor* Destructible)
+{
+	int32 Slot;
+	if (FNiagaraDestructionDriverInstanceGroup* Group = FindGroup(Destructible, Slot))
+	{
+		SetSlotTransform(*Group, Slot, Destructible);
+		UpdateInstance(*Group, Slot);
+		Group->bParametersDirty = true;
+	}
+}
+
+void UNiagaraDestructionDriverInstancingSubsystem::SetInstanceBoundsScale(const ANiagaraDestructionDriverActor* Destructible, const float BoundsScale)
+{
+	int32 Slot;
+	if (FNiagaraDestructionDriverInstanceGroup* Group = FindGroup(Destructible, Slot))
+	{
+		Group->InstanceBoundsScales[Slot] = BoundsScale;
+		UpdateInstance(*Group, Slot);
+		Group->bBoundsDirty = true;
+	}
+}
+
+void UNiagaraDestructionDriverInstancingSubsystem::ApplyForce(const ANiagaraDestructionDriverActor* Destructible, const FNiagaraDestructionDriverForce& Force)
+{
+	int32 Slot;
+	if (FNiagaraDestructionDriverInstanceGroup* Group = FindGroup(Destructible, Slot))
+	{
+		Group->Forces.Add(Force);
+		Group->ForceInstances.Add(Slot);
+		Group->InstanceSimulating[Slot] = true;
+		Group->bParametersDirty = true;
+	}
+}
+
+void UNiagaraDestructionDriverInstancingSubsystem::SettleInstance(const ANiagaraDestructionDriverActor* Destructible)
+{
+	int32 Slot;
+	if (FNiagaraDestructionDriverInstanceGroup* Group = FindGroup(Destructible, Slot))
+	{
+		RemoveForces(*Group, Slot);
+		Group->InstanceSimulating[Slot] = false;
+		Group->bParametersDirty = true;
+	}
+}
+
+UTextureRenderTarget2D* UNiagaraDestructionDriverInstancingSubsystem::GetPositionsTexture(const ANiagaraDestructionDriverActor* Destructible) const
+{
+	int32 Slot;
+	const FNiagaraDestructionDriverInstanceGroup* Group = FindGroup(Destructible, Slot);
+	return Group ? Group->PositionsTexture.Get() : nullptr;
+}
+
+UTextureRenderTarget2D* UNiagaraDestructionDriverInstancingSubsystem::GetRotationsTexture(const ANiagaraDestructionDriverActor* Destructible) const
+{
+	int32 Slot;
+	const FNiagaraDestructionDriverInstanceGroup* Group = FindGroup(Destructible, Slot);
+	return Group ? Group->RotationsTexture.Get() : nullptr;
+}
+
+FVector4 UNiagaraDestructionDriverInstancingSubsystem::GetTileOffsetScale(const ANiagaraDestructionDriverActor* Destructible) const
+{
+	int32 Slot;
+	const FNiagaraDestructionDriverInstanceGroup* Group = FindGroup(Destructible, Slot);
+	return Group ? Group->InstanceTileOffsetScales[Slot] : FVector4(0.f, 0.f, 1.f, 1.f);
+}
+
+int32 UNiagaraDestructionDriverInstancingSubsystem::GetNumInstances() const
+{
+	int32 NumInstances = 0;
+	for (const TPair<TObjectPtr<UNiagaraDestructionDriverDataAsset>, FNiagaraDestructionDriverInstanceGroup>& Pair : Groups)
+	{
+		NumInstances += Pair.Value.Owners.Num() - Pair.Value.FreeSlots.Num();
+	}
+	return NumInstances;
+}
+
+void UNiagaraDestructionDriverInstancingSubsystem::DumpInstancingStats() const
+{
+	UE_LOG(LogNiagaraDestructionDriver, Display, TEXT("Instanced destructibles: %d groups, %d instances (one instanced mesh and one niagara system per group)"), Groups.Num(), GetNumInstances());
+	for (const TPair<TObjectPtr<UNiagaraDestructionDriverDataAsset>, FNiagaraDestructionDriverInstanceGroup>& Pair : Groups)
+	{
+		const FNiagaraDestructionDriverInstanceGroup& Group = Pair.Value;
+		int32 NumSimulating = 0;
+		int32 NumVisible = 0;
+		for (int32 Slot = 0; Slot < Group.Owners.Num(); Slot++)
+		{
+			NumSimulating += Group.InstanceSimulating[Slot] ? 1 : 0;
+			NumVisible += Group.InstanceVisible[Slot] ? 1 : 0;
+		}
+		const int32 PageSize = Group.TilesPerRow * Group.TileSize;
+		UE_LOG(LogNiagaraDestructionDriver, Display, TEXT("  %s: %d/%d slots used, %d drawn, %d simulating, %d forces, %d material slots, pages of %dx%d"),
+				*GetNameSafe(Pair.Key),
+				Group.Owners.Num() - Group.FreeSlots.Num(),
+				Group.Owners.Num(),
+				NumVisible,
+				NumSimulating,
+				Group.Forces.Num(),
+				Group.Materials.Num(),
+				PageSize,
+				PageSize);
+	}
+}
+
+void UNiagaraDestructionDriverInstancingSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NDD_InstancingTick);
+
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+	for (TPair<TObjectPtr<UNiagaraDestructionDriverDataAsset>, FNiagaraDestructionDriverInstanceGroup>& Pair : Groups)
+	{
+		FNiagaraDestructionDriverInstanceGroup& Group = Pair.Value;
+
+		// forces that stopped pushing only make the arrays longer
+		for (int32 Idx = Group.Forces.Num() - 1; Idx >= 0; Idx--)
+		{
+			if (Group.Forces[Idx].StartTime + Group.Forces[Idx].Duration < WorldTime)
+			{
+				Group.Forces.RemoveAtSwap(Idx, 1, EAllowShrinking::No);
+				Group.ForceInstances.RemoveAtSwap(Idx, 1, EAllowShrinking::No);
+				Group.bParametersDirty = true;
+			}
+		}
+
+		if (Group.bBoundsDirty)
+		{
+			float BoundsScale = 1.f;
+			for (int32 Slot = 0; Slot < Group.Owners.Num(); Slot++)
+			{
+				BoundsScale = Group.InstanceVisible[Slot] ? FMath::Max(BoundsScale, Group.InstanceBoundsScales[Slot]) : BoundsScale;
+			}
+			Group.MeshComponent->SetBoundsScale(BoundsScale);
+			Group.bBoundsDirty = false;
+		}
+
+		// everything that changed this frame goes to the simulation at once
+		if (Group.bParametersDirty)
+		{
+			PushParameters(Group);
+		}
+
+		// paused instead of deactivated so the settled bones of the other slots aren't respawned
+		UNiagaraComponent* NiagaraComponent = Group.NiagaraComponent;
+		if (Group.InstanceSimulating.Contains(true))
+		{
+			if (!NiagaraComponent->IsActive())
+			{
+				NiagaraComponent->Activate();
+			}
+			if (NiagaraComponent->IsPaused())
+			{
+				NiagaraComponent->SetPaused(false);
+			}
+		}
+		else if (NiagaraComponent->IsActive() && !NiagaraComponent->IsPaused())
+		{
+			NiagaraComponent->SetPaused(true);
+		}
+	}
+}
+
+TStatId UNiagaraDestructionDriverInstancingSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNiagaraDestructionDriverInstancingSubsystem, STATGROUP_NiagaraDestructionDriver);
+}
+
+void UNiagaraDestructionDriverInstancingSubsystem::Deinitialize()
+{
+	Groups.Empty();
+	GroupOwner = nullptr;
+	UpdateStats();
+	Super::Deinitialize();
+}
+
+bool UNiagaraDestructionDriverInstancingSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// headless destructibles never activate
+	return Super::ShouldCreateSubsystem(Outer) && UNiagaraDestructionDriverHelper::ShouldCreateRenderResources(Outer);
+}
+
+bool UNiagaraDestructionDriverInstancingSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+FNiagaraDestructionDriverInstanceGroup* UNiagaraDestructionDriverInstancingSubsystem::AddGroup(UNiagaraDestructionDriverDataAsset* DataAsset, const FNiagaraDestructionDriverRuntimeContext& Context)
+{
+	// as many tiles as requested, as long as the pages stay within the largest render target size
+	const int32 MaxInstances = GetDefault<UNiagaraDestructionDriverSettings>()->MaxInstancesPerDataAsset;
+	const int32 TileSize = FMath::Max(Context.RenderTargetTextureSize, 1);
+	const int32 TilesPerRow = FMath::Clamp(FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(MaxInstances))), 1, FMath::Max(MaxInstancePageSize / TileSize, 1));
+	const int32 NumSlots = FMath::Min(MaxInstances, TilesPerRow * TilesPerRow);
+	if (NumSlots <= 0)
+	{
+		return nullptr;
+	}
+	const int32 PageSize = TilesPerRow * TileSize;
+
+	if (GroupOwner == nullptr)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		GroupOwner = GetWorld()->SpawnActor<AActor>(SpawnParams);
+		USceneComponent* Root = NewObject<USceneComponent>(GroupOwner, TEXT("Root"));
+		GroupOwner->SetRootComponent(Root);
+		Root->RegisterComponent();
+	}
+
+	FNiagaraDestructionDriverInstanceGroup& Group = Groups.Add(DataAsset);
+	Group.TileSize = TileSize;
+	Group.TilesPerRow = TilesPerRow;
+	Group.PositionsTexture = UNiagaraDestructionDriverHelper::CreateSimulationRenderTarget(this, PageSize);
+	Group.RotationsTexture = UNiagaraDestructionDriverHelper::CreateSimulationRenderTarget(this, PageSize);
+
+	// per instance values (tile, rotation, bounds scale) come from the instance custom data, laid out like FNiagaraDestructionDriverPrimitiveData
+	const FNiagaraDestructionDriverParameterNames& ParameterNames = FNiagaraDestructionDriverParameterNames::Get();
+	for (UMaterialInterface* SlotMaterial : Context.SlotMaterials)
+	{
+		UMaterialInstanceDynamic* Material = UMaterialInstanceDynamic::Create(SlotMaterial, this);
+		Material->SetScalarParameterValue(ParameterNames.RT_Size, Context.RenderTargetTextureSize);
+		Material->SetTextureParameterValue(ParameterNames.RT_Position, Group.PositionsTexture);
+		Material->SetTextureParameterValue(ParameterNames.RT_Rotation, Group.RotationsTexture);
+		Material->SetTextureParameterValue(ParameterNames.InitialBoneLocations, Context.InitialBoneLocationsTexture);
+		Material->SetVectorParameterValue(ParameterNames.MeshHalfExtents, Context.MeshHalfExtents);
+		Group.Materials.Add(Material);
+	}
+
+	Group.MeshComponent = NewObject<UInstancedStaticMeshComponent>(GroupOwner);
+	Group.MeshComponent->SetStaticMesh(Context.StaticMesh);
+	for (int32 MaterialIdx = 0; MaterialIdx < Group.Materials.Num(); MaterialIdx++)
+	{
+		Group.MeshComponent->SetMaterial(MaterialIdx, Group.Materials[MaterialIdx]);
+	}
+	Group.MeshComponent->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Group.MeshComponent->SetNumCustomDataFloats(FNiagaraDestructionDriverPrimitiveData::Num);
+	Group.MeshComponent->SetupAttachment(GroupOwner->GetRootComponent());
+	Group.MeshComponent->RegisterComponent();
+
+	Group.NiagaraComponent = NewObject<UNiagaraComponent>(GroupOwner);
+	Group.NiagaraComponent->SetAutoActivate(false);
+	Group.NiagaraComponent->SetAsset(Context.ParticleSystem);
+	Group.NiagaraComponent->SetVariableStaticMesh(ParameterNames.DestructibleMesh, Context.StaticMesh);
+	Group.NiagaraComponent->SetVariableTexture(ParameterNames.InitialBonePositionsTexture, Context.InitialBoneLocationsTexture);
+	Group.NiagaraComponent->SetVariableTextureRenderTarget(ParameterNames.SimulatedParticlePositionsOut, Group.PositionsTexture);
+	Group.NiagaraComponent->SetVariableTextureRenderTarget(ParameterNames.SimulatedParticleRotationsOut, Group.RotationsTexture);
+	Group.NiagaraComponent->SetVariableVec3(ParameterNames.DestructibleMeshLocalHalfExtents, Context.MeshHalfExtents);
+	Group.NiagaraComponent->SetVariableInt(ParameterNames.InstanceCount, NumSlots);
+	Group.NiagaraComponent->SetupAttachment(GroupOwner->GetRootComponent());
+	Group.NiagaraComponent->RegisterComponent();
+
+	// every slot gets its instance up front so the slot is the instance ID, free slots are zero scaled
+	Group.Owners.SetNum(NumSlots);
+	Group.FreeSlots.Reserve(NumSlots);
+	for (int32 Slot = NumSlots - 1; Slot >= 0; Slot--)
+	{
+		Group.FreeSlots.Add(Slot);
+	}
+	Group.InstanceLocations.Init(FVector::ZeroVector, NumSlots);
+	Group.InstanceRotations.Init(FQuat::Identity, NumSlots);
+	Group.InstanceScales.Init(FVector::OneVector, NumSlots);
+	Group.InstanceSimulating.Init(false, NumSlots);
+	Group.InstanceResetCounts.Init(0, NumSlots);
+	Group.InstanceVisible.Init(false, NumSlots);
+	Group.InstanceBoundsScales.Init(1.f, NumSlots);
+	Group.InstanceTileOffsetScales.Reserve(NumSlots);
+	const double TileScale = 1.0 / TilesPerRow;
+	for (int32 Slot = 0; Slot < NumSlots; Slot++)
+	{
+		Group.InstanceTileOffsetScales.Add(FVector4((Slot % TilesPerRow) * TileScale, (Slot / TilesPerRow) * TileScale, TileScale, TileScale));
+	}
+
+	TArray<FTransform> HiddenTransforms;
+	HiddenTransforms.Init(FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector), NumSlots);
+	Group.MeshComponent->AddInstances(HiddenTransforms, false, true);
+	for (int32 Slot = 0; Slot < NumSlots; Slot++)
+	{
+		UpdateInstance(Group, Slot);
+	}
+
+	// the tiles never move, send them once
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector4(Group.NiagaraComponent, ParameterNames.InstanceTileOffsetScales, Group.InstanceTileOffsetScales);
+	Group.bParametersDirty = true;
+
+	UE_LOG(LogNiagaraDestructionDriver, Log, TEXT("Added instance group for %s: %d slots, pages of %dx%d."), *DataAsset->GetName(), NumSlots, PageSize, PageSize);
+	return &Group;
+}
+
+void UNiagaraDestructionDriverInstancingSubsystem::RemoveGroup(UNiagaraDestructionDriverDataAsset* DataAsset)
+{
+	FNiagaraDestructionDriverInstanceGroup Group;
+	if (!Groups.RemoveAndCopyValue(DataAsset, Group))
+	{
+		return;
+	}
+	if (Group.NiagaraComponent)
+	{
+		Group.NiagaraComponent->DeactivateImmediate();
+		Group.NiagaraComponent->DestroyComponent();
+	}
+	if (Group.MeshComponent)
+	{
+		Group.MeshComponent->DestroyComponent();
+	}
+}
+
+FNiagaraDestructionDriverInstanceGroup* UNiagaraDestructionDriverInstancingSubsystem::FindGroup(const ANiagaraDestructionDriverActor* Destructible, int32& OutSlot)
+{
+	OutSlot = Destructible ? Destructible->GetInstanceSlot() : INDEX_NONE;
+	FNiagaraDestructionDriverInstanceGroup* Group = OutSlot != INDEX_NONE ? Groups.Find(Destructible->NiagaraDestructionDriverParams) : nullptr;
+	return Group && Group->Owners.IsValidIndex(OutSlot) && Group->Owners[OutSlot].Get() == Destructible ? Group : nullptr;
+}
+
+const FNiagaraDestructionDriverInstanceGroup* UNiagaraDestructionDriverInstancingSubsystem::FindGroup(const ANiagaraDestructionDriverActor* Destructible, int32& OutSlot) const
+{
+	OutSlot = Destructible ? Destructible->GetInstanceSlot() : INDEX_NONE;
+	const FNiagaraDestructionDriverInstanceGroup* Group = OutSlot != INDEX_NONE ? Groups.Find(Destructible->NiagaraDestructionDriverParams) : nullptr;
+	return Group && Group->Owners.IsValidIndex(OutSlot) && Group->Owners[OutSlot].Get() == Destructible ? Group : nullptr;
+}
+
+void UNiagaraDestructionDriverInstancingSubsystem::SetSlotTransform(FNiagaraDestructionDriverInstanceGroup& Group, const int32 Slot, const ANiagaraDestructionDriverActor* Destructible) const
+{
+	// like the niagara component of a destructible, centered against the mesh by the pivot offset
+	const FTransform ActorTransform = Destructible->GetActorTransform();
+	Group.InstanceLocations[Slot] = ActorTransform.TransformPosition(-Destructible->NiagaraDestructionDriverParams->PivotOffset);
+	Group.InstanceRotations[Slot] = ActorTransform.GetRotation();
+	Group.InstanceScales[Slot] = ActorTransform.GetScale3D();
+}
+
+void UNiagaraDestructionDriverInstancingSubsystem::UpdateInstance(FNiagaraDestructionDriverInstanceGroup& Group, const int32 Slot) const
+{
+	const ANiagaraDestructionDriverActor* Owner = Group.Owners[Slot].Get();
+	FTransform Transform = Owner ? Owner->MeshComponent->GetComponentTransform() : FTransform::Identity;
+	if (Owner == nullptr || !Group.InstanceVisible[Slot])
+	{
+		Transform.SetScale3D(FVector::ZeroVector);
+	}
+	Group.MeshComponent->UpdateInstanceTransform(Slot, Transform, true, true, true);
+
+	const FVector4& TileOffsetScale = Group.InstanceTileOffsetScales[Slot];
+	const FQuat& Rotation = Group.InstanceRotations[Slot];
+	float CustomData[FNiagaraDestructionDriverPrimitiveData::Num];
+	CustomData[FNiagaraDestructionDriverPrimitiveData::RT_TileOffsetScale + 0] = TileOffsetScale.X;
+	CustomData[FNiagaraDestructionDriverPrimitiveData::RT_TileOffsetScale + 1] = TileOffsetScale.Y;
+	CustomData[FNiagaraDestructionDriverPrimitiveData::RT_TileOffsetScale + 2] = TileOffsetScale.Z;
+	CustomData[FNiagaraDestructionDriverPrimitiveData::RT_TileOffsetScale + 3] = TileOffsetScale.W;
+	CustomData[FNiagaraDestructionDriverPrimitiveData::ActorRotationQuat + 0] = Rotation.X;
+	CustomData[FNiagaraDestructionDriverPrimitiveData::ActorRotationQuat + 1] = Rotation.Y;
+	CustomData[FNiagaraDestructionDriverPrimitiveData::ActorRotationQuat + 2] = Rotation.Z;
+	CustomData[FNiagaraDestructionDriverPrimitiveData::ActorRotationQuat + 3] = Rotation.W;
+	CustomData[FNiagaraDestructionDriverPrimitiveData::ObjectBoundsScale] = Group.InstanceBoundsScales[Slot];
+	Group.MeshComponent->SetCustomData(Slot, MakeArrayView(CustomData), true);
+}
+
+void UNiagaraDestructionDriverInstancingSubsystem::PushParameters(FNiagaraDestructionDriverInstanceGroup& Group) const
+{
+	const FNiagaraDestructionDriverParameterNames& ParameterNames = FNiagaraDestructionDriverParameterNames::Get();
+	UNiagaraComponent* NiagaraComponent = Group.NiagaraComponent;
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayPosition(NiagaraComponent, ParameterNames.InstanceLocations, Group.InstanceLocations);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayQuat(NiagaraComponent, ParameterNames.InstanceRotations, Group.InstanceRotations);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(NiagaraComponent, ParameterNames.InstanceScales, Group.InstanceScales);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayBool(NiagaraComponent, ParameterNames.InstanceSimulating, Group.InstanceSimulating);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayInt32(NiagaraComponent, ParameterNames.InstanceResetCounts, Group.InstanceResetCounts);
+
+	TArray<FVector> ForceCenters;
+	TArray<float> ForceRadii;
+	TArray<float> ForceStartTimes;
+	TArray<float> ForceDurations;
+	ForceCenters.Reserve(Group.Forces.Num());
+	ForceRadii.Reserve(Group.Forces.Num());
+	ForceStartTimes.Reserve(Group.Forces.Num());
+	ForceDurations.Reserve(Group.Forces.Num());
+	for (const FNiagaraDestructionDriverForce& Force : Group.Forces)
+	{
+		ForceCenters.Add(Force.Origin);
+		ForceRadii.Add(Force.Radius);
+		ForceStartTimes.Add(Force.StartTime);
+		ForceDurations.Add(Force.Duration);
+	}
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayPosition(NiagaraComponent, ParameterNames.ForceCenters, ForceCenters);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayFloat(NiagaraComponent, ParameterNames.ForceRadii, ForceRadii);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayFloat(NiagaraComponent, ParameterNames.ForceStartTimes, ForceStartTimes);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayFloat(NiagaraComponent, ParameterNames.ForceDurations, ForceDurations);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayInt32(NiagaraComponent, ParameterNames.ForceInstances, Group.ForceInstances);
+	Group.bParametersDirty = false;
+}
+
+void UNiagaraDestructionDriverInstancingSubsystem::RemoveForces(FNiagaraDestructionDriverInstanceGroup& Group, const int32 Slot) const
+{
+	for (int32 Idx = Group.ForceInstances.Num() - 1; Idx >= 0; Idx--)
+	{
+		if (Group.ForceInstances[Idx] == Slot)
+		{
+			Group.Forces.RemoveAtSwap(Idx, 1, EAllowShrinking::No);
+			Group.ForceInstances.RemoveAtSwap(Idx, 1, EAllowShrinking::No);
+		}
+	}
+}
+
+void UNiagaraDestructionDriverInstancingSubsystem::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_NDD_InstanceGroups, Groups.Num());
+	SET_DWORD_STAT(STAT_NDD_InstancedDestructibles, GetNumInstances());
+}
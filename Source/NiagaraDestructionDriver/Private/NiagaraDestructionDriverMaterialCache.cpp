@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverMaterialCache.h"
+
+#include "NiagaraDestructionDriverHelper.h"
+#include "NiagaraDestructionDriverRuntimeContext.h"
+#include "Engine/Texture2D.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Materials/MaterialInstanceDynamic.h"
+
+UMaterialInstanceDynamic* UNiagaraDestructionDriverMaterialCache::AcquireMaterial(UMaterialInterface* SlotMaterial, const FNiagaraDestructionDriverRuntimeContext& Context,
+	UTextureRenderTarget2D* PositionsTexture, UTextureRenderTarget2D* RotationsTexture, UTexture* BoneScaleMask)
+{
+	FNiagaraDestructionDriverMaterialKey Key;
+	Key.SlotMaterial = SlotMaterial;
+	Key.PositionsTexture = PositionsTexture;
+	Key.RotationsTexture = RotationsTexture;
+	Key.InitialBoneLocationsTexture = Context.InitialBoneLocationsTexture;
+	Key.BoneScaleMask = BoneScaleMask;
+
+	FNiagaraDestructionDriverSharedMaterial& SharedMaterial = Materials.FindOrAdd(Key);
+	if (SharedMaterial.Material == nullptr)
+	{
+		// only the values every user agrees on, per actor values are custom primitive data
+		const FNiagaraDestructionDriverParameterNames& ParameterNames = FNiagaraDestructionDriverParameterNames::Get();
+		UMaterialInstanceDynamic* DynamicMaterial = UMaterialInstanceDynamic::Create(SlotMaterial, this);
+		DynamicMaterial->SetScalarParameterValue(ParameterNames.RT_Size, Context.RenderTargetTextureSize);
+		DynamicMaterial->SetTextureParameterValue(ParameterNames.RT_Position, PositionsTexture);
+		DynamicMaterial->SetTextureParameterValue(ParameterNames.RT_Rotation, RotationsTexture);
+		DynamicMaterial->SetTextureParameterValue(ParameterNames.InitialBoneLocations, Context.InitialBoneLocationsTexture);
+		DynamicMaterial->SetVectorParameterValue(ParameterNames.MeshHalfExtents, Context.MeshHalfExtents);
+		if (BoneScaleMask)
+		{
+			DynamicMaterial->SetTextureParameterValue(ParameterNames.BoneScaleMask, BoneScaleMask);
+		}
+		SharedMaterial.Material = DynamicMaterial;
+	}
+	SharedMaterial.NumUsers++;
+	return SharedMaterial.Material;
+}
+
+void UNiagaraDestructionDriverMaterialCache::ReleaseMaterial(UMaterialInstanceDynamic* Material)
+{
+	if (Material == nullptr)
+	{
+		return;
+	}
+
+	for (auto It = Materials.CreateIterator(); It; ++It)
+	{
+		if (It->Value.Material == Material)
+		{
+			if (--It->Value.NumUsers <= 0)
+			{
+				// also lets go of the render targets / atlas page it binds
+				It.RemoveCurrent();
+			}
+			return;
+		}
+	}
+}
+
+void UNiagaraDestructionDriverMaterialCache::Deinitialize()
+{
+	Materials.Empty();
+	Super::Deinitialize();
+}
+
+bool UNiagaraDestructionDriverMaterialCache::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// nothing is rendered on dedicated servers / -nullrhi
+	return Super::ShouldCreateSubsystem(Outer) && UNiagaraDestructionDriverHelper::ShouldCreateRenderResources(Outer);
+}
+
+bool UNiagaraDestructionDriverMaterialCache::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
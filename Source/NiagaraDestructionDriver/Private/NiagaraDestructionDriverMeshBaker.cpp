@@ -0,0 +1,154 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverMeshBaker.h"
+
+#include "NiagaraDestructionDriver.h"
+#include "NiagaraDestructionDriverDataAsset.h"
+#include "StaticMeshAttributes.h"
+#include "StaticMeshResources.h"
+#include "Engine/StaticMesh.h"
+
+namespace NiagaraDestructionDriverMeshBaker
+{
+	FVector3f ToVector(const FFloat16Color& Color)
+	{
+		return FVector3f(Color.R.GetFloat(), Color.G.GetFloat(), Color.B.GetFloat());
+	}
+
+	FQuat4f ToQuat(const FFloat16Color& Color)
+	{
+		const FQuat4f Rotation(Color.R.GetFloat(), Color.G.GetFloat(), Color.B.GetFloat(), Color.A.GetFloat());
+		// bones the simulation never wrote to keep their rest rotation
+		return Rotation.SizeSquared() > UE_SMALL_NUMBER ? Rotation.GetNormalized() : FQuat4f::Identity;
+	}
+}
+
+bool FNiagaraDestructionDriverMeshBaker::CanBake(const UNiagaraDestructionDriverDataAsset* DataAsset)
+{
+	// the source mesh is streamed, it has to be loaded to bake
+	if (DataAsset == nullptr || DataAsset->StaticMesh.Get() == nullptr || DataAsset->InitialBoneLocations.Num() == 0 || DataAsset->BakedMaterials.Num() == 0)
+	{
+		return false;
+	}
+
+	const FStaticMeshRenderData* RenderData = DataAsset->StaticMesh.Get()->GetRenderData();
+	if (RenderData == nullptr || RenderData->LODResources.Num() == 0)
+	{
+		return false;
+	}
+
+	// the vertex and index data only stays on the CPU with bAllowCPUAccess
+	const FStaticMeshLODResources& LOD = RenderData->LODResources[0];
+	return LOD.VertexBuffers.PositionVertexBuffer.GetVertexData() != nullptr
+		&& LOD.VertexBuffers.StaticMeshVertexBuffer.GetTangentData() != nullptr
+		&& LOD.VertexBuffers.StaticMeshVertexBuffer.GetTexCoordData() != nullptr
+		&& static_cast<int32>(LOD.VertexBuffers.StaticMeshVertexBuffer.GetNumTexCoords()) > DataAsset->CustomUVChannelIndex
+		&& LOD.IndexBuffer.GetNumIndices() > 0;
+}
+
+UStaticMesh* FNiagaraDestructionDriverMeshBaker::BakeStaticMesh(UObject* Outer, const UNiagaraDestructionDriverDataAsset* DataAsset, const TArray<FFloat16Color>& BonePositions, const TArray<FFloat16Color>& BoneRotations, const TBitArray<>& RemovedBones)
+{
+	using namespace NiagaraDestructionDriverMeshBaker;
+
+	if (!CanBake(DataAsset))
+	{
+		return nullptr;
+	}
+
+	const UStaticMesh* SourceMesh = DataAsset->StaticMesh.Get();
+	const FStaticMeshLODResources& LOD = SourceMesh->GetRenderData()->LODResources[0];
+	const FPositionVertexBuffer& PositionBuffer = LOD.VertexBuffers.PositionVertexBuffer;
+	const FStaticMeshVertexBuffer& VertexBuffer = LOD.VertexBuffers.StaticMeshVertexBuffer;
+	const int32 NumVertices = PositionBuffer.GetNumVertices();
+	const int32 NumTexCoords = VertexBuffer.GetNumTexCoords();
+	const int32 NumBones = DataAsset->InitialBoneLocations.Num();
+	if (BonePositions.Num() < NumBones || BoneRotations.Num() < NumBones)
+	{
+		UE_LOG(LogNiagaraDestructionDriver, Warning, TEXT("Can't bake %s, the read back render targets hold %d bones but the mesh has %d."), *SourceMesh->GetName(), FMath::Min(BonePositions.Num(), BoneRotations.Num()), NumBones);
+		return nullptr;
+	}
+
+	// same space the niagara system simulates in, see FNiagaraDestructionDriverRuntimeContext
+	const FVector3f HalfExtents = FVector3f(SourceMesh->GetBoundingBox().GetExtent());
+	const FVector3f MeshCenter = FVector3f(-DataAsset->PivotOffset);
+
+	FMeshDescription MeshDescription;
+	FStaticMeshAttributes Attributes(MeshDescription);
+	Attributes.Register();
+
+	TVertexAttributesRef<FVector3f> VertexPositions = Attributes.GetVertexPositions();
+	TVertexInstanceAttributesRef<FVector3f> InstanceNormals = Attributes.GetVertexInstanceNormals();
+	TVertexInstanceAttributesRef<FVector3f> InstanceTangents = Attributes.GetVertexInstanceTangents();
+	TVertexInstanceAttributesRef<float> InstanceBinormalSigns = Attributes.GetVertexInstanceBinormalSigns();
+	TVertexInstanceAttributesRef<FVector2f> InstanceUVs = Attributes.GetVertexInstanceUVs();
+	TPolygonGroupAttributesRef<FName> PolygonGroupSlotNames = Attributes.GetPolygonGroupMaterialSlotNames();
+	InstanceUVs.SetNumChannels(NumTexCoords);
+
+	TArray<int32> VertexBones;
+	VertexBones.SetNumUninitialized(NumVertices);
+	MeshDescription.ReserveNewVertices(NumVertices);
+	MeshDescription.ReserveNewVertexInstances(NumVertices);
+	for (int32 VertexIdx = 0; VertexIdx < NumVertices; VertexIdx++)
+	{
+		const int32 BoneIndex = FMath::Clamp(FMath::RoundToInt(VertexBuffer.GetVertexUV(VertexIdx, DataAsset->CustomUVChannelIndex).X * NumBones), 0, NumBones - 1);
+		VertexBones[VertexIdx] = BoneIndex;
+		const FVector3f RestBoneLocation = DataAsset->InitialBoneLocations[BoneIndex] * HalfExtents + MeshCenter;
+		const FVector3f BoneLocation = ToVector(BonePositions[BoneIndex]) * HalfExtents + MeshCenter;
+		const FQuat4f BoneRotation = ToQuat(BoneRotations[BoneIndex]);
+
+		const FVertexID VertexID = MeshDescription.CreateVertex();
+		VertexPositions[VertexID] = BoneLocation + BoneRotation.RotateVector(PositionBuffer.VertexPosition(VertexIdx) - RestBoneLocation);
+
+		const FVertexInstanceID InstanceID = MeshDescription.CreateVertexInstance(VertexID);
+		const FVector4f TangentZ = VertexBuffer.VertexTangentZ(VertexIdx);
+		InstanceNormals[InstanceID] = BoneRotation.RotateVector(FVector3f(TangentZ));
+		InstanceTangents[InstanceID] = BoneRotation.RotateVector(FVector3f(VertexBuffer.VertexTangentX(VertexIdx)));
+		InstanceBinormalSigns[InstanceID] = TangentZ.W < 0.f ? -1.f : 1.f;
+		for (int32 UVIdx = 0; UVIdx < NumTexCoords; UVIdx++)
+		{
+			InstanceUVs.Set(InstanceID, UVIdx, VertexBuffer.GetVertexUV(VertexIdx, UVIdx));
+		}
+	}
+
+	// one polygon group per section, keeping the material slots of the source mesh
+	TArray<FStaticMaterial> StaticMaterials = SourceMesh->GetStaticMaterials();
+	for (const FStaticMeshSection& Section : LOD.Sections)
+	{
+		const FPolygonGroupID PolygonGroupID = MeshDescription.CreatePolygonGroup();
+		PolygonGroupSlotNames[PolygonGroupID] = StaticMaterials.IsValidIndex(Section.MaterialIndex) ? StaticMaterials[Section.MaterialIndex].ImportedMaterialSlotName : NAME_None;
+		for (uint32 TriangleIdx = 0; TriangleIdx < Section.NumTriangles; TriangleIdx++)
+		{
+			const uint32 FirstIndex = Section.FirstIndex + TriangleIdx * 3;
+			const int32 BoneIndex = VertexBones[LOD.IndexBuffer.GetIndex(FirstIndex)];
+			if (RemovedBones.IsValidIndex(BoneIndex) && RemovedBones[BoneIndex])
+			{
+				continue;
+			}
+			const FVertexInstanceID TriangleInstances[3] = {
+				FVertexInstanceID(LOD.IndexBuffer.GetIndex(FirstIndex + 0)),
+				FVertexInstanceID(LOD.IndexBuffer.GetIndex(FirstIndex + 1)),
+				FVertexInstanceID(LOD.IndexBuffer.GetIndex(FirstIndex + 2))
+			};
+			MeshDescription.CreateTriangle(PolygonGroupID, TriangleInstances);
+		}
+	}
+
+	// the baked mesh only references the WPO free materials
+	for (int32 Idx = 0; Idx < StaticMaterials.Num(); Idx++)
+	{
+		if (DataAsset->BakedMaterials.IsValidIndex(Idx) && DataAsset->BakedMaterials[Idx] != nullptr)
+		{
+			StaticMaterials[Idx].MaterialInterface = DataAsset->BakedMaterials[Idx];
+		}
+	}
+
+	UStaticMesh* BakedMesh = NewObject<UStaticMesh>(Outer ? Outer : GetTransientPackage(), NAME_None, RF_Transient);
+	BakedMesh->SetStaticMaterials(StaticMaterials);
+
+	UStaticMesh::FBuildMeshDescriptionsParams BuildParams;
+	BuildParams.bBuildSimpleCollision = false;
+	BuildParams.bFastBuild = true;
+	BakedMesh->BuildFromMeshDescriptions({ &MeshDescription }, BuildParams);
+	return BakedMesh;
+}
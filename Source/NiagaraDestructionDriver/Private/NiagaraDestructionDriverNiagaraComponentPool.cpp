@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverNiagaraComponentPool.h"
+
+#include "NiagaraComponent.h"
+#include "NiagaraDestructionDriver.h"
+#include "NiagaraDestructionDriverActor.h"
+#include "NiagaraDestructionDriverHelper.h"
+#include "NiagaraDestructionDriverRuntimeContext.h"
+#include "NiagaraDestructionDriverSettings.h"
+#include "NiagaraSystem.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("NDD Pooled Niagara Components In Use"), STAT_NDD_PooledNiagaraComponentsInUse, STATGROUP_NiagaraDestructionDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("NDD Pooled Niagara Components Free"), STAT_NDD_PooledNiagaraComponentsFree, STATGROUP_NiagaraDestructionDriver);
+
+UNiagaraComponent* UNiagaraDestructionDriverNiagaraComponentPool::AcquireComponent(ANiagaraDestructionDriverActor* Destructible, UNiagaraSystem* System)
+{
+	if (System == nullptr)
+	{
+		return nullptr;
+	}
+
+	// every eviction frees a component, and below the limit one is created
+	UNiagaraComponent* Component = TakeFreeComponent(System);
+	while (Component == nullptr && Borrowed.Num() > 0)
+	{
+		EvictOldestBorrower();
+		Component = TakeFreeComponent(System);
+	}
+
+	FNiagaraDestructionDriverBorrowedNiagaraComponent& Entry = Borrowed.AddDefaulted_GetRef();
+	Entry.Component = Component;
+	Entry.Destructible = Destructible;
+	Stats.NumInUse++;
+	Stats.PeakResidency = FMath::Max(Stats.PeakResidency, Stats.NumInUse + Stats.NumFree);
+	UpdateStats();
+	return Component;
+}
+
+void UNiagaraDestructionDriverNiagaraComponentPool::ReleaseComponent(UNiagaraComponent* Component)
+{
+	const int32 BorrowedIdx = Component ? Borrowed.IndexOfByPredicate([Component](const FNiagaraDestructionDriverBorrowedNiagaraComponent& Entry)
+	{
+		return Entry.Component == Component;
+	}) : INDEX_NONE;
+	if (BorrowedIdx == INDEX_NONE)
+	{
+		return;
+	}
+	// keep the lending order, the oldest borrower is evicted first
+	Borrowed.RemoveAt(BorrowedIdx);
+	Stats.NumInUse--;
+
+	// the user parameters would keep the streamed assets and the destructible's render targets alive
+	const FNiagaraDestructionDriverParameterNames& ParameterNames = FNiagaraDestructionDriverParameterNames::Get();
+	Component->DeactivateImmediate();
+	Component->SetPaused(false);
+	Component->SetCustomTimeDilation(1.f);
+	Component->SetVariableStaticMesh(ParameterNames.DestructibleMesh, nullptr);
+	Component->SetVariableTexture(ParameterNames.InitialBonePositionsTexture, nullptr);
+	Component->SetVariableTextureRenderTarget(ParameterNames.SimulatedParticlePositionsOut, nullptr);
+	Component->SetVariableTextureRenderTarget(ParameterNames.SimulatedParticleRotationsOut, nullptr);
+	Component->AttachToComponent(ComponentOwner->GetRootComponent(), FAttachmentTransformRules::SnapToTargetIncludingScale);
+
+	Buckets.FindOrAdd(Component->GetAsset()).FreeComponents.Add(Component);
+	Stats.NumFree++;
+	UpdateStats();
+}
+
+void UNiagaraDestructionDriverNiagaraComponentPool::DumpPoolStats() const
+{
+	UE_LOG(LogNiagaraDestructionDriver, Display, TEXT("Niagara component pool: %d hits, %d misses, %d evictions, %d in use, %d free, peak residency %d (limit %d), %d systems"),
+			Stats.Hits,
+			Stats.Misses,
+			Stats.Evictions,
+			Stats.NumInUse,
+			Stats.NumFree,
+			Stats.PeakResidency,
+			GetDefault<UNiagaraDestructionDriverSettings>()->MaxPooledNiagaraComponents,
+			Buckets.Num());
+}
+
+void UNiagaraDestructionDriverNiagaraComponentPool::Deinitialize()
+{
+	Buckets.Empty();
+	Borrowed.Empty();
+	ComponentOwner = nullptr;
+	Stats = FNiagaraDestructionDriverNiagaraComponentPoolStats();
+	UpdateStats();
+	Super::Deinitialize();
+}
+
+bool UNiagaraDestructionDriverNiagaraComponentPool::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// headless destructibles never simulate
+	return Super::ShouldCreateSubsystem(Outer) && UNiagaraDestructionDriverHelper::ShouldCreateRenderResources(Outer);
+}
+
+bool UNiagaraDestructionDriverNiagaraComponentPool::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UNiagaraComponent* UNiagaraDestructionDriverNiagaraComponentPool::TakeFreeComponent(UNiagaraSystem* System)
+{
+	FNiagaraDestructionDriverNiagaraComponentBucket* Bucket = Buckets.Find(System);
+	if (Bucket && Bucket->FreeComponents.Num() > 0)
+	{
+		Stats.Hits++;
+		Stats.NumFree--;
+		return Bucket->FreeComponents.Pop();
+	}
+
+	// at the limit, a free component of another system is switched over instead of creating one more
+	const int32 MaxComponents = FMath::Max(GetDefault<UNiagaraDestructionDriverSettings>()->MaxPooledNiagaraComponents, 1);
+	if (Stats.NumInUse + Stats.NumFree >= MaxComponents)
+	{
+		for (TPair<TObjectPtr<UNiagaraSystem>, FNiagaraDestructionDriverNiagaraComponentBucket>& Pair : Buckets)
+		{
+			if (Pair.Value.FreeComponents.Num() > 0)
+			{
+				UNiagaraComponent* Component = Pair.Value.FreeComponents.Pop();
+				Component->SetAsset(System);
+				Stats.Misses++;
+				Stats.NumFree--;
+				return Component;
+			}
+		}
+		return nullptr;
+	}
+
+	if (ComponentOwner == nullptr)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		ComponentOwner = GetWorld()->SpawnActor<AActor>(SpawnParams);
+		USceneComponent* Root = NewObject<USceneComponent>(ComponentOwner, TEXT("Root"));
+		ComponentOwner->SetRootComponent(Root);
+		Root->RegisterComponent();
+	}
+
+	UNiagaraComponent* Component = NewObject<UNiagaraComponent>(ComponentOwner);
+	Component->SetAutoActivate(false);
+	Component->SetAsset(System);
+	Component->SetupAttachment(ComponentOwner->GetRootComponent());
+	Component->RegisterComponent();
+	Stats.Misses++;
+	return Component;
+}
+
+void UNiagaraDestructionDriverNiagaraComponentPool::EvictOldestBorrower()
+{
+	const FNiagaraDestructionDriverBorrowedNiagaraComponent Oldest = Borrowed[0];
+	if (ANiagaraDestructionDriverActor* Destructible = Oldest.Destructible.Get())
+	{
+		// not settled: its fragments stay where the render targets have them, it still takes forces and borrows again on the next one
+		UE_LOG(LogNiagaraDestructionDriver, Verbose, TEXT("Niagara component pool is full (%d), taking the component of %s back early."), Borrowed.Num(), *Destructible->GetName());
+		Destructible->ReturnNiagaraComponent();
+	}
+	Stats.Evictions++;
+
+	// destroyed without giving it back, take it back anyway
+	if (Borrowed.Num() > 0 && Borrowed[0].Component == Oldest.Component)
+	{
+		ReleaseComponent(Oldest.Component);
+	}
+}
+
+void UNiagaraDestructionDriverNiagaraComponentPool::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_NDD_PooledNiagaraComponentsInUse, Stats.NumInUse);
+	SET_DWORD_STAT(STAT_NDD_PooledNiagaraComponentsFree, Stats.NumFree);
+}
@@ -0,0 +1,328 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverPrewarmSubsystem.h"
+
+#include "CVars.h"
+#include "NiagaraComponent.h"
+#include "NiagaraDestructionDriver.h"
+#include "NiagaraDestructionDriverActor.h"
+#include "NiagaraDestructionDriverAssetLoader.h"
+#include "NiagaraDestructionDriverDataAsset.h"
+#include "NiagaraDestructionDriverHelper.h"
+#include "NiagaraDestructionDriverRenderTargetPool.h"
+#include "NiagaraDestructionDriverRuntimeContext.h"
+#include "NiagaraDestructionDriverSettings.h"
+#include "NiagaraFunctionLibrary.h"
+#include "LocalVertexFactory.h"
+#include "PSOPrecache.h"
+#include "TimerManager.h"
+#include "Engine/GameInstance.h"
+#include "Engine/Level.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Engine/World.h"
+#include "Materials/MaterialInterface.h"
+
+void UNiagaraDestructionDriverPrewarmSubsystem::PrewarmDataAssets(const TArray<UNiagaraDestructionDriverDataAsset*>& DataAssets)
+{
+	TArray<TWeakObjectPtr<UNiagaraDestructionDriverDataAsset>> DataAssetsToPrewarm;
+	TArray<FSoftObjectPath> AssetsToLoad;
+	for (UNiagaraDestructionDriverDataAsset* DataAsset : DataAssets)
+	{
+		bool bAlreadyPrewarmed = false;
+		if (DataAsset == nullptr || DataAsset->StaticMesh.IsNull())
+		{
+			continue;
+		}
+		PrewarmedDataAssets.Add(DataAsset, &bAlreadyPrewarmed);
+		if (bAlreadyPrewarmed)
+		{
+			continue;
+		}
+		DataAssetsToPrewarm.Add(DataAsset);
+		DataAsset->GetDestructionAssetPaths(AssetsToLoad);
+	}
+	if (DataAssetsToPrewarm.Num() == 0)
+	{
+		return;
+	}
+	if (CVarNDD_DebugMaterial.GetValueOnGameThread() == 1)
+	{
+		AssetsToLoad.AddUnique(GetDefault<UNiagaraDestructionDriverSettings>()->DebugMaterialForNiagaraDestructibles.ToSoftObjectPath());
+	}
+
+	UNiagaraDestructionDriverAssetLoader* AssetLoader = GetAssetLoader();
+	if (AssetLoader == nullptr)
+	{
+		for (const FSoftObjectPath& AssetPath : AssetsToLoad)
+		{
+			AssetPath.TryLoad();
+		}
+		PrewarmLoadedDataAssets(MoveTemp(DataAssetsToPrewarm));
+		return;
+	}
+
+	// the mesh is only needed while prewarming, FinishWarmingSystems lets it stream out again.
+	// Tracked right away, Deinitialize releases them if the world goes away while the load is in flight
+	for (const TWeakObjectPtr<UNiagaraDestructionDriverDataAsset>& DataAsset : DataAssetsToPrewarm)
+	{
+		AssetLoader->RetainStreamedAssets(DataAsset.Get());
+		LoadingDataAssets.Add(DataAsset.Get());
+	}
+
+	// shares the loads with destructibles activating in the meantime
+	AssetLoader->RequestAssets(AssetsToLoad, FSimpleDelegate::CreateWeakLambda(this, [this, DataAssetsToPrewarm]()
+	{
+		PrewarmLoadedDataAssets(DataAssetsToPrewarm);
+	}));
+}
+
+void UNiagaraDestructionDriverPrewarmSubsystem::PrewarmLoadedDataAssets(TArray<TWeakObjectPtr<UNiagaraDestructionDriverDataAsset>> DataAssets)
+{
+	for (const TWeakObjectPtr<UNiagaraDestructionDriverDataAsset>& WeakDataAsset : DataAssets)
+	{
+		UNiagaraDestructionDriverDataAsset* DataAsset = WeakDataAsset.Get();
+		if (DataAsset == nullptr)
+		{
+			continue;
+		}
+		if (LoadingDataAssets.Remove(DataAsset) > 0)
+		{
+			RetainedDataAssets.Add(DataAsset);
+		}
+		PrecacheMaterialPSOs(DataAsset);
+		if (GetDefault<UNiagaraDestructionDriverSettings>()->bPrewarmNiagaraSystems)
+		{
+			WarmNiagaraSystem(DataAsset);
+		}
+		Stats.NumDataAssetsPrewarmed++;
+	}
+
+	// one timer for the whole batch, restarted by each new batch
+	GetWorld()->GetTimerManager().SetTimer(WarmingTimerHandle, this, &UNiagaraDestructionDriverPrewarmSubsystem::FinishWarmingSystems,
+		GetDefault<UNiagaraDestructionDriverSettings>()->NiagaraWarmupDuration, false);
+}
+
+void UNiagaraDestructionDriverPrewarmSubsystem::PrecacheMaterialPSOs(UNiagaraDestructionDriverDataAsset* DataAsset)
+{
+	if (!IsComponentPSOPrecachingEnabled() && !IsResourcePSOPrecachingEnabled())
+	{
+		return;
+	}
+
+	// every material the destructible mesh can render with: the WPO driven slot materials and, when baking, the baked ones
+	TArray<UMaterialInterface*, TInlineAllocator<8>> Materials;
+	for (UMaterialInterface* SlotMaterial : DataAsset->GetRuntimeContext().SlotMaterials)
+	{
+		Materials.AddUnique(SlotMaterial);
+	}
+	if (GetDefault<UNiagaraDestructionDriverSettings>()->bBakeSettledDestructibles)
+	{
+		for (UMaterialInterface* BakedMaterial : DataAsset->BakedMaterials)
+		{
+			Materials.AddUnique(BakedMaterial);
+		}
+	}
+	if (CVarNDD_DebugMaterial.GetValueOnGameThread() == 1)
+	{
+		// loaded with the batch, never synchronously during level load
+		Materials.AddUnique(GetDefault<UNiagaraDestructionDriverSettings>()->DebugMaterialForNiagaraDestructibles.Get());
+	}
+
+	// destructibles are movable static meshes, dynamic materials render with their parent's shaders
+	FPSOPrecacheParams PrecacheParams;
+	PrecacheParams.SetMobility(EComponentMobility::Movable);
+	FPSOPrecacheVertexFactoryDataList VertexFactoryDataList;
+	VertexFactoryDataList.Add(FPSOPrecacheVertexFactoryData(&FLocalVertexFactory::StaticType));
+
+	FGraphEventArray& Events = PrecacheEvents.FindOrAdd(DataAsset);
+	for (UMaterialInterface* Material : Materials)
+	{
+		if (Material == nullptr)
+		{
+			continue;
+		}
+		TArray<FMaterialPSOPrecacheRequestID> RequestIDs;
+		Events.Append(Material->PrecachePSOs(VertexFactoryDataList, PrecacheParams, EPSOPrecachePriority::High, RequestIDs));
+		Stats.NumMaterialPSORequests += RequestIDs.Num();
+	}
+}
+
+void UNiagaraDestructionDriverPrewarmSubsystem::WarmNiagaraSystem(UNiagaraDestructionDriverDataAsset* DataAsset)
+{
+	const FNiagaraDestructionDriverRuntimeContext& Context = DataAsset->GetRuntimeContext();
+	if (Context.ParticleSystem == nullptr || Context.RenderTargetTextureSize <= 0)
+	{
+		return;
+	}
+
+	// same setup as ANiagaraDestructionDriverActor::FinishActivation, on render targets nobody reads
+	FNiagaraDestructionDriverWarmingSystem WarmingSystem;
+	UNiagaraDestructionDriverRenderTargetPool* Pool = GetWorld()->GetSubsystem<UNiagaraDestructionDriverRenderTargetPool>();
+	WarmingSystem.PositionsTexture = Pool ? Pool->AcquireRenderTarget(Context.RenderTargetTextureSize) : UNiagaraDestructionDriverHelper::CreateSimulationRenderTarget(this, Context.RenderTargetTextureSize);
+	WarmingSystem.RotationsTexture = Pool ? Pool->AcquireRenderTarget(Context.RenderTargetTextureSize) : UNiagaraDestructionDriverHelper::CreateSimulationRenderTarget(this, Context.RenderTargetTextureSize);
+	WarmingSystem.NiagaraComponent = UNiagaraFunctionLibrary::SpawnSystemAtLocation(GetWorld(), Context.ParticleSystem, FVector::ZeroVector, FRotator::ZeroRotator,
+		FVector::OneVector, false, false, ENCPoolMethod::None, false);
+	if (WarmingSystem.NiagaraComponent == nullptr)
+	{
+		if (Pool)
+		{
+			Pool->ReleaseRenderTarget(WarmingSystem.PositionsTexture);
+			Pool->ReleaseRenderTarget(WarmingSystem.RotationsTexture);
+		}
+		return;
+	}
+
+	const FNiagaraDestructionDriverParameterNames& ParameterNames = FNiagaraDestructionDriverParameterNames::Get();
+	UNiagaraComponent* NiagaraComponent = WarmingSystem.NiagaraComponent;
+	NiagaraComponent->SetVariableStaticMesh(ParameterNames.DestructibleMesh, Context.StaticMesh);
+	NiagaraComponent->SetVariableTexture(ParameterNames.InitialBonePositionsTexture, Context.InitialBoneLocationsTexture);
+	NiagaraComponent->SetVariableTextureRenderTarget(ParameterNames.SimulatedParticlePositionsOut, WarmingSystem.PositionsTexture);
+	NiagaraComponent->SetVariableTextureRenderTarget(ParameterNames.SimulatedParticleRotationsOut, WarmingSystem.RotationsTexture);
+	NiagaraComponent->SetVariableVec4(ParameterNames.RenderTargetTileOffsetScale, FVector4(0.f, 0.f, 1.f, 1.f));
+	NiagaraComponent->SetVariableVec3(ParameterNames.DestructibleMeshLocalHalfExtents, Context.MeshHalfExtents);
+	NiagaraComponent->Activate(true);
+	WarmingSystems.Add(WarmingSystem);
+	Stats.NumNiagaraSystemsWarmed++;
+}
+
+void UNiagaraDestructionDriverPrewarmSubsystem::FinishWarmingSystems()
+{
+	UNiagaraDestructionDriverRenderTargetPool* Pool = GetWorld() ? GetWorld()->GetSubsystem<UNiagaraDestructionDriverRenderTargetPool>() : nullptr;
+	for (const FNiagaraDestructionDriverWarmingSystem& WarmingSystem : WarmingSystems)
+	{
+		if (WarmingSystem.NiagaraComponent)
+		{
+			WarmingSystem.NiagaraComponent->DeactivateImmediate();
+			WarmingSystem.NiagaraComponent->DestroyComponent();
+		}
+		if (Pool)
+		{
+			Pool->ReleaseRenderTarget(WarmingSystem.PositionsTexture);
+			Pool->ReleaseRenderTarget(WarmingSystem.RotationsTexture);
+		}
+	}
+	WarmingSystems.Empty();
+
+	if (UNiagaraDestructionDriverAssetLoader* AssetLoader = GetAssetLoader())
+	{
+		for (UNiagaraDestructionDriverDataAsset* DataAsset : RetainedDataAssets)
+		{
+			AssetLoader->ReleaseStreamedAssets(DataAsset);
+		}
+	}
+	RetainedDataAssets.Empty();
+}
+
+UNiagaraDestructionDriverAssetLoader* UNiagaraDestructionDriverPrewarmSubsystem::GetAssetLoader() const
+{
+	const UGameInstance* GameInstance = GetWorld() ? GetWorld()->GetGameInstance() : nullptr;
+	return GameInstance ? GameInstance->GetSubsystem<UNiagaraDestructionDriverAssetLoader>() : nullptr;
+}
+
+void UNiagaraDestructionDriverPrewarmSubsystem::NoteActivation(const UNiagaraDestructionDriverDataAsset* DataAsset)
+{
+	if (!PrewarmedDataAssets.Contains(DataAsset))
+	{
+		Stats.NumColdActivations++;
+		UE_LOG(LogNiagaraDestructionDriver, Verbose, TEXT("Cold activation of destructible data asset %s, it was not prewarmed."), *GetNameSafe(DataAsset));
+		return;
+	}
+
+	if (FGraphEventArray* Events = PrecacheEvents.Find(DataAsset))
+	{
+		Events->RemoveAll([](const FGraphEventRef& Event)
+		{
+			return !Event.IsValid() || Event->IsComplete();
+		});
+		if (Events->Num() > 0)
+		{
+			Stats.NumActivationsWhileCompiling++;
+			return;
+		}
+	}
+	Stats.NumWarmActivations++;
+}
+
+void UNiagaraDestructionDriverPrewarmSubsystem::DumpPrewarmStats() const
+{
+	UE_LOG(LogNiagaraDestructionDriver, Display, TEXT("Destructible prewarm: %d data assets, %d material PSO requests, %d niagara systems warmed. Activations: %d warm, %d while compiling, %d cold."),
+			Stats.NumDataAssetsPrewarmed,
+			Stats.NumMaterialPSORequests,
+			Stats.NumNiagaraSystemsWarmed,
+			Stats.NumWarmActivations,
+			Stats.NumActivationsWhileCompiling,
+			Stats.NumColdActivations);
+}
+
+void UNiagaraDestructionDriverPrewarmSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UNiagaraDestructionDriverPrewarmSubsystem::OnLevelAddedToWorld);
+}
+
+void UNiagaraDestructionDriverPrewarmSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FinishWarmingSystems();
+	if (UNiagaraDestructionDriverAssetLoader* AssetLoader = GetAssetLoader())
+	{
+		for (UNiagaraDestructionDriverDataAsset* DataAsset : LoadingDataAssets)
+		{
+			AssetLoader->ReleaseStreamedAssets(DataAsset);
+		}
+	}
+	LoadingDataAssets.Empty();
+	PrewarmedDataAssets.Empty();
+	PrecacheEvents.Empty();
+	Stats = FNiagaraDestructionDriverPrewarmStats();
+	Super::Deinitialize();
+}
+
+void UNiagaraDestructionDriverPrewarmSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+	for (const ULevel* Level : InWorld.GetLevels())
+	{
+		PrewarmLevel(Level);
+	}
+}
+
+void UNiagaraDestructionDriverPrewarmSubsystem::OnLevelAddedToWorld(ULevel* Level, UWorld* World)
+{
+	if (World == GetWorld() && World->HasBegunPlay())
+	{
+		PrewarmLevel(Level);
+	}
+}
+
+void UNiagaraDestructionDriverPrewarmSubsystem::PrewarmLevel(const ULevel* Level)
+{
+	if (Level == nullptr)
+	{
+		return;
+	}
+
+	TArray<UNiagaraDestructionDriverDataAsset*> DataAssets;
+	for (const AActor* Actor : Level->Actors)
+	{
+		if (const ANiagaraDestructionDriverActor* Destructible = Cast<ANiagaraDestructionDriverActor>(Actor))
+		{
+			DataAssets.AddUnique(Destructible->NiagaraDestructionDriverParams);
+		}
+	}
+	PrewarmDataAssets(DataAssets);
+}
+
+bool UNiagaraDestructionDriverPrewarmSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// nothing to prewarm without rendering
+	return Super::ShouldCreateSubsystem(Outer)
+		&& GetDefault<UNiagaraDestructionDriverSettings>()->bPrewarmDestructibles
+		&& UNiagaraDestructionDriverHelper::ShouldCreateRenderResources(Outer);
+}
+
+bool UNiagaraDestructionDriverPrewarmSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -0,0 +1,132 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverProxySubsystem.h"
+
+#include "NiagaraDestructionDriver.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("NDD Proxies"), STAT_NDD_Proxies, STATGROUP_NiagaraDestructionDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("NDD Proxy Batches"), STAT_NDD_ProxyBatches, STATGROUP_NiagaraDestructionDriver);
+
+int32 UNiagaraDestructionDriverProxySubsystem::FindOrAddBatch(const UStaticMeshComponent* Template)
+{
+	const int32 ExistingIndex = Batches.IndexOfByPredicate([Template](const FNiagaraDestructionDriverProxyBatch& Batch)
+	{
+		return Batch.Component->GetStaticMesh() == Template->GetStaticMesh()
+			&& Batch.Component->OverrideMaterials == Template->OverrideMaterials
+			&& Batch.Component->GetCollisionProfileName() == Template->GetCollisionProfileName()
+			&& Batch.Component->CastShadow == Template->CastShadow;
+	});
+	if (ExistingIndex != INDEX_NONE)
+	{
+		return ExistingIndex;
+	}
+
+	if (BatchOwner == nullptr)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		BatchOwner = GetWorld()->SpawnActor<AActor>(SpawnParams);
+		USceneComponent* Root = NewObject<USceneComponent>(BatchOwner, TEXT("Root"));
+		BatchOwner->SetRootComponent(Root);
+		Root->RegisterComponent();
+	}
+
+	// instances are added in world space under an identity root, removal swaps the last instance in (see RemoveProxy)
+	UInstancedStaticMeshComponent* Component = NewObject<UInstancedStaticMeshComponent>(BatchOwner);
+	Component->bSupportRemoveAtSwap = true;
+	Component->SetStaticMesh(Template->GetStaticMesh());
+	for (int32 MaterialIdx = 0; MaterialIdx < Template->OverrideMaterials.Num(); MaterialIdx++)
+	{
+		Component->SetMaterial(MaterialIdx, Template->OverrideMaterials[MaterialIdx]);
+	}
+	Component->SetCollisionProfileName(Template->GetCollisionProfileName());
+	Component->SetCastShadow(Template->CastShadow);
+	Component->SetupAttachment(BatchOwner->GetRootComponent());
+	Component->RegisterComponent();
+
+	FNiagaraDestructionDriverProxyBatch& Batch = Batches.AddDefaulted_GetRef();
+	Batch.Component = Component;
+	UpdateStats();
+	return Batches.Num() - 1;
+}
+
+int32 UNiagaraDestructionDriverProxySubsystem::AddProxy(const int32 BatchIndex, const FTransform& Transform, const FNiagaraDestructionDriverProxyOwner& Owner)
+{
+	if (!Batches.IsValidIndex(BatchIndex))
+	{
+		return INDEX_NONE;
+	}
+
+	FNiagaraDestructionDriverProxyBatch& Batch = Batches[BatchIndex];
+	FProxy Proxy;
+	Proxy.BatchIndex = BatchIndex;
+	Proxy.InstanceIndex = Batch.Component->AddInstance(Transform, true);
+	Proxy.Owner = Owner;
+	const int32 ProxyId = Proxies.Add(MoveTemp(Proxy));
+	Batch.InstanceProxies.Add(ProxyId);
+	check(Batch.InstanceProxies.Num() == Batch.Component->GetInstanceCount());
+
+	UpdateStats();
+	return ProxyId;
+}
+
+void UNiagaraDestructionDriverProxySubsystem::RemoveProxy(const int32 ProxyId)
+{
+	if (!Proxies.IsValidIndex(ProxyId))
+	{
+		return;
+	}
+
+	const FProxy& Proxy = Proxies[ProxyId];
+	FNiagaraDestructionDriverProxyBatch& Batch = Batches[Proxy.BatchIndex];
+	const int32 InstanceIdx = Proxy.InstanceIndex;
+	Batch.Component->RemoveInstance(InstanceIdx);
+	Batch.InstanceProxies.RemoveAtSwap(InstanceIdx);
+	Proxies.RemoveAt(ProxyId);
+
+	// the component moved its last instance into the gap, point its proxy at the new index
+	if (Batch.InstanceProxies.IsValidIndex(InstanceIdx))
+	{
+		Proxies[Batch.InstanceProxies[InstanceIdx]].InstanceIndex = InstanceIdx;
+	}
+	UpdateStats();
+}
+
+const FNiagaraDestructionDriverProxyOwner* UNiagaraDestructionDriverProxySubsystem::FindProxyOwner(const UPrimitiveComponent* Component, const int32 InstanceIndex) const
+{
+	if (Component == nullptr || Component->GetOwner() != BatchOwner)
+	{
+		return nullptr;
+	}
+	for (const FNiagaraDestructionDriverProxyBatch& Batch : Batches)
+	{
+		if (Batch.Component == Component)
+		{
+			return Batch.InstanceProxies.IsValidIndex(InstanceIndex) ? &Proxies[Batch.InstanceProxies[InstanceIndex]].Owner : nullptr;
+		}
+	}
+	return nullptr;
+}
+
+void UNiagaraDestructionDriverProxySubsystem::Deinitialize()
+{
+	Proxies.Empty();
+	Batches.Empty();
+	BatchOwner = nullptr;
+	UpdateStats();
+	Super::Deinitialize();
+}
+
+bool UNiagaraDestructionDriverProxySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UNiagaraDestructionDriverProxySubsystem::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_NDD_Proxies, Proxies.Num());
+	SET_DWORD_STAT(STAT_NDD_ProxyBatches, Batches.Num());
+}
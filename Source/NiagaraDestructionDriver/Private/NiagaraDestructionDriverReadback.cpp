@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverReadback.h"
+
+#include "RenderingThread.h"
+#include "RHIGPUReadback.h"
+#include "TextureResource.h"
+#include "Engine/TextureRenderTarget2D.h"
+
+bool FNiagaraDestructionDriverRegionReadback::Request(UTextureRenderTarget2D* RenderTarget, const FIntRect& Rect)
+{
+	FTextureRenderTargetResource* Resource = RenderTarget ? RenderTarget->GameThread_GetRenderTargetResource() : nullptr;
+	if (IsBusy() || Resource == nullptr || Rect.Area() <= 0)
+	{
+		return false;
+	}
+
+	State = MakeShared<FState, ESPMode::ThreadSafe>();
+	State->Readback = MakeUnique<FRHIGPUTextureReadback>(TEXT("NiagaraDestructionDriverReadback"));
+	State->Size = Rect.Size();
+	ENQUEUE_RENDER_COMMAND(NiagaraDestructionDriverEnqueueReadback)([ReadbackState = State, Resource, Rect](FRHICommandListImmediate& RHICmdList)
+	{
+		ReadbackState->Readback->EnqueueCopy(RHICmdList, Resource->GetRenderTargetTexture(), FIntVector(Rect.Min.X, Rect.Min.Y, 0), 0, FIntVector(Rect.Width(), Rect.Height(), 1));
+	});
+	return true;
+}
+
+bool FNiagaraDestructionDriverRegionReadback::Poll(TArray<FFloat16Color>& OutPixels)
+{
+	if (!IsBusy())
+	{
+		return false;
+	}
+
+	if (State->bCopied)
+	{
+		OutPixels = MoveTemp(State->Pixels);
+		State.Reset();
+		return true;
+	}
+
+	// the staging copy is done, map it on the render thread
+	if (!State->bLockRequested && State->Readback->IsReady())
+	{
+		State->bLockRequested = true;
+		ENQUEUE_RENDER_COMMAND(NiagaraDestructionDriverLockReadback)([ReadbackState = State](FRHICommandListImmediate& RHICmdList)
+		{
+			int32 RowPitchInPixels = 0;
+			if (const FFloat16Color* Data = static_cast<const FFloat16Color*>(ReadbackState->Readback->Lock(RowPitchInPixels)))
+			{
+				const FIntPoint Size = ReadbackState->Size;
+				ReadbackState->Pixels.SetNumUninitialized(Size.X * Size.Y);
+				for (int32 Row = 0; Row < Size.Y; Row++)
+				{
+					FMemory::Memcpy(&ReadbackState->Pixels[Row * Size.X], Data + Row * RowPitchInPixels, Size.X * sizeof(FFloat16Color));
+				}
+			}
+			ReadbackState->Readback->Unlock();
+			ReadbackState->bCopied = true;
+		});
+	}
+	return false;
+}
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/Float16Color.h"
+#include <atomic>
+
+class FRHIGPUTextureReadback;
+class UTextureRenderTarget2D;
+
+/**
+ * Reads a region of a simulation render target back to the CPU without stalling the game thread.
+ * Request() queues the copy on the render thread, Poll() hands the pixels over a few frames later.
+ * One readback in flight at a time.
+ */
+class FNiagaraDestructionDriverRegionReadback
+{
+public:
+
+	/** Queues a copy of Rect, returns false if a readback is already in flight or the render target has no resource. */
+	bool Request(UTextureRenderTarget2D* RenderTarget, const FIntRect& Rect);
+
+	/** True once the pixels of the last request arrived, they are moved into OutPixels (row by row, Rect.Width() wide). */
+	bool Poll(TArray<FFloat16Color>& OutPixels);
+
+	bool IsBusy() const { return State.IsValid(); }
+
+	/** Forgets the readback in flight (the render thread finishes it on its own) */
+	void Reset() { State.Reset(); }
+
+private:
+
+	struct FState
+	{
+		TUniquePtr<FRHIGPUTextureReadback> Readback;
+		FIntPoint Size = FIntPoint::ZeroValue;
+		TArray<FFloat16Color> Pixels;
+		std::atomic<bool> bCopied = false;
+		bool bLockRequested = false;
+	};
+
+	TSharedPtr<FState, ESPMode::ThreadSafe> State;
+};
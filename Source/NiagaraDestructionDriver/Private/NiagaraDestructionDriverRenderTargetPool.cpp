@@ -0,0 +1,85 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverRenderTargetPool.h"
+
+#include "NiagaraDestructionDriver.h"
+#include "NiagaraDestructionDriverHelper.h"
+#include "NiagaraDestructionDriverSettings.h"
+#include "Kismet/KismetRenderingLibrary.h"
+
+UTextureRenderTarget2D* UNiagaraDestructionDriverRenderTargetPool::AcquireRenderTarget(const int32 Size, const ETextureRenderTargetFormat Format)
+{
+	UTextureRenderTarget2D* RenderTarget = nullptr;
+	FNiagaraDestructionDriverRenderTargetBucket* Bucket = Buckets.Find(MakeBucketKey(Size, Format));
+	if (Bucket && Bucket->FreeRenderTargets.Num() > 0)
+	{
+		RenderTarget = Bucket->FreeRenderTargets.Pop();
+	}
+
+	if (RenderTarget)
+	{
+		// clear on acquire so the previous owner's bone transforms don't show up for a frame
+		Stats.Hits++;
+		Stats.NumFree--;
+		UKismetRenderingLibrary::ClearRenderTarget2D(this, RenderTarget, RenderTarget->ClearColor);
+	}
+	else
+	{
+		Stats.Misses++;
+		RenderTarget = UNiagaraDestructionDriverHelper::CreateSimulationRenderTarget(this, Size, Format);
+	}
+
+	Stats.NumInUse++;
+	Stats.PeakResidency = FMath::Max(Stats.PeakResidency, Stats.NumInUse + Stats.NumFree);
+	return RenderTarget;
+}
+
+void UNiagaraDestructionDriverRenderTargetPool::ReleaseRenderTarget(UTextureRenderTarget2D* RenderTarget)
+{
+	if (RenderTarget == nullptr)
+	{
+		return;
+	}
+
+	Stats.NumInUse--;
+
+	FNiagaraDestructionDriverRenderTargetBucket& Bucket = Buckets.FindOrAdd(MakeBucketKey(RenderTarget->SizeX, RenderTarget->RenderTargetFormat));
+	if (Bucket.FreeRenderTargets.Num() >= GetDefault<UNiagaraDestructionDriverSettings>()->MaxFreeRenderTargetsPerBucket)
+	{
+		// bucket is full, let GC reclaim it once nothing (mesh component, material) references it anymore
+		return;
+	}
+
+	Bucket.FreeRenderTargets.Add(RenderTarget);
+	Stats.NumFree++;
+}
+
+void UNiagaraDestructionDriverRenderTargetPool::DumpPoolStats() const
+{
+	UE_LOG(LogNiagaraDestructionDriver, Display, TEXT("Render target pool: %d hits, %d misses, %d in use, %d free, peak residency %d, %d buckets"),
+			Stats.Hits,
+			Stats.Misses,
+			Stats.NumInUse,
+			Stats.NumFree,
+			Stats.PeakResidency,
+			Buckets.Num());
+}
+
+void UNiagaraDestructionDriverRenderTargetPool::Deinitialize()
+{
+	Buckets.Empty();
+	Stats = FNiagaraDestructionDriverRenderTargetPoolStats();
+	Super::Deinitialize();
+}
+
+bool UNiagaraDestructionDriverRenderTargetPool::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// nothing to hand out on dedicated servers / -nullrhi
+	return Super::ShouldCreateSubsystem(Outer) && UNiagaraDestructionDriverHelper::ShouldCreateRenderResources(Outer);
+}
+
+bool UNiagaraDestructionDriverRenderTargetPool::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
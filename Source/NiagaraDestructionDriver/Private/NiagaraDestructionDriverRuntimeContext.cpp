@@ -0,0 +1,40 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverRuntimeContext.h"
+
+#include "NiagaraDestructionDriverDataAsset.h"
+#include "Engine/StaticMesh.h"
+
+const FNiagaraDestructionDriverParameterNames& FNiagaraDestructionDriverParameterNames::Get()
+{
+	static const FNiagaraDestructionDriverParameterNames ParameterNames;
+	return ParameterNames;
+}
+
+FNiagaraDestructionDriverRuntimeContext FNiagaraDestructionDriverRuntimeContext::Build(const UNiagaraDestructionDriverDataAsset* DataAsset)
+{
+	FNiagaraDestructionDriverRuntimeContext Context;
+	UStaticMesh* StaticMesh = DataAsset ? DataAsset->StaticMesh.Get() : nullptr;
+	if (StaticMesh == nullptr)
+	{
+		return Context;
+	}
+
+	Context.ParticleSystem = DataAsset->ParticleSystemDriver.Get();
+	Context.StaticMesh = StaticMesh;
+	Context.InitialBoneLocationsTexture = DataAsset->InitialBoneLocationsTexture.Get();
+	Context.MeshHalfExtents = StaticMesh->GetBoundingBox().GetExtent();
+	Context.PivotOffset = DataAsset->PivotOffset;
+	Context.RenderTargetTextureSize = DataAsset->RenderTargetTextureSize;
+
+	const TArray<FStaticMaterial>& StaticMaterials = StaticMesh->GetStaticMaterials();
+	Context.SlotMaterials.Reserve(StaticMaterials.Num());
+	for (const FStaticMaterial& StaticMaterial : StaticMaterials)
+	{
+		Context.SlotMaterials.Add(StaticMaterial.MaterialInterface);
+	}
+
+	Context.bIsValid = true;
+	return Context;
+}
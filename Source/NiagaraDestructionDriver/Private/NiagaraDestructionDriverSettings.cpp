@@ -9,3 +9,9 @@ UNiagaraDestructionDriverSettings::UNiagaraDestructionDriverSettings()
 	DebugMaterialForNiagaraDestructibles = TSoftObjectPtr<UMaterial>(FSoftObjectPath(TEXT("/NiagaraDestructionDriver/M_VertexMeshSystem.M_VertexMeshSystem")));
 	DefaultNiagaraParticleSystem = TSoftObjectPtr<UNiagaraSystem>(FSoftObjectPath(TEXT("/NiagaraDestructionDriver/PS_DestructibleRig.PS_DestructibleRig")));
 }
+
+const FNiagaraDestructionDriverSignificanceThresholds& UNiagaraDestructionDriverSettings::GetSignificanceThresholds() const
+{
+	const FNiagaraDestructionDriverSignificanceThresholds* PlatformThresholds = PlatformSignificanceThresholds.Find(FName(FPlatformProperties::IniPlatformName()));
+	return PlatformThresholds ? *PlatformThresholds : SignificanceThresholds;
+}
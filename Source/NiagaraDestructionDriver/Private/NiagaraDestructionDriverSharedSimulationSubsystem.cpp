@@ -0,0 +1,472 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverSharedSimulationSubsystem.h"
+
+#include "NiagaraComponent.h"
+#include "NiagaraDataInterfaceArrayFunctionLibrary.h"
+#include "NiagaraDestructionDriver.h"
+#include "NiagaraDestructionDriverAssetLoader.h"
+#include "NiagaraDestructionDriverHelper.h"
+#include "NiagaraDestructionDriverRuntimeContext.h"
+#include "NiagaraDestructionDriverSettings.h"
+#include "NiagaraSystem.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+
+DECLARE_CYCLE_STAT(TEXT("NDD Shared Simulation Tick"), STAT_NDD_SharedSimulationTick, STATGROUP_NiagaraDestructionDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("NDD Shared Simulations"), STAT_NDD_SharedSimulations, STATGROUP_NiagaraDestructionDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("NDD Shared Simulation Ranges"), STAT_NDD_SharedSimulationRanges, STATGROUP_NiagaraDestructionDriver);
+
+bool UNiagaraDestructionDriverSharedSimulationSubsystem::AcquireRange(ANiagaraDestructionDriverActor* Destructible, const FNiagaraDestructionDriverRuntimeContext& Context, const FNiagaraDestructionDriverAtlasTile& Tile)
+{
+	const UNiagaraDestructionDriverDataAsset* DataAsset = Destructible ? Destructible->NiagaraDestructionDriverParams.Get() : nullptr;
+	const int32 NumBones = DataAsset ? DataAsset->InitialBoneLocations.Num() : 0;
+	if (NumBones == 0 || !Tile.IsValid() || !Context.IsValid() || RangeKeys.Contains(Destructible))
+	{
+		return false;
+	}
+	// bones are written row by row into the tile
+	if (NumBones > Context.RenderTargetTextureSize * Context.RenderTargetTextureSize)
+	{
+		return false;
+	}
+
+	FNiagaraDestructionDriverSharedSimulation* Simulation = Simulations.Find(Tile.PageIndex);
+	if (Simulation == nullptr)
+	{
+		Simulation = AddSimulation(Tile);
+		if (Simulation == nullptr)
+		{
+			return false;
+		}
+	}
+
+	const int32 FirstBone = AllocateBones(*Simulation, NumBones);
+	if (FirstBone == INDEX_NONE)
+	{
+		UE_LOG(LogNiagaraDestructionDriver, Log, TEXT("Shared simulation of atlas page %d is out of bones (%d), %s simulates on its own. Increase MaxSharedSimulationBones in the plugin settings."),
+				Tile.PageIndex,
+				Simulation->BoneRanges.Num(),
+				*Destructible->GetName());
+		if (Simulation->FreeRanges.Num() == Simulation->Owners.Num())
+		{
+			RemoveSimulation(Tile.PageIndex);
+		}
+		return false;
+	}
+
+	int32 Range;
+	if (Simulation->FreeRanges.Num() > 0)
+	{
+		Range = Simulation->FreeRanges.Pop(EAllowShrinking::No);
+	}
+	else
+	{
+		Range = Simulation->Owners.AddDefaulted();
+		Simulation->RangeBoneStarts.AddZeroed();
+		Simulation->RangeBoneCounts.AddZeroed();
+		Simulation->RangeLocations.AddZeroed();
+		Simulation->RangeRotations.Add(FQuat::Identity);
+		Simulation->RangeScales.Add(FVector::OneVector);
+		Simulation->RangeHalfExtents.AddZeroed();
+		Simulation->RangeTileOffsetScales.AddZeroed();
+		Simulation->RangeTileSizes.AddZeroed();
+		Simulation->RangeSimulating.Add(false);
+		Simulation->RangeResetCounts.AddZeroed();
+	}
+
+	Simulation->Owners[Range] = Destructible;
+	Simulation->RangeBoneStarts[Range] = FirstBone;
+	Simulation->RangeBoneCounts[Range] = NumBones;
+	Simulation->RangeHalfExtents[Range] = Context.MeshHalfExtents;
+	Simulation->RangeTileSizes[Range] = Context.RenderTargetTextureSize;
+	Simulation->RangeSimulating[Range] = false;
+	// the bones may still hold the previous owner's pose
+	Simulation->RangeResetCounts[Range]++;
+	if (const UNiagaraDestructionDriverAtlasSubsystem* Atlas = GetWorld()->GetSubsystem<UNiagaraDestructionDriverAtlasSubsystem>())
+	{
+		Simulation->RangeTileOffsetScales[Range] = Atlas->GetTileOffsetScale(Tile);
+	}
+	SetRangeTransform(*Simulation, Range, Destructible);
+	for (int32 BoneIdx = 0; BoneIdx < NumBones; BoneIdx++)
+	{
+		Simulation->BoneInitialLocations[FirstBone + BoneIdx] = FVector(DataAsset->InitialBoneLocations[BoneIdx]);
+		Simulation->BoneRanges[FirstBone + BoneIdx] = Range;
+	}
+	Simulation->bParametersDirty = true;
+	Simulation->bBonesDirty = true;
+
+	RangeKeys.Add(Destructible, FIntPoint(Tile.PageIndex, Range));
+	UpdateStats();
+	return true;
+}
+
+void UNiagaraDestructionDriverSharedSimulationSubsystem::ReleaseRange(const ANiagaraDestructionDriverActor* Destructible)
+{
+	int32 Range;
+	FNiagaraDestructionDriverSharedSimulation* Simulation = FindSimulation(Destructible, Range);
+	if (Simulation == nullptr)
+	{
+		return;
+	}
+
+	const int32 PageIndex = RangeKeys.FindAndRemoveChecked(Destructible).X;
+	RemoveForces(*Simulation, Range);
+	FreeBones(*Simulation, Simulation->RangeBoneStarts[Range], Simulation->RangeBoneCounts[Range]);
+	Simulation->Owners[Range].Reset();
+	Simulation->RangeBoneCounts[Range] = 0;
+	Simulation->RangeSimulating[Range] = false;
+	Simulation->FreeRanges.Add(Range);
+	Simulation->bParametersDirty = true;
+	Simulation->bBonesDirty = true;
+
+	// nobody left to simulate, free the system instance
+	if (Simulation->FreeRanges.Num() == Simulation->Owners.Num())
+	{
+		RemoveSimulation(PageIndex);
+	}
+	UpdateStats();
+}
+
+void UNiagaraDestructionDriverSharedSimulationSubsystem::ResetRange(const ANiagaraDestructionDriverActor* Destructible)
+{
+	int32 Range;
+	if (FNiagaraDestructionDriverSharedSimulation* Simulation = FindSimulation(Destructible, Range))
+	{
+		RemoveForces(*Simulation, Range);
+		Simulation->RangeSimulating[Range] = false;
+		Simulation->RangeResetCounts[Range]++;
+		SetRangeTransform(*Simulation, Range, Destructible);
+		Simulation->bParametersDirty = true;
+	}
+}
+
+void UNiagaraDestructionDriverSharedSimulationSubsystem::UpdateRangeTransform(const ANiagaraDestructionDriverActor* Destructible)
+{
+	int32 Range;
+	if (FNiagaraDestructionDriverSharedSimulation* Simulation = FindSimulation(Destructible, Range))
+	{
+		SetRangeTransform(*Simulation, Range, Destructible);
+		Simulation->bParametersDirty = true;
+	}
+}
+
+void UNiagaraDestructionDriverSharedSimulationSubsystem::ApplyForce(const ANiagaraDestructionDriverActor* Destructible, const FNiagaraDestructionDriverForce& Force)
+{
+	int32 Range;
+	if (FNiagaraDestructionDriverSharedSimulation* Simulation = FindSimulation(Destructible, Range))
+	{
+		Simulation->Forces.Add(Force);
+		Simulation->ForceRanges.Add(Range);
+		Simulation->RangeSimulating[Range] = true;
+		Simulation->bParametersDirty = true;
+	}
+}
+
+void UNiagaraDestructionDriverSharedSimulationSubsystem::SettleRange(const ANiagaraDestructionDriverActor* Destructible)
+{
+	int32 Range;
+	if (FNiagaraDestructionDriverSharedSimulation* Simulation = FindSimulation(Destructible, Range))
+	{
+		RemoveForces(*Simulation, Range);
+		Simulation->RangeSimulating[Range] = false;
+		Simulation->bParametersDirty = true;
+	}
+}
+
+void UNiagaraDestructionDriverSharedSimulationSubsystem::DumpSharedSimulationStats() const
+{
+	UE_LOG(LogNiagaraDestructionDriver, Display, TEXT("Shared simulation: %d system instances, %d ranges (one system instance per atlas page)"), Simulations.Num(), RangeKeys.Num());
+	for (const TPair<int32, FNiagaraDestructionDriverSharedSimulation>& Pair : Simulations)
+	{
+		const FNiagaraDestructionDriverSharedSimulation& Simulation = Pair.Value;
+		int32 NumSimulating = 0;
+		int32 NumBonesUsed = 0;
+		for (int32 Range = 0; Range < Simulation.Owners.Num(); Range++)
+		{
+			NumSimulating += Simulation.RangeSimulating[Range] ? 1 : 0;
+			NumBonesUsed += Simulation.RangeBoneCounts[Range];
+		}
+		UE_LOG(LogNiagaraDestructionDriver, Display, TEXT("  Page %d: %d ranges, %d simulating, %d forces, %d/%d bones used in %d free spans"),
+				Pair.Key,
+				Simulation.Owners.Num() - Simulation.FreeRanges.Num(),
+				NumSimulating,
+				Simulation.Forces.Num(),
+				NumBonesUsed,
+				Simulation.BoneRanges.Num(),
+				Simulation.FreeBoneSpans.Num());
+	}
+}
+
+void UNiagaraDestructionDriverSharedSimulationSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// destructibles simulate on their own until the shared system is loaded
+	const UNiagaraDestructionDriverSettings* Settings = GetDefault<UNiagaraDestructionDriverSettings>();
+	UGameInstance* GameInstance = InWorld.GetGameInstance();
+	if (Settings->bUseSharedSimulation && !Settings->SharedSimulationSystem.IsNull() && GameInstance)
+	{
+		if (UNiagaraDestructionDriverAssetLoader* AssetLoader = GameInstance->GetSubsystem<UNiagaraDestructionDriverAssetLoader>())
+		{
+			AssetLoader->RequestAssets({ Settings->SharedSimulationSystem.ToSoftObjectPath() }, FSimpleDelegate());
+		}
+	}
+}
+
+void UNiagaraDestructionDriverSharedSimulationSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NDD_SharedSimulationTick);
+
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+	for (TPair<int32, FNiagaraDestructionDriverSharedSimulation>& Pair : Simulations)
+	{
+		FNiagaraDestructionDriverSharedSimulation& Simulation = Pair.Value;
+
+		// forces that stopped pushing only make the arrays longer
+		for (int32 Idx = Simulation.Forces.Num() - 1; Idx >= 0; Idx--)
+		{
+			if (Simulation.Forces[Idx].StartTime + Simulation.Forces[Idx].Duration < WorldTime)
+			{
+				Simulation.Forces.RemoveAtSwap(Idx, 1, EAllowShrinking::No);
+				Simulation.ForceRanges.RemoveAtSwap(Idx, 1, EAllowShrinking::No);
+				Simulation.bParametersDirty = true;
+			}
+		}
+
+		// everything that changed this frame goes to the simulation at once
+		if (Simulation.bParametersDirty || Simulation.bBonesDirty)
+		{
+			PushParameters(Simulation);
+		}
+
+		// paused instead of deactivated so the settled bones of the other ranges aren't respawned
+		UNiagaraComponent* NiagaraComponent = Simulation.NiagaraComponent;
+		if (Simulation.RangeSimulating.Contains(true))
+		{
+			if (!NiagaraComponent->IsActive())
+			{
+				NiagaraComponent->Activate();
+			}
+			if (NiagaraComponent->IsPaused())
+			{
+				NiagaraComponent->SetPaused(false);
+			}
+		}
+		else if (NiagaraComponent->IsActive() && !NiagaraComponent->IsPaused())
+		{
+			NiagaraComponent->SetPaused(true);
+		}
+	}
+}
+
+TStatId UNiagaraDestructionDriverSharedSimulationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNiagaraDestructionDriverSharedSimulationSubsystem, STATGROUP_NiagaraDestructionDriver);
+}
+
+void UNiagaraDestructionDriverSharedSimulationSubsystem::Deinitialize()
+{
+	Simulations.Empty();
+	RangeKeys.Empty();
+	SimulationOwner = nullptr;
+	UpdateStats();
+	Super::Deinitialize();
+}
+
+bool UNiagaraDestructionDriverSharedSimulationSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// headless destructibles never activate
+	return Super::ShouldCreateSubsystem(Outer) && UNiagaraDestructionDriverHelper::ShouldCreateRenderResources(Outer);
+}
+
+bool UNiagaraDestructionDriverSharedSimulationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+FNiagaraDestructionDriverSharedSimulation* UNiagaraDestructionDriverSharedSimulationSubsystem::AddSimulation(const FNiagaraDestructionDriverAtlasTile& Tile)
+{
+	const UNiagaraDestructionDriverSettings* Settings = GetDefault<UNiagaraDestructionDriverSettings>();
+	UNiagaraSystem* System = Settings->SharedSimulationSystem.Get();
+	const UNiagaraDestructionDriverAtlasSubsystem* Atlas = GetWorld()->GetSubsystem<UNiagaraDestructionDriverAtlasSubsystem>();
+	if (System == nullptr || Atlas == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (SimulationOwner == nullptr)
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.ObjectFlags |= RF_Transient;
+		SimulationOwner = GetWorld()->SpawnActor<AActor>(SpawnParams);
+		USceneComponent* Root = NewObject<USceneComponent>(SimulationOwner, TEXT("Root"));
+		SimulationOwner->SetRootComponent(Root);
+		Root->RegisterComponent();
+	}
+
+	const int32 NumBones = FMath::Max(Settings->MaxSharedSimulationBones, 1);
+	FNiagaraDestructionDriverSharedSimulation& Simulation = Simulations.Add(Tile.PageIndex);
+	Simulation.FreeBoneSpans.Add(FIntPoint(0, NumBones));
+	Simulation.BoneInitialLocations.Init(FVector::ZeroVector, NumBones);
+	Simulation.BoneRanges.Init(INDEX_NONE, NumBones);
+
+	// ranges are positioned in world space, the component stays at the origin
+	const FNiagaraDestructionDriverParameterNames& ParameterNames = FNiagaraDestructionDriverParameterNames::Get();
+	Simulation.NiagaraComponent = NewObject<UNiagaraComponent>(SimulationOwner);
+	Simulation.NiagaraComponent->SetAutoActivate(false);
+	Simulation.NiagaraComponent->SetAsset(System);
+	Simulation.NiagaraComponent->SetVariableTextureRenderTarget(ParameterNames.SimulatedParticlePositionsOut, Atlas->GetPositionsPage(Tile));
+	Simulation.NiagaraComponent->SetVariableTextureRenderTarget(ParameterNames.SimulatedParticleRotationsOut, Atlas->GetRotationsPage(Tile));
+	Simulation.NiagaraComponent->SetVariableInt(ParameterNames.SharedBoneCount, NumBones);
+	Simulation.NiagaraComponent->SetupAttachment(SimulationOwner->GetRootComponent());
+	Simulation.NiagaraComponent->RegisterComponent();
+
+	UE_LOG(LogNiagaraDestructionDriver, Log, TEXT("Added shared simulation for atlas page %d: %d bones."), Tile.PageIndex, NumBones);
+	return &Simulation;
+}
+
+void UNiagaraDestructionDriverSharedSimulationSubsystem::RemoveSimulation(const int32 PageIndex)
+{
+	FNiagaraDestructionDriverSharedSimulation Simulation;
+	if (!Simulations.RemoveAndCopyValue(PageIndex, Simulation))
+	{
+		return;
+	}
+	if (Simulation.NiagaraComponent)
+	{
+		Simulation.NiagaraComponent->DeactivateImmediate();
+		Simulation.NiagaraComponent->DestroyComponent();
+	}
+}
+
+FNiagaraDestructionDriverSharedSimulation* UNiagaraDestructionDriverSharedSimulationSubsystem::FindSimulation(const ANiagaraDestructionDriverActor* Destructible, int32& OutRange)
+{
+	const FIntPoint* Key = Destructible ? RangeKeys.Find(Destructible) : nullptr;
+	FNiagaraDestructionDriverSharedSimulation* Simulation = Key ? Simulations.Find(Key->X) : nullptr;
+	OutRange = Key ? Key->Y : INDEX_NONE;
+	return Simulation && Simulation->Owners.IsValidIndex(OutRange) ? Simulation : nullptr;
+}
+
+int32 UNiagaraDestructionDriverSharedSimulationSubsystem::AllocateBones(FNiagaraDestructionDriverSharedSimulation& Simulation, const int32 NumBones)
+{
+	for (int32 SpanIdx = 0; SpanIdx < Simulation.FreeBoneSpans.Num(); SpanIdx++)
+	{
+		FIntPoint& Span = Simulation.FreeBoneSpans[SpanIdx];
+		if (Span.Y < NumBones)
+		{
+			continue;
+		}
+		const int32 FirstBone = Span.X;
+		Span.X += NumBones;
+		Span.Y -= NumBones;
+		if (Span.Y == 0)
+		{
+			Simulation.FreeBoneSpans.RemoveAt(SpanIdx);
+		}
+		return FirstBone;
+	}
+	return INDEX_NONE;
+}
+
+void UNiagaraDestructionDriverSharedSimulationSubsystem::FreeBones(FNiagaraDestructionDriverSharedSimulation& Simulation, const int32 FirstBone, const int32 NumBones)
+{
+	for (int32 BoneIdx = FirstBone; BoneIdx < FirstBone + NumBones; BoneIdx++)
+	{
+		Simulation.BoneRanges[BoneIdx] = INDEX_NONE;
+	}
+
+	// keep the spans sorted and merge with the neighbours they touch
+	TArray<FIntPoint>& Spans = Simulation.FreeBoneSpans;
+	int32 InsertIdx = 0;
+	while (InsertIdx < Spans.Num() && Spans[InsertIdx].X < FirstBone)
+	{
+		InsertIdx++;
+	}
+	Spans.Insert(FIntPoint(FirstBone, NumBones), InsertIdx);
+	if (InsertIdx + 1 < Spans.Num() && Spans[InsertIdx].X + Spans[InsertIdx].Y == Spans[InsertIdx + 1].X)
+	{
+		Spans[InsertIdx].Y += Spans[InsertIdx + 1].Y;
+		Spans.RemoveAt(InsertIdx + 1);
+	}
+	if (InsertIdx > 0 && Spans[InsertIdx - 1].X + Spans[InsertIdx - 1].Y == Spans[InsertIdx].X)
+	{
+		Spans[InsertIdx - 1].Y += Spans[InsertIdx].Y;
+		Spans.RemoveAt(InsertIdx);
+	}
+}
+
+void UNiagaraDestructionDriverSharedSimulationSubsystem::SetRangeTransform(FNiagaraDestructionDriverSharedSimulation& Simulation, const int32 Range, const ANiagaraDestructionDriverActor* Destructible)
+{
+	// like the niagara component of a destructible, centered against the mesh by the pivot offset
+	const FTransform ActorTransform = Destructible->GetActorTransform();
+	Simulation.RangeLocations[Range] = ActorTransform.TransformPosition(-Destructible->NiagaraDestructionDriverParams->PivotOffset);
+	Simulation.RangeRotations[Range] = ActorTransform.GetRotation();
+	Simulation.RangeScales[Range] = ActorTransform.GetScale3D();
+}
+
+void UNiagaraDestructionDriverSharedSimulationSubsystem::PushParameters(FNiagaraDestructionDriverSharedSimulation& Simulation) const
+{
+	const FNiagaraDestructionDriverParameterNames& ParameterNames = FNiagaraDestructionDriverParameterNames::Get();
+	UNiagaraComponent* NiagaraComponent = Simulation.NiagaraComponent;
+
+	// the per bone arrays are as large as the budget, only send them when ranges come and go
+	if (Simulation.bBonesDirty)
+	{
+		UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(NiagaraComponent, ParameterNames.BoneInitialLocations, Simulation.BoneInitialLocations);
+		UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayInt32(NiagaraComponent, ParameterNames.BoneRanges, Simulation.BoneRanges);
+		UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayInt32(NiagaraComponent, ParameterNames.RangeBoneStarts, Simulation.RangeBoneStarts);
+		UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayInt32(NiagaraComponent, ParameterNames.RangeBoneCounts, Simulation.RangeBoneCounts);
+		UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(NiagaraComponent, ParameterNames.RangeHalfExtents, Simulation.RangeHalfExtents);
+		UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector4(NiagaraComponent, ParameterNames.RangeTileOffsetScales, Simulation.RangeTileOffsetScales);
+		UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayInt32(NiagaraComponent, ParameterNames.RangeTileSizes, Simulation.RangeTileSizes);
+		Simulation.bBonesDirty = false;
+	}
+
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayPosition(NiagaraComponent, ParameterNames.RangeLocations, Simulation.RangeLocations);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayQuat(NiagaraComponent, ParameterNames.RangeRotations, Simulation.RangeRotations);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayVector(NiagaraComponent, ParameterNames.RangeScales, Simulation.RangeScales);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayBool(NiagaraComponent, ParameterNames.RangeSimulating, Simulation.RangeSimulating);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayInt32(NiagaraComponent, ParameterNames.RangeResetCounts, Simulation.RangeResetCounts);
+
+	TArray<FVector> ForceCenters;
+	TArray<float> ForceRadii;
+	TArray<float> ForceStartTimes;
+	TArray<float> ForceDurations;
+	ForceCenters.Reserve(Simulation.Forces.Num());
+	ForceRadii.Reserve(Simulation.Forces.Num());
+	ForceStartTimes.Reserve(Simulation.Forces.Num());
+	ForceDurations.Reserve(Simulation.Forces.Num());
+	for (const FNiagaraDestructionDriverForce& Force : Simulation.Forces)
+	{
+		ForceCenters.Add(Force.Origin);
+		ForceRadii.Add(Force.Radius);
+		ForceStartTimes.Add(Force.StartTime);
+		ForceDurations.Add(Force.Duration);
+	}
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayPosition(NiagaraComponent, ParameterNames.ForceCenters, ForceCenters);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayFloat(NiagaraComponent, ParameterNames.ForceRadii, ForceRadii);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayFloat(NiagaraComponent, ParameterNames.ForceStartTimes, ForceStartTimes);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayFloat(NiagaraComponent, ParameterNames.ForceDurations, ForceDurations);
+	UNiagaraDataInterfaceArrayFunctionLibrary::SetNiagaraArrayInt32(NiagaraComponent, ParameterNames.ForceRanges, Simulation.ForceRanges);
+	Simulation.bParametersDirty = false;
+}
+
+void UNiagaraDestructionDriverSharedSimulationSubsystem::RemoveForces(FNiagaraDestructionDriverSharedSimulation& Simulation, const int32 Range)
+{
+	for (int32 Idx = Simulation.ForceRanges.Num() - 1; Idx >= 0; Idx--)
+	{
+		if (Simulation.ForceRanges[Idx] == Range)
+		{
+			Simulation.Forces.RemoveAtSwap(Idx, 1, EAllowShrinking::No);
+			Simulation.ForceRanges.RemoveAtSwap(Idx, 1, EAllowShrinking::No);
+		}
+	}
+}
+
+void UNiagaraDestructionDriverSharedSimulationSubsystem::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_NDD_SharedSimulations, Simulations.Num());
+	SET_DWORD_STAT(STAT_NDD_SharedSimulationRanges, RangeKeys.Num());
+}
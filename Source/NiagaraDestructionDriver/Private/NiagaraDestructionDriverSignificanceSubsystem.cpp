@@ -0,0 +1,254 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverSignificanceSubsystem.h"
+
+#include "NiagaraComponent.h"
+#include "NiagaraDestructionDriver.h"
+#include "NiagaraDestructionDriverHelper.h"
+#include "NiagaraDestructionDriverRuntimeContext.h"
+#include "NiagaraDestructionDriverSettings.h"
+#include "SignificanceManager.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("NDD Significance Tick"), STAT_NDD_SignificanceTick, STATGROUP_NiagaraDestructionDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("NDD Significance Full"), STAT_NDD_SignificanceFull, STATGROUP_NiagaraDestructionDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("NDD Significance Reduced"), STAT_NDD_SignificanceReduced, STATGROUP_NiagaraDestructionDriver);
+DECLARE_DWORD_COUNTER_STAT(TEXT("NDD Significance Frozen"), STAT_NDD_SignificanceFrozen, STATGROUP_NiagaraDestructionDriver);
+
+static const FName NAME_NDD_Significance = FName("NiagaraDestructionDriver");
+
+void UNiagaraDestructionDriverSignificanceSubsystem::RegisterDestructible(ANiagaraDestructionDriverActor* Destructible)
+{
+	USignificanceManager* SignificanceManager = USignificanceManager::Get(GetWorld());
+	if (SignificanceManager == nullptr || Destructible == nullptr || Destructibles.Contains(Destructible))
+	{
+		return;
+	}
+
+	// the intact mesh, MeshComponent's bounds are inflated by CullingBoundsMultiplier while destroyed
+	UNiagaraDestructionDriverDataAsset* DataAsset = Destructible->NiagaraDestructionDriverParams;
+	FRegisteredDestructible& Entry = Destructibles.Add(Destructible);
+	Entry.Destructible = Destructible;
+	Entry.LocalCenter = -DataAsset->PivotOffset;
+	Entry.BoundsRadius = DataAsset->GetRuntimeContext().MeshHalfExtents.Size();
+
+	const TObjectKey<ANiagaraDestructionDriverActor> Key(Destructible);
+	SignificanceManager->RegisterObject(Destructible, NAME_NDD_Significance,
+		[this, Key](USignificanceManager::FManagedObjectInfo* ObjectInfo, const FTransform& View) -> float
+		{
+			const FRegisteredDestructible* Registered = Destructibles.Find(Key);
+			return Registered ? CalculateSignificance(*Registered, View) : 0.f;
+		},
+		USignificanceManager::EPostSignificanceType::Sequential,
+		[this, Key](USignificanceManager::FManagedObjectInfo* ObjectInfo, float OldSignificance, float Significance, bool bFinal)
+		{
+			// tiers change in Tick, settling from in here would unregister while the manager iterates
+			if (FRegisteredDestructible* Registered = Destructibles.Find(Key))
+			{
+				Registered->Significance = Significance;
+			}
+		});
+	UpdateStats();
+}
+
+void UNiagaraDestructionDriverSignificanceSubsystem::UnregisterDestructible(ANiagaraDestructionDriverActor* Destructible)
+{
+	if (Destructible == nullptr || Destructibles.Remove(Destructible) == 0)
+	{
+		return;
+	}
+	if (USignificanceManager* SignificanceManager = USignificanceManager::Get(GetWorld()))
+	{
+		SignificanceManager->UnregisterObject(Destructible);
+	}
+	UpdateStats();
+}
+
+int32 UNiagaraDestructionDriverSignificanceSubsystem::GetNumDestructiblesInTier(const ENiagaraDestructionDriverSignificanceTier Tier) const
+{
+	int32 NumDestructibles = 0;
+	for (const TPair<TObjectKey<ANiagaraDestructionDriverActor>, FRegisteredDestructible>& Pair : Destructibles)
+	{
+		const ANiagaraDestructionDriverActor* Destructible = Pair.Value.Destructible.Get();
+		NumDestructibles += Destructible && Destructible->GetSignificanceTier() == Tier ? 1 : 0;
+	}
+	return NumDestructibles;
+}
+
+void UNiagaraDestructionDriverSignificanceSubsystem::DumpSignificanceStats() const
+{
+	const FNiagaraDestructionDriverSignificanceThresholds& Thresholds = GetDefault<UNiagaraDestructionDriverSettings>()->GetSignificanceThresholds();
+	UE_LOG(LogNiagaraDestructionDriver, Display, TEXT("Significance: %d destructibles, %d full, %d reduced, %d frozen"),
+			Destructibles.Num(),
+			GetNumDestructiblesInTier(ENiagaraDestructionDriverSignificanceTier::Full),
+			GetNumDestructiblesInTier(ENiagaraDestructionDriverSignificanceTier::Reduced),
+			GetNumDestructiblesInTier(ENiagaraDestructionDriverSignificanceTier::Frozen));
+	UE_LOG(LogNiagaraDestructionDriver, Display, TEXT("  Thresholds (%s): full rate from screen size %.3f, frozen below %.3f or beyond %.0f, reduced rate %.1f Hz, full rate %.2f s after a force, baked %.1f s after a force"),
+			ANSI_TO_TCHAR(FPlatformProperties::IniPlatformName()),
+			Thresholds.FullRateScreenSize,
+			Thresholds.FrozenScreenSize,
+			Thresholds.MaxSimulationDistance,
+			Thresholds.ReducedUpdateRate,
+			Thresholds.FullRateForceTime,
+			Thresholds.BakeFrozenAfterForceTime);
+}
+
+void UNiagaraDestructionDriverSignificanceSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_NDD_SignificanceTick);
+
+	USignificanceManager* SignificanceManager = USignificanceManager::Get(GetWorld());
+	if (SignificanceManager && GetDefault<UNiagaraDestructionDriverSettings>()->bUpdateSignificanceManager)
+	{
+		TArray<FTransform, TInlineAllocator<4>> Views;
+		for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+		{
+			const APlayerController* PlayerController = It->Get();
+			if (PlayerController && PlayerController->PlayerCameraManager)
+			{
+				Views.Add(FTransform(PlayerController->PlayerCameraManager->GetCameraRotation(), PlayerController->PlayerCameraManager->GetCameraLocation()));
+			}
+		}
+		SignificanceManager->Update(Views);
+	}
+
+	// collected first, baking settles and unregisters
+	const float WorldTime = GetWorld()->GetTimeSeconds();
+	TArray<TPair<ANiagaraDestructionDriverActor*, ENiagaraDestructionDriverSignificanceTier>, TInlineAllocator<16>> TierChanges;
+	for (auto It = Destructibles.CreateIterator(); It; ++It)
+	{
+		FRegisteredDestructible& Entry = It.Value();
+		ANiagaraDestructionDriverActor* Destructible = Entry.Destructible.Get();
+		if (Destructible == nullptr)
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+
+		const float ForceAge = Destructible->DestructionForceHistory.Num() > 0 ? WorldTime - Destructible->DestructionForceHistory.Last().StartTime : 0.f;
+		const ENiagaraDestructionDriverSignificanceTier Tier = PickTier(Entry.Significance, ForceAge);
+		if (Tier != Destructible->GetSignificanceTier())
+		{
+			Entry.TimeSinceStep = 0.f;
+			TierChanges.Emplace(Destructible, Tier);
+		}
+		else if (Tier == ENiagaraDestructionDriverSignificanceTier::Reduced)
+		{
+			StepReducedRate(Entry, DeltaTime);
+		}
+	}
+	for (const TPair<ANiagaraDestructionDriverActor*, ENiagaraDestructionDriverSignificanceTier>& TierChange : TierChanges)
+	{
+		TierChange.Key->SetSignificanceTier(TierChange.Value);
+	}
+	UpdateStats();
+}
+
+TStatId UNiagaraDestructionDriverSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNiagaraDestructionDriverSignificanceSubsystem, STATGROUP_NiagaraDestructionDriver);
+}
+
+void UNiagaraDestructionDriverSignificanceSubsystem::Deinitialize()
+{
+	if (USignificanceManager* SignificanceManager = USignificanceManager::Get(GetWorld()))
+	{
+		SignificanceManager->UnregisterAll(NAME_NDD_Significance);
+	}
+	Destructibles.Empty();
+	UpdateStats();
+	Super::Deinitialize();
+}
+
+bool UNiagaraDestructionDriverSignificanceSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// headless destructibles never simulate
+	return Super::ShouldCreateSubsystem(Outer) && UNiagaraDestructionDriverHelper::ShouldCreateRenderResources(Outer);
+}
+
+bool UNiagaraDestructionDriverSignificanceSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+float UNiagaraDestructionDriverSignificanceSubsystem::CalculateSignificance(const FRegisteredDestructible& Entry, const FTransform& View) const
+{
+	const ANiagaraDestructionDriverActor* Destructible = Entry.Destructible.Get();
+	if (Destructible == nullptr || Destructible->DestructionForceHistory.Num() == 0)
+	{
+		return 0.f;
+	}
+
+	// just hit, simulate the first moments properly wherever it is
+	const FNiagaraDestructionDriverSignificanceThresholds& Thresholds = GetDefault<UNiagaraDestructionDriverSettings>()->GetSignificanceThresholds();
+	if (GetWorld()->GetTimeSeconds() - Destructible->DestructionForceHistory.Last().StartTime < Thresholds.FullRateForceTime)
+	{
+		return TNumericLimits<float>::Max();
+	}
+
+	// instances are drawn by their group, our own mesh component never renders
+	if (Destructible->GetInstanceSlot() == INDEX_NONE && !Destructible->WasRecentlyRendered())
+	{
+		return 0.f;
+	}
+
+	const FTransform& ActorTransform = Destructible->GetActorTransform();
+	const double Distance = FVector::Dist(View.GetLocation(), ActorTransform.TransformPosition(Entry.LocalCenter));
+	if (Thresholds.MaxSimulationDistance > 0.f && Distance > Thresholds.MaxSimulationDistance)
+	{
+		return 0.f;
+	}
+	return static_cast<float>(Entry.BoundsRadius * ActorTransform.GetMaximumAxisScale() / FMath::Max(Distance, 1.0));
+}
+
+ENiagaraDestructionDriverSignificanceTier UNiagaraDestructionDriverSignificanceSubsystem::PickTier(const float Significance, const float ForceAge)
+{
+	const FNiagaraDestructionDriverSignificanceThresholds& Thresholds = GetDefault<UNiagaraDestructionDriverSettings>()->GetSignificanceThresholds();
+	if (Significance >= Thresholds.FullRateScreenSize)
+	{
+		return ENiagaraDestructionDriverSignificanceTier::Full;
+	}
+	if (Significance >= Thresholds.FrozenScreenSize)
+	{
+		return ENiagaraDestructionDriverSignificanceTier::Reduced;
+	}
+	if (Thresholds.BakeFrozenAfterForceTime > 0.f && ForceAge >= Thresholds.BakeFrozenAfterForceTime)
+	{
+		return ENiagaraDestructionDriverSignificanceTier::Baked;
+	}
+	return ENiagaraDestructionDriverSignificanceTier::Frozen;
+}
+
+void UNiagaraDestructionDriverSignificanceSubsystem::StepReducedRate(FRegisteredDestructible& Entry, const float DeltaTime)
+{
+	const ANiagaraDestructionDriverActor* Destructible = Entry.Destructible.Get();
+	UNiagaraComponent* NiagaraComponent = Destructible->NiagaraComponent;
+	if (NiagaraComponent == nullptr || Destructible->GetInstanceSlot() != INDEX_NONE || Destructible->UsesSharedSimulation())
+	{
+		return;
+	}
+
+	// paused in between, the next frame's tick covers the time since the last step
+	Entry.TimeSinceStep += DeltaTime;
+	const float StepInterval = 1.f / FMath::Max(GetDefault<UNiagaraDestructionDriverSettings>()->GetSignificanceThresholds().ReducedUpdateRate, 1.f);
+	if (Entry.TimeSinceStep >= StepInterval && DeltaTime > 0.f)
+	{
+		NiagaraComponent->SetCustomTimeDilation(Entry.TimeSinceStep / DeltaTime);
+		NiagaraComponent->SetPaused(false);
+		Entry.TimeSinceStep = 0.f;
+	}
+	else if (!NiagaraComponent->IsPaused())
+	{
+		NiagaraComponent->SetPaused(true);
+	}
+}
+
+void UNiagaraDestructionDriverSignificanceSubsystem::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_NDD_SignificanceFull, GetNumDestructiblesInTier(ENiagaraDestructionDriverSignificanceTier::Full));
+	SET_DWORD_STAT(STAT_NDD_SignificanceReduced, GetNumDestructiblesInTier(ENiagaraDestructionDriverSignificanceTier::Reduced));
+	SET_DWORD_STAT(STAT_NDD_SignificanceFrozen, GetNumDestructiblesInTier(ENiagaraDestructionDriverSignificanceTier::Frozen));
+}
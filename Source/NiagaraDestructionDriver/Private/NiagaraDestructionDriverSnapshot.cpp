@@ -0,0 +1,177 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverSnapshot.h"
+
+#include "NiagaraDestructionDriverActor.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace NiagaraDestructionDriverSnapshot
+{
+	constexpr uint8 Version = 1;
+	constexpr uint8 FlagFragmentsDespawned = 1 << 0;
+	constexpr uint8 FlagHasPose = 1 << 1;
+	constexpr uint8 FlagSettled = 1 << 2;
+
+	int16 Quantize(const float Value, const float Range)
+	{
+		return static_cast<int16>(FMath::Clamp(FMath::RoundToInt(Value / Range * 32767.f), -32767, 32767));
+	}
+
+	float Dequantize(const int16 Value, const float Range)
+	{
+		return static_cast<float>(Value) / 32767.f * Range;
+	}
+
+	/** Drops the largest component (its sign folded into the others), the remaining three are within +-1/sqrt(2) */
+	void WriteRotation(FArchive& Ar, const FQuat4f& InRotation)
+	{
+		const FQuat4f Rotation = InRotation.GetNormalized();
+		float Components[4] = { Rotation.X, Rotation.Y, Rotation.Z, Rotation.W };
+		uint8 LargestIdx = 0;
+		for (uint8 Idx = 1; Idx < 4; Idx++)
+		{
+			if (FMath::Abs(Components[Idx]) > FMath::Abs(Components[LargestIdx]))
+			{
+				LargestIdx = Idx;
+			}
+		}
+		const float Sign = Components[LargestIdx] < 0.f ? -1.f : 1.f;
+		Ar << LargestIdx;
+		for (int32 Idx = 0; Idx < 4; Idx++)
+		{
+			if (Idx != LargestIdx)
+			{
+				int16 Quantized = Quantize(Components[Idx] * Sign, UE_INV_SQRT_2);
+				Ar << Quantized;
+			}
+		}
+	}
+
+	FQuat4f ReadRotation(FArchive& Ar)
+	{
+		uint8 LargestIdx = 0;
+		Ar << LargestIdx;
+		float Components[4] = { 0.f, 0.f, 0.f, 0.f };
+		float SumSquared = 0.f;
+		for (int32 Idx = 0; Idx < 4; Idx++)
+		{
+			if (Idx != LargestIdx)
+			{
+				int16 Quantized = 0;
+				Ar << Quantized;
+				Components[Idx] = Dequantize(Quantized, UE_INV_SQRT_2);
+				SumSquared += FMath::Square(Components[Idx]);
+			}
+		}
+		Components[LargestIdx & 3] = FMath::Sqrt(FMath::Max(0.f, 1.f - SumSquared));
+		return FQuat4f(Components[0], Components[1], Components[2], Components[3]);
+	}
+}
+
+void FNiagaraDestructionDriverSnapshot::Write(const FNiagaraDestructionDriverSavedState& State, TArray<uint8>& OutSnapshot)
+{
+	using namespace NiagaraDestructionDriverSnapshot;
+
+	OutSnapshot.Reset();
+	FMemoryWriter Ar(OutSnapshot);
+
+	const int32 NumBones = FMath::Min(State.BonePositions.Num(), State.BoneRotations.Num());
+	uint8 SnapshotVersion = Version;
+	uint8 Flags = (State.bFragmentsDespawned ? FlagFragmentsDespawned : 0) | (NumBones > 0 ? FlagHasPose : 0) | (State.bSettled ? FlagSettled : 0);
+	Ar << SnapshotVersion << Flags;
+
+	int32 NumForces = State.DestructionForceHistory.Num();
+	Ar << NumForces;
+	for (FNiagaraDestructionDriverForce Force : State.DestructionForceHistory)
+	{
+		Ar << Force.Origin << Force.Radius << Force.Duration << Force.StartTime;
+	}
+
+	TBitArray<> DespawnedBones(false, NumBones);
+	for (const int32 BoneIdx : State.DespawnedBones)
+	{
+		if (DespawnedBones.IsValidIndex(BoneIdx))
+		{
+			DespawnedBones[BoneIdx] = true;
+		}
+	}
+	Ar << DespawnedBones;
+
+	if (NumBones == 0)
+	{
+		return;
+	}
+
+	// fragments can fly well past the intact mesh, so quantize relative to the actual spread
+	float PositionRange = UE_KINDA_SMALL_NUMBER;
+	for (int32 BoneIdx = 0; BoneIdx < NumBones; BoneIdx++)
+	{
+		PositionRange = FMath::Max(PositionRange, State.BonePositions[BoneIdx].GetAbsMax());
+	}
+	Ar << PositionRange;
+	for (int32 BoneIdx = 0; BoneIdx < NumBones; BoneIdx++)
+	{
+		const FVector3f& Position = State.BonePositions[BoneIdx];
+		int16 X = Quantize(Position.X, PositionRange);
+		int16 Y = Quantize(Position.Y, PositionRange);
+		int16 Z = Quantize(Position.Z, PositionRange);
+		Ar << X << Y << Z;
+		WriteRotation(Ar, State.BoneRotations[BoneIdx]);
+	}
+}
+
+bool FNiagaraDestructionDriverSnapshot::Read(const TArray<uint8>& Snapshot, FNiagaraDestructionDriverSavedState& OutState)
+{
+	using namespace NiagaraDestructionDriverSnapshot;
+
+	OutState = FNiagaraDestructionDriverSavedState();
+	FMemoryReader Ar(Snapshot);
+
+	uint8 SnapshotVersion = 0;
+	uint8 Flags = 0;
+	Ar << SnapshotVersion << Flags;
+	if (Ar.IsError() || SnapshotVersion != Version)
+	{
+		return false;
+	}
+	OutState.bFragmentsDespawned = (Flags & FlagFragmentsDespawned) != 0;
+	OutState.bSettled = (Flags & FlagSettled) != 0;
+
+	int32 NumForces = 0;
+	Ar << NumForces;
+	if (NumForces < 0 || NumForces > Ar.TotalSize())
+	{
+		return false;
+	}
+	OutState.DestructionForceHistory.SetNum(NumForces);
+	for (FNiagaraDestructionDriverForce& Force : OutState.DestructionForceHistory)
+	{
+		Ar << Force.Origin << Force.Radius << Force.Duration << Force.StartTime;
+	}
+
+	TBitArray<> DespawnedBones;
+	Ar << DespawnedBones;
+	for (TConstSetBitIterator<> It(DespawnedBones); It; ++It)
+	{
+		OutState.DespawnedBones.Add(It.GetIndex());
+	}
+
+	if ((Flags & FlagHasPose) != 0)
+	{
+		const int32 NumBones = DespawnedBones.Num();
+		float PositionRange = 0.f;
+		Ar << PositionRange;
+		OutState.BonePositions.Reserve(NumBones);
+		OutState.BoneRotations.Reserve(NumBones);
+		for (int32 BoneIdx = 0; BoneIdx < NumBones && !Ar.IsError(); BoneIdx++)
+		{
+			int16 X = 0, Y = 0, Z = 0;
+			Ar << X << Y << Z;
+			OutState.BonePositions.Add(FVector3f(Dequantize(X, PositionRange), Dequantize(Y, PositionRange), Dequantize(Z, PositionRange)));
+			OutState.BoneRotations.Add(ReadRotation(Ar));
+		}
+	}
+	return !Ar.IsError();
+}
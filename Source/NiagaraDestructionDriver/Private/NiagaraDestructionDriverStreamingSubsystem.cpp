@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NiagaraDestructionDriverStreamingSubsystem.h"
+
+#include "NiagaraDestructionDriverSettings.h"
+#include "Engine/World.h"
+
+void UNiagaraDestructionDriverStreamingSubsystem::StoreState(const ANiagaraDestructionDriverActor* Destructible)
+{
+	FNiagaraDestructionDriverSavedState State;
+	if (Destructible == nullptr || !Destructible->CaptureState(State))
+	{
+		return;
+	}
+	StoredStates.Add(GetStateKey(Destructible), MoveTemp(State));
+}
+
+bool UNiagaraDestructionDriverStreamingSubsystem::ConsumeState(const ANiagaraDestructionDriverActor* Destructible, FNiagaraDestructionDriverSavedState& OutState)
+{
+	return Destructible && StoredStates.RemoveAndCopyValue(GetStateKey(Destructible), OutState);
+}
+
+FString UNiagaraDestructionDriverStreamingSubsystem::GetStateKey(const AActor* Destructible)
+{
+	// placed actors keep their name inside their level (or cell) package across reloads
+	return Destructible ? Destructible->GetPathName() : FString();
+}
+
+void UNiagaraDestructionDriverStreamingSubsystem::Deinitialize()
+{
+	StoredStates.Empty();
+	Super::Deinitialize();
+}
+
+bool UNiagaraDestructionDriverStreamingSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	// also headless, servers keep the force history of streamed out destructibles
+	return Super::ShouldCreateSubsystem(Outer) && GetDefault<UNiagaraDestructionDriverSettings>()->bPersistStreamedOutDestruction;
+}
+
+bool UNiagaraDestructionDriverStreamingSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -5,4 +5,6 @@
 #include "HAL/IConsoleManager.h"
 
 extern TAutoConsoleVariable<int32> CVarNDD_DebugCollisions;
-extern TAutoConsoleVariable<int32> CVarNDD_DebugMaterial;
\ No newline at end of file
+extern TAutoConsoleVariable<int32> CVarNDD_DebugMaterial;
+extern TAutoConsoleVariable<int32> CVarNDD_UseRuntimeContextCache;
+extern TAutoConsoleVariable<int32> CVarNDD_ForceHeadless;
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "Modules/ModuleManager.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogNiagaraDestructionDriver, Log, All);
+DECLARE_STATS_GROUP(TEXT("NiagaraDestructionDriver"), STATGROUP_NiagaraDestructionDriver, STATCAT_Advanced);
 
 class FNiagaraDestructionDriverModule : public IModuleInterface
 {
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NiagaraDestructionDriverActivationScheduler.generated.h"
+
+class ANiagaraDestructionDriverActor;
+
+/**
+ * Spreads the first-hit hot swap (activation, mesh/proxy visibility, bounds and material updates) of destructibles over
+ * several frames, see UNiagaraDestructionDriverSettings::bUseActivationBudget. Each frame the pending destructibles
+ * closest to a player camera and to the force that hit them go first, until MaxHotSwapsPerFrame or HotSwapTimeBudgetMs is used up.
+ */
+UCLASS()
+class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverActivationScheduler : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Queues the hot swap of a destructible hit by a force at ForceOrigin. The actor keeps its forces until it's run. */
+	void ScheduleHotSwap(ANiagaraDestructionDriverActor* Destructible, const FVector& ForceOrigin);
+
+	/** Removes a destructible that no longer needs its hot swap (reset, pooled or ending play) */
+	void CancelHotSwap(ANiagaraDestructionDriverActor* Destructible);
+
+	int32 GetNumPendingHotSwaps() const { return PendingHotSwaps.Num(); }
+
+	// <overrides>
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return PendingHotSwaps.Num() > 0; }
+	virtual void Deinitialize() override;
+	// </overrides>
+
+protected:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	struct FPendingHotSwap
+	{
+		TWeakObjectPtr<ANiagaraDestructionDriverActor> Destructible;
+		FVector ForceOrigin = FVector::ZeroVector;
+		double Priority = 0.0;
+	};
+
+	TArray<FPendingHotSwap> PendingHotSwaps;
+};
@@ -3,9 +3,94 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Math/Float16Color.h"
+#include "NiagaraDestructionDriverAtlasSubsystem.h"
 #include "NiagaraDestructionDriverDataAsset.h"
+#include "NiagaraDestructionDriverProxySubsystem.h"
 #include "NiagaraDestructionDriverActor.generated.h"
 
+class FNiagaraDestructionDriverRegionReadback;
+class UNiagaraDestructionDriverAssetLoader;
+class UNiagaraDestructionDriverInstancingSubsystem;
+class UNiagaraDestructionDriverSharedSimulationSubsystem;
+
+/**
+ * A single destruction force applied to a destructible.
+ */
+USTRUCT(BlueprintType)
+struct NIAGARADESTRUCTIONDRIVER_API FNiagaraDestructionDriverForce
+{
+	GENERATED_BODY()
+
+	FNiagaraDestructionDriverForce() = default;
+	FNiagaraDestructionDriverForce(const FVector& InOrigin, const float InRadius, const float InDuration, const float InStartTime)
+		: Origin(InOrigin), Radius(InRadius), Duration(InDuration), StartTime(InStartTime)
+	{}
+
+	/** World space center of the force */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	FVector Origin = FVector::ZeroVector;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	float Radius = 0.f;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	float Duration = 0.f;
+
+	/** World time (seconds) the force was requested at */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	float StartTime = 0.f;
+};
+
+/**
+ * Compact destruction state of a destructible, enough to show it settled again without resimulating.
+ * See ANiagaraDestructionDriverActor::CaptureState / RestoreState.
+ */
+USTRUCT(BlueprintType)
+struct NIAGARADESTRUCTIONDRIVER_API FNiagaraDestructionDriverSavedState
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, SaveGame, Category = "Niagara Destructible")
+	TArray<FNiagaraDestructionDriverForce> DestructionForceHistory;
+
+	/** Per bone position in [-1,1] mesh local space, like the positions render target. Empty when captured headless. */
+	UPROPERTY(SaveGame)
+	TArray<FVector3f> BonePositions;
+
+	/** Per bone rotation, like the rotations render target */
+	UPROPERTY(SaveGame)
+	TArray<FQuat4f> BoneRotations;
+
+	/** Fragments that despawned (see FragmentLifetime) */
+	UPROPERTY(SaveGame)
+	TArray<int32> DespawnedBones;
+
+	/** Every fragment despawned, nothing is left to show */
+	UPROPERTY(BlueprintReadOnly, SaveGame, Category = "Niagara Destructible")
+	bool bFragmentsDespawned = false;
+
+	/** Was settled when captured. States with a pose are always restored settled, headless ones only with this set. */
+	UPROPERTY(BlueprintReadOnly, SaveGame, Category = "Niagara Destructible")
+	bool bSettled = false;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnNiagaraDestructibleSettled, ANiagaraDestructionDriverActor*, Destructible);
+
+/** How much simulation a destroyed destructible gets, see UNiagaraDestructionDriverSignificanceSubsystem */
+UENUM(BlueprintType)
+enum class ENiagaraDestructionDriverSignificanceTier : uint8
+{
+	/** Simulated every frame */
+	Full,
+	/** Simulated at SignificanceThresholds.ReducedUpdateRate, catching up in larger steps */
+	Reduced,
+	/** Paused where it is, resumes once significant again */
+	Frozen,
+	/** Settled early: the simulation is released and, with bBakeSettledDestructibles, the pose baked into a static mesh. The next force brings it back to Full. */
+	Baked
+};
+
 /**
  * Represents Niagara Destructible
  * - initializes the render targets used to drive vertex WPO of the niagara destructible mesh materials.
@@ -47,6 +132,13 @@ public:
 	 */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible")
 	TObjectPtr<UTextureRenderTarget2D> PositionsTexture;
+
+	/**
+	 * UV offset (XY) and scale (ZW) of this actor's region inside PositionsTexture and RotationsTexture.
+	 * Always (0,0,1,1) unless the render target atlas is enabled in the plugin settings.
+	 */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "Niagara Destructible")
+	FVector4 RenderTargetTileOffsetScale = FVector4(0.f, 0.f, 1.f, 1.f);
 	
 	/**
 	 * Forces the mesh to use the debug material. This is useful if you have
@@ -59,10 +151,44 @@ public:
 	/**
 	 * How much to extend the mesh bounds by to prevent occlusion culling from hiding the
 	 * fragments offset by WPO in the vertex shader.
+	 * With bUseDynamicBounds (plugin settings) this is only used right after the first hit, until the
+	 * bounds computed from the simulated fragment positions take over.
 	 */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible")
 	float CullingBoundsMultiplier = 4.f;
 
+	/**
+	 * Defer creating the render targets, dynamic materials and niagara setup until this destructible is
+	 * actually needed (first destruction force or a player getting close). Until then only the
+	 * SourceGeometryContainer proxies are shown and no GPU resources are held.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible")
+	bool bLazyActivation = false;
+
+	/**
+	 * With lazy activation, also activate when a player camera comes within this distance.
+	 * 0 means only activate on the first destruction force.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible", meta=(EditCondition="bLazyActivation", ClampMin=0))
+	float LazyActivationDistance = 0.f;
+
+	/**
+	 * With lazy activation, start streaming in the destructible mesh and bone texture when a player camera comes within this
+	 * distance (keep it a bit larger than LazyActivationDistance), and let go of them again once every camera is 1.5 times as far.
+	 * 0 means they are only streamed in on activation or PrefetchDestructionAssets. See bStreamDestructibleMeshes (plugin settings).
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible", meta=(EditCondition="bLazyActivation", ClampMin=0))
+	float AssetStreamingDistance = 0.f;
+
+	/**
+	 * For destructibles that move after spawning (attached to vehicles, elevators, rotating platforms): re-sends ActorRotationQuat
+	 * to the materials whenever the mesh component's rotation actually changed. Moves that don't rotate cost nothing, and with
+	 * bUseCustomPrimitiveData (plugin settings) the update is a single custom primitive data write.
+	 * The niagara system needs to simulate in local space. Needs a movable root component.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible")
+	bool bTrackTransformChanges = false;
+
 	/**
 	 * Use this to "destroy" parts of this actor. Under the hood it
 	 * provides destruction force input to the underlying
@@ -70,6 +196,133 @@ public:
 	 */
 	UFUNCTION()
 	void InitiateDestructionForce(FVector ForceOrigin, float ForceRadius, float ForceDuration = 0.1f);
+
+	/**
+	 * Creates the render targets, dynamic materials and configures the niagara system.
+	 * Called from BeginPlay unless bLazyActivation is set. Does nothing if already activated.
+	 * If the niagara system (or debug material) is not loaded yet, it is streamed in asynchronously first
+	 * and any destruction force that arrives in the meantime is queued and replayed.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Niagara Destructible")
+	void ActivateDestructible();
+
+	/**
+	 * Re-arms a destroyed destructible: clears the simulation, force history and settled state, hides the
+	 * destructible mesh and shows the SourceGeometryContainer proxies again. Materials and render targets are kept, unless this is
+	 * a lazily activated destructible and bStreamDestructibleMeshes (plugin settings) is on: those let go of everything including the
+	 * streamed mesh and bone texture and activate again when needed.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Niagara Destructible")
+	void ResetToRestingState();
+
+	/**
+	 * Starts streaming in the destructible mesh and bone texture without activating, so a hit that is about to happen doesn't wait
+	 * on the load. Call it when a force is predicted nearby (see UNiagaraDestructionDriverHelper::PrefetchDestructionAssets).
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Niagara Destructible")
+	void PrefetchDestructionAssets();
+
+	/** Stops the niagara simulation and proximity checks while the actor sits unused in UNiagaraDestructionDriverActorPool. ResetToRestingState resumes it. */
+	void SuspendSimulation();
+
+	/**
+	 * Settles now instead of SettleQuietTime after the last force: the simulation stops and the render targets keep the current
+	 * pose. Does nothing while resting or once settled.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Niagara Destructible")
+	void SettleNow();
+
+	/** Gives the niagara component borrowed from UNiagaraDestructionDriverNiagaraComponentPool back, see bPoolNiagaraComponents (plugin settings) */
+	void ReturnNiagaraComponent();
+
+	/** Called by UNiagaraDestructionDriverActivationScheduler when it's this destructible's turn: hot swaps and applies the deferred forces. */
+	void RunScheduledHotSwap();
+
+	/**
+	 * Captures the destruction state (force history, settled bone transforms, despawned fragments) of a destroyed destructible.
+	 * Never reads back: the pose is the one read back asynchronously once settled (or restored), destructibles still simulating are
+	 * captured without one and replay their forces when restored. Returns false while resting.
+	 */
+	bool CaptureState(FNiagaraDestructionDriverSavedState& OutState) const;
+
+	/**
+	 * Shows a captured destruction state right away as settled: bakes the pose if settled destructibles are baked, otherwise
+	 * writes it into the render targets once activated. The niagara simulation is not run. States captured headless (no pose)
+	 * replay their force history instead.
+	 */
+	void RestoreState(const FNiagaraDestructionDriverSavedState& State);
+
+	/**
+	 * Compact save game snapshot of the destruction state (see FNiagaraDestructionDriverSnapshot), empty while resting.
+	 * Also written/read automatically when the actor is serialized into a save game archive (ArIsSaveGame).
+	 * Cheap enough to save thousands of destructibles at once: it goes through CaptureState, which never reads back the GPU.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Niagara Destructible")
+	bool SaveSnapshot(TArray<uint8>& OutSnapshot) const;
+
+	/** Restores a SaveSnapshot, resetting the destructible first if it was already damaged. Before BeginPlay it's applied in BeginPlay. */
+	UFUNCTION(BlueprintCallable, Category = "Niagara Destructible")
+	bool LoadSnapshot(const TArray<uint8>& Snapshot);
+
+	/** Size of the last snapshot saved by this destructible */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	int32 GetLastSnapshotSizeBytes() const { return LastSnapshotSizeBytes; }
+
+	/** Game thread time of the last RestoreState (including uploading or baking the pose once activated) */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	float GetLastRestoreTimeMs() const { return LastRestoreTimeMs; }
+
+	/** Does this destructible hold its runtime resources. False again once lazily reset, baked or every fragment despawned. */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	bool IsActivated() const { return bIsActivated; }
+
+	/** Is this destructible untouched by destruction forces */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	bool IsInRestingState() const { return bIsInRestingState; }
+
+	/**
+	 * Running without render resources (dedicated server, -nullrhi or r.NDD.ForceHeadless).
+	 * Only the logical destruction state (resting/damaged and DestructionForceHistory) is kept.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	bool IsHeadless() const { return bIsHeadless; }
+
+	/** Has the destruction simulation come to rest and been released (until the next force), see UNiagaraDestructionDriverSettings::SettleQuietTime */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	bool IsSettled() const { return bIsSettled; }
+
+	/** Slot in the instance group of its data asset (see UNiagaraDestructionDriverDataAsset::bInstanced), INDEX_NONE when drawn on its own */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	int32 GetInstanceSlot() const { return InstanceSlot; }
+
+	/** Simulated in the shared system of its atlas page (see UNiagaraDestructionDriverSettings::bUseSharedSimulation) instead of NiagaraComponent */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	bool UsesSharedSimulation() const { return bUsesSharedSimulation; }
+
+	/** Simulation tier picked by UNiagaraDestructionDriverSignificanceSubsystem while simulating, Full otherwise */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	ENiagaraDestructionDriverSignificanceTier GetSignificanceTier() const { return SignificanceTier; }
+
+	/**
+	 * Called by UNiagaraDestructionDriverSignificanceSubsystem. Reduced and Frozen only apply to destructibles driving their own
+	 * NiagaraComponent, instance groups and shared simulations are simulated as a whole. Baked settles any destructible, until
+	 * the next force wakes it up at Full.
+	 */
+	void SetSignificanceTier(const ENiagaraDestructionDriverSignificanceTier Tier);
+
+	/** Fired whenever the fragments came to rest and the niagara simulation was released, again after a force woke them up */
+	UPROPERTY(BlueprintAssignable, Category = "Niagara Destructible")
+	FOnNiagaraDestructibleSettled OnSettled;
+
+	/** The latest destruction forces applied to this destructible (at most MaxDestructionForceHistory, see plugin settings), oldest first */
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "Niagara Destructible")
+	TArray<FNiagaraDestructionDriverForce> DestructionForceHistory;
+
+	/**
+	 * Estimated memory of the render resources held by this actor: its render targets (or its share of the atlas page),
+	 * dynamic materials and niagara component. Shared assets (mesh, bone texture, niagara system, shared materials) are not included.
+	 */
+	SIZE_T GetRenderResourceSizeBytes() const;
 	
 	// <components>
 	UPROPERTY(BlueprintReadWrite, EditDefaultsOnly) TObjectPtr<USceneComponent> SourceGeometryContainer; // will contain original static meshes used in the geometry collection that was processed into this actor
@@ -80,6 +333,8 @@ public:
 	// <overrides>
 	virtual void PostInitProperties() override;
 	virtual void PostInitializeComponents() override;
+	virtual void Tick(float DeltaSeconds) override;
+	virtual void Serialize(FArchive& Ar) override;
 #if WITH_EDITOR
 	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
 #endif
@@ -88,15 +343,284 @@ public:
 protected:
 
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 private:
 
+	/**
+	 * Hands the force to the niagara simulation, activating (or queueing while loading) first.
+	 * @param bAllowDeferral queue the first-hit hot swap on UNiagaraDestructionDriverActivationScheduler (bUseActivationBudget)
+	 */
+	void ApplyDestructionForce(const FNiagaraDestructionDriverForce& Force, const bool bAllowDeferral = true);
+
+	/** Drops a pending hot swap from UNiagaraDestructionDriverActivationScheduler */
+	void CancelScheduledHotSwap();
+
+	/** Second half of ActivateDestructible once all soft referenced assets are in memory */
+	void FinishActivation();
+
+	/**
+	 * Takes a slot in the data asset's instance group instead of setting up our own render targets, materials and niagara system.
+	 * False if the data asset isn't instanced, needs per actor materials (fragment lifetime, debug material) or the group is full.
+	 */
+	bool AcquireInstance(const FNiagaraDestructionDriverRuntimeContext& Context);
+	void ReleaseInstance();
+
+	UNiagaraDestructionDriverInstancingSubsystem* GetInstancing() const;
+
+	/**
+	 * Takes a bone range in the shared simulation of our atlas page instead of setting up NiagaraComponent.
+	 * False if shared simulation is disabled, we have no atlas tile or the shared simulation has no room (see AcquireRange).
+	 */
+	bool AcquireSharedSimulation(const FNiagaraDestructionDriverRuntimeContext& Context);
+	void ReleaseSharedSimulation();
+
+	UNiagaraDestructionDriverSharedSimulationSubsystem* GetSharedSimulation() const;
+
+	/** Registers with the significance subsystem (bUseSignificance) once simulating, starting at Full */
+	void EnterSignificance();
+
+	/** Leaves the significance subsystem and runs NiagaraComponent at full rate again */
+	void ExitSignificance();
+
+	/** Sets the niagara user parameters of NiagaraComponent and centers it against the destructible mesh */
+	void ConfigureNiagaraComponent(const FNiagaraDestructionDriverRuntimeContext& Context);
+
+	/**
+	 * Borrows, configures and activates a pooled NiagaraComponent on the first hit, or creates one of our own if the pool can't lend one.
+	 * False if there is no particle system to simulate with.
+	 */
+	bool BorrowNiagaraComponent();
+
+	/** Shows the destroyed destructible: MeshComponent, or our instance in the data asset's instance group */
+	void ShowDestructibleMesh();
+
+	/** Applies the forces that arrived while activating */
+	void ReplayQueuedDestructionForces();
+
+	/**
+	 * Swaps the meshes under SourceGeometryContainer for instances of the world's proxy batches, see
+	 * UNiagaraDestructionDriverSettings::bBatchSourceGeometry. Their components are destroyed.
+	 */
+	void BatchSourceGeometry();
+
+	/** Shows or hides the intact proxies: SourceGeometryContainer, or our instances in the proxy batches */
+	void SetSourceGeometryVisible(const bool bVisible);
+
+	/** The game instance's asset loader, null in worlds without a game instance (editor previews) */
+	UNiagaraDestructionDriverAssetLoader* GetAssetLoader() const;
+
+	/** Keeps the streamed assets (mesh, bone texture) of the data asset resident through the asset loader until ReleaseStreamedAssets */
+	void RetainStreamedAssets();
+
+	/** Retains the streamed assets and calls OnLoaded once they are in memory (right away if they already are) */
+	void LoadStreamedAssets(FSimpleDelegate OnLoaded);
+
+	/**
+	 * Lets go of the streamed assets so they can unload. Only with bStreamDestructibleMeshes (plugin settings) unless forced.
+	 * Whatever still binds them (mesh component, materials, niagara parameters) has to be cleared first.
+	 */
+	void ReleaseStreamedAssets(const bool bForce = false);
+
+	/** Drops the render targets, materials and niagara bindings of an activated destructible, back to the proxies only state */
+	void DeactivateDestructible();
+
+	/** (Re)starts the timer that settles this destructible SettleQuietTime after the last force ended. */
+	void ScheduleSettleCheck();
+	void CheckSettled();
+
+	/** Stops and releases the niagara simulation, the render targets keep the last pose. */
+	void Settle();
+
+	/** Undoes Settle for a new force: a baked pose goes back to the render targets, the force restarts the simulation. */
+	void WakeFromSettled();
+
+	/** This actor's RenderTargetTextureSize x RenderTargetTextureSize region of the simulation render targets */
+	FIntRect GetSimulationRegion(const UTextureRenderTarget2D* RenderTarget) const;
+
+	/** Uniform bounds scale around the mesh center that contains every live fragment at these positions */
+	float ComputeBoundsScale(const TArray<FFloat16Color>& Positions) const;
+
+	/** Polls the fragment positions readback and fits the mesh bounds around the debris, see bUseDynamicBounds */
+	void UpdateDynamicBounds();
+	/** Starts the dynamic bounds readbacks unless they're already running, every force restarts them */
+	void StartDynamicBounds();
+	void StopDynamicBounds();
+
+	/** Sets the bounds scale of MeshComponent and the ObjectBoundsScale of its materials */
+	void ApplyBoundsScale(const float BoundsScale, const bool bForce = false);
+
+	/** Passes the actor rotation to the materials (custom primitive data or material parameter) */
+	void ApplyActorRotation();
+
+	/** Bound to MeshComponent->TransformUpdated with bTrackTransformChanges */
+	void OnMeshTransformUpdated(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+	/** Hands shared materials back to UNiagaraDestructionDriverMaterialCache and forgets MeshMaterialsWithParamsSet */
+	void ReleaseMaterials();
+
+	/** Swaps the WPO driven mesh for a static mesh baked from SettledBonePositions/Rotations and returns the render targets. */
+	void BakeSettledMesh();
+
+	/**
+	 * Starts reading back the settled bone transforms into SettledBonePositions/Rotations without stalling, the render targets keep
+	 * showing them in the meantime. See PollSettledPose.
+	 */
+	void ReadSettledPose();
+
+	/** Collects the settled pose readbacks and bakes once both arrived */
+	void PollSettledPose();
+	void CancelSettledPoseReadback();
+
+	/** Starts shrinking the fragments below the data asset's FragmentDespawnSizeThreshold once their lifetime is up. */
+	void StartFragmentDespawn();
+	void UpdateFragmentDespawn();
+
+	/** Writes BoneScales to BoneScaleMask */
+	void UpdateBoneScaleMask();
+
+	/** Every fragment is gone: drops the mesh, the niagara instance and the render targets. */
+	void ReleaseDestroyedMesh();
+
+	/** Assigns PositionsTexture/RotationsTexture either from the world atlas or as dedicated (pooled) render targets. */
+	void AcquireRenderTargets();
+	void ReleaseRenderTargets();
+
+	/** The atlas tile backing the render targets (invalid when using dedicated render targets). */
+	UPROPERTY() FNiagaraDestructionDriverAtlasTile RenderTargetAtlasTile;
+
+	/** True when PositionsTexture/RotationsTexture were borrowed from the world render target pool. */
+	UPROPERTY() bool bRenderTargetsArePooled = false;
+
+	/** See GetInstanceSlot. PositionsTexture/RotationsTexture are the group's then. */
+	UPROPERTY() int32 InstanceSlot = INDEX_NONE;
+
+	/** See UsesSharedSimulation. Our atlas tile is written by the shared system then. */
+	UPROPERTY() bool bUsesSharedSimulation = false;
+
+	/** NiagaraComponent is borrowed from the world's niagara component pool until settled or reset */
+	UPROPERTY() bool bNiagaraComponentIsPooled = false;
+
+	/** See GetSignificanceTier */
+	UPROPERTY() ENiagaraDestructionDriverSignificanceTier SignificanceTier = ENiagaraDestructionDriverSignificanceTier::Full;
+
+	/** The SourceGeometryContainer meshes, once BatchSourceGeometry replaced them */
+	UPROPERTY() TArray<FNiagaraDestructionDriverProxyMesh> BatchedSourceGeometry;
+
+	/** Proxy id of each BatchedSourceGeometry mesh while shown */
+	TArray<int32> SourceGeometryProxies;
+
 	/**
 	 * The static mesh has materials where vertex WPO is driven by render targets coming from niagara.
 	 * We need to wire all these parameters up. This array will be filled with these materials.
 	 */
 	UPROPERTY() TArray<TObjectPtr<UMaterialInstanceDynamic>> MeshMaterialsWithParamsSet;
+
+	/**
+	 * MeshMaterialsWithParamsSet are shared with other actors (UNiagaraDestructionDriverMaterialCache) and must not be modified,
+	 * per actor values go through custom primitive data instead.
+	 */
+	UPROPERTY() bool bMaterialsAreShared = false;
 	
 	/** Is this destructible in resting state (untouched) or already damaged */
 	UPROPERTY() bool bIsInRestingState;
+
+	/** Have the render targets, materials and niagara system been set up */
+	UPROPERTY() bool bIsActivated = false;
+
+	/** Decided in BeginPlay, see IsHeadless */
+	UPROPERTY() bool bIsHeadless = false;
+
+	UPROPERTY() bool bIsSettled = false;
+
+	/** Transient mesh holding the settled pose, see UNiagaraDestructionDriverSettings::bBakeSettledDestructibles */
+	UPROPERTY(Transient) TObjectPtr<UStaticMesh> BakedStaticMesh;
+
+	/**
+	 * Bone transforms read back once settled (or restored), what CaptureState saves. BakedStaticMesh is built from them, kept to
+	 * rebake without despawned fragments.
+	 */
+	TArray<FFloat16Color> SettledBonePositions;
+	TArray<FFloat16Color> SettledBoneRotations;
+
+	FTimerHandle SettledPoseTimerHandle;
+	TSharedPtr<FNiagaraDestructionDriverRegionReadback> SettledPositionsReadback;
+	TSharedPtr<FNiagaraDestructionDriverRegionReadback> SettledRotationsReadback;
+
+	/**
+	 * Per bone scale (255 = full size) read by the material as BoneScaleMask, laid out like the simulation render targets.
+	 * Only created when the data asset has a fragment lifetime.
+	 */
+	UPROPERTY(Transient) TObjectPtr<UTexture2D> BoneScaleMask;
+	TArray<uint8> BoneScales;
+
+	/** Bones that are shrinking away or already gone */
+	TBitArray<> DespawningBones;
+
+	FTimerHandle DespawnTimerHandle;
+	float DespawnStartTime = 0.f;
+
+	/** All fragments despawned and the destroyed mesh was released */
+	UPROPERTY() bool bFragmentsDespawned = false;
+
+	/** World time the latest destruction force stops pushing */
+	float LastForceEndTime = 0.f;
+
+	FTimerHandle SettleTimerHandle;
+
+	/** Positions read back at SettlePositionsSnapshotTime, to measure fragment velocity when bConfirmSettleWithVelocity is set */
+	TArray<FFloat16Color> SettlePositionsSnapshot;
+	float SettlePositionsSnapshotTime = 0.f;
+
+	/** The next positions sample, requested at SettleReadbackTime */
+	TSharedPtr<FNiagaraDestructionDriverRegionReadback> SettleReadback;
+	float SettleReadbackTime = 0.f;
+
+	FTimerHandle DynamicBoundsTimerHandle;
+	TSharedPtr<FNiagaraDestructionDriverRegionReadback> BoundsReadback;
+
+	/** The readback in flight was requested after settling, so it's the last one needed */
+	bool bBoundsReadbackWhileSettled = false;
+
+	/** The readback in flight was requested after the last force ended */
+	bool bBoundsReadbackAfterForces = false;
+
+	/** Bounds scale of the previous readback taken after the last force ended, 0 if there is none */
+	float LastBoundsSampleScale = 0.f;
+
+	float CurrentBoundsScale = 1.f;
+
+	/** Rotation last sent to the materials as ActorRotationQuat */
+	FQuat AppliedActorRotation = FQuat::Identity;
+
+	FDelegateHandle TransformUpdatedHandle;
+
+	/** Waiting on the asset loader before activation can finish */
+	bool bIsLoadingAssets = false;
+
+	/** Forces that arrived while the assets were loading or the hot swap was waiting on the activation scheduler */
+	TArray<FNiagaraDestructionDriverForce> QueuedDestructionForces;
+
+	/** Waiting on UNiagaraDestructionDriverActivationScheduler */
+	bool bIsHotSwapScheduled = false;
+
+	/** State to restore in BeginPlay (streamed out or loaded from a save game before play) */
+	FNiagaraDestructionDriverSavedState PendingSavedState;
+	bool bHasPendingSavedState = false;
+
+	mutable int32 LastSnapshotSizeBytes = 0;
+	float LastRestoreTimeMs = 0.f;
+
+	/** Pose from RestoreState, written into the render targets at the end of FinishActivation */
+	TArray<FFloat16Color> RestoredBonePositions;
+	TArray<FFloat16Color> RestoredBoneRotations;
+
+	/** Writes RestoredBonePositions/Rotations into the render targets and shows them settled */
+	void ApplyRestoredPose();
+
+	/** Bakes RestoredBonePositions/Rotations into BakedStaticMesh instead, false if the data asset can't be baked */
+	bool BakeRestoredPose();
+
+	/** Data asset whose streamed assets this destructible retains, null while it holds none */
+	UPROPERTY(Transient) TObjectPtr<UNiagaraDestructionDriverDataAsset> StreamedAssetsDataAsset;
 };
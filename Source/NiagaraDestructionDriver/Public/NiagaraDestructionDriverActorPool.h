@@ -0,0 +1,54 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NiagaraDestructionDriverActorPool.generated.h"
+
+class ANiagaraDestructionDriverActor;
+class UNiagaraDestructionDriverDataAsset;
+
+/** Re-armed destructibles of one data asset waiting to be handed out again. */
+USTRUCT()
+struct FNiagaraDestructionDriverActorBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY() TArray<TObjectPtr<ANiagaraDestructionDriverActor>> FreeActors;
+};
+
+/**
+ * Hands out re-armed destructibles instead of spawning a new actor (with its own materials and render targets)
+ * every time a prop respawns. Released actors are reset to their resting state, hidden and kept per data asset.
+ */
+UCLASS()
+class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverActorPool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * Returns a destructible in its resting state at the given transform, reusing a released one if possible.
+	 * @param DestructibleClass the actor (blueprint) class to spawn, defaults to ANiagaraDestructionDriverActor
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Niagara Destructible", meta = (DeterminesOutputType = "DestructibleClass"))
+	ANiagaraDestructionDriverActor* SpawnDestructible(UNiagaraDestructionDriverDataAsset* DataAsset, const FTransform& Transform, TSubclassOf<ANiagaraDestructionDriverActor> DestructibleClass = nullptr);
+
+	/** Resets, hides and keeps the destructible for a later SpawnDestructible. Destroys it if the pool is full. */
+	UFUNCTION(BlueprintCallable, Category = "Niagara Destructible")
+	void ReleaseDestructible(ANiagaraDestructionDriverActor* Destructible);
+
+	/** Number of released destructibles waiting in the pool */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	int32 GetNumFreeDestructibles() const;
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	UPROPERTY() TMap<TObjectPtr<UNiagaraDestructionDriverDataAsset>, FNiagaraDestructionDriverActorBucket> Buckets;
+};
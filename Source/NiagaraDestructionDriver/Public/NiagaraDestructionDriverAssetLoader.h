@@ -0,0 +1,98 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StreamableManager.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "NiagaraDestructionDriverAssetLoader.generated.h"
+
+class UNiagaraDestructionDriverDataAsset;
+
+/**
+ * Asynchronously loads the soft referenced assets destructibles need at runtime (niagara driver system, destructible mesh,
+ * bone texture, debug material) so activation never blocks the game thread with LoadSynchronous.
+ *
+ * Requests are batched per asset: every actor waiting for the same niagara system shares one streamable request.
+ * The destructible mesh and bone texture of a data asset are only kept resident while someone retains them, see RetainStreamedAssets.
+ */
+UCLASS()
+class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverAssetLoader : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** The asset bundle on UNiagaraDestructionDriverDataAsset that holds everything needed to activate a destructible. */
+	static const FName DestructionBundleName;
+
+	/**
+	 * Calls OnLoaded once all of the given assets are loaded.
+	 * If they are already in memory OnLoaded is executed immediately, before this function returns.
+	 */
+	void RequestAssets(const TArray<FSoftObjectPath>& AssetPaths, FSimpleDelegate OnLoaded);
+
+	/**
+	 * Starts loading the destruction bundle of the given data assets and keeps it resident until the world is torn down.
+	 * Use this during level load for props you know will be destroyed.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Niagara Destructible")
+	void PreloadDataAssets(const TArray<UNiagaraDestructionDriverDataAsset*>& DataAssets);
+
+	/** Is there an outstanding load for the given asset */
+	bool IsLoading(const FSoftObjectPath& AssetPath) const { return PendingAssets.Contains(AssetPath); }
+
+	/**
+	 * Starts streaming in the destructible mesh and bone texture of this data asset (if needed) and keeps them resident until
+	 * every retain was released. Use RequestAssets to wait for them.
+	 */
+	void RetainStreamedAssets(UNiagaraDestructionDriverDataAsset* DataAsset);
+
+	/** Once the last retain is gone the streamed assets are no longer referenced and get unloaded by the next garbage collection. */
+	void ReleaseStreamedAssets(UNiagaraDestructionDriverDataAsset* DataAsset);
+
+	/** Logs which data assets placed in the world keep their streamed assets resident and the memory held vs. released. */
+	void DumpStreamingStats(UWorld* World) const;
+
+	// <overrides>
+	virtual void Deinitialize() override;
+	// </overrides>
+
+private:
+
+	struct FPendingRequest
+	{
+		int32 NumOutstanding = 0;
+		FSimpleDelegate OnLoaded;
+		/** keeps already loaded assets of this request alive until all of them are in */
+		TArray<TSharedPtr<FStreamableHandle>> Handles;
+	};
+
+	struct FPendingAsset
+	{
+		TSharedPtr<FStreamableHandle> Handle;
+		TArray<TSharedRef<FPendingRequest>> Requests;
+	};
+
+	struct FRetainedAssets
+	{
+		int32 NumRetains = 0;
+		TSharedPtr<FStreamableHandle> Handle;
+		/** Counted in the NDD Resident Streamed Assets memory stat once loaded */
+		SIZE_T ResidentBytes = 0;
+	};
+
+	void OnAssetLoaded(FSoftObjectPath AssetPath);
+	void OnStreamedAssetsLoaded(TWeakObjectPtr<UNiagaraDestructionDriverDataAsset> WeakDataAsset);
+
+	TMap<FSoftObjectPath, FPendingAsset> PendingAssets;
+
+	/** Keeps preloaded bundles resident */
+	TArray<TSharedPtr<FStreamableHandle>> PreloadHandles;
+
+	TMap<TObjectKey<UNiagaraDestructionDriverDataAsset>, FRetainedAssets> RetainedAssets;
+
+	/** Size of the streamed assets of every data asset that was resident at some point, to report what releasing them saves */
+	TMap<TObjectKey<UNiagaraDestructionDriverDataAsset>, SIZE_T> KnownStreamedAssetBytes;
+};
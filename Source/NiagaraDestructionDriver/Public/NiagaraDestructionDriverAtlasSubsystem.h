@@ -0,0 +1,133 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NiagaraDestructionDriverAtlasSubsystem.generated.h"
+
+class UTextureRenderTarget2D;
+
+/**
+ * A square region of a shared positions/rotations atlas page handed out to a single destructible.
+ */
+USTRUCT(BlueprintType)
+struct NIAGARADESTRUCTIONDRIVER_API FNiagaraDestructionDriverAtlasTile
+{
+	GENERATED_BODY()
+
+	/** Index of the atlas page (render target pair) this tile lives in. INDEX_NONE if unallocated. */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 PageIndex = INDEX_NONE;
+
+	/** Top left texel of the tile inside the atlas page. */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	FIntPoint Origin = FIntPoint::ZeroValue;
+
+	/** Width and height of the tile in texels (always a power of two). */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 Size = 0;
+
+	bool IsValid() const { return PageIndex != INDEX_NONE; }
+};
+
+/**
+ * Occupancy report for the render target atlas of a world. Used to size the atlas per map.
+ */
+USTRUCT(BlueprintType)
+struct NIAGARADESTRUCTIONDRIVER_API FNiagaraDestructionDriverAtlasStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 NumPages = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 NumTiles = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int64 UsedTexels = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int64 TotalTexels = 0;
+
+	/** The largest tile size that can still be allocated without adding a new page. */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 LargestFreeTileSize = 0;
+
+	/** Used texels / total texels in [0,1]. */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	float Occupancy = 0.f;
+
+	/** 1 - (largest free block / total free texels) in [0,1]. 0 means all free space is one contiguous block. */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	float Fragmentation = 0.f;
+};
+
+/**
+ * Packs the simulation render targets of every destructible in a world into a few large atlas pages
+ * instead of one positions + rotations render target pair per actor.
+ *
+ * Each page is split with a quad-tree buddy allocator so tiles are always power of two sized, aligned,
+ * and coalesce back into bigger blocks when released.
+ * Materials and the niagara system address their tile with a (offset.xy, scale.zw) vector.
+ */
+UCLASS()
+class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverAtlasSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * Finds room for a tile of at least RequestedSize x RequestedSize texels, adding a new page if needed.
+	 * The tile is cleared to black before it is returned.
+	 * @return false if the tile does not fit in a page or the page limit is reached.
+	 */
+	bool AcquireTile(const int32 RequestedSize, FNiagaraDestructionDriverAtlasTile& OutTile);
+
+	/** Returns the tile to the allocator and resets it. */
+	void ReleaseTile(FNiagaraDestructionDriverAtlasTile& Tile);
+
+	UTextureRenderTarget2D* GetPositionsPage(const FNiagaraDestructionDriverAtlasTile& Tile) const;
+	UTextureRenderTarget2D* GetRotationsPage(const FNiagaraDestructionDriverAtlasTile& Tile) const;
+
+	/** UV offset (XY) and scale (ZW) of the tile inside its page. */
+	FVector4 GetTileOffsetScale(const FNiagaraDestructionDriverAtlasTile& Tile) const;
+
+	UFUNCTION(BlueprintCallable, Category = "Niagara Destructible")
+	FNiagaraDestructionDriverAtlasStats GetAtlasStats() const;
+
+	/** Writes the atlas stats to the log. */
+	void DumpAtlasStats() const;
+
+	// <overrides>
+	virtual void Deinitialize() override;
+	// </overrides>
+
+protected:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	struct FAtlasPage
+	{
+		/** Free blocks per level where level N holds blocks of (1 << N) x (1 << N) texels. */
+		TArray<TArray<FIntPoint>> FreeBlocks;
+		int32 NumTiles = 0;
+		int64 UsedTexels = 0;
+	};
+
+	bool AllocateFromPage(FAtlasPage& Page, const int32 Level, FIntPoint& OutOrigin) const;
+	void FreeToPage(FAtlasPage& Page, const int32 Level, const FIntPoint Origin) const;
+	int32 AddPage();
+	void ClearTile(const FNiagaraDestructionDriverAtlasTile& Tile);
+
+	int32 PageSize = 0;
+	TArray<FAtlasPage> Pages;
+
+	UPROPERTY() TArray<TObjectPtr<UTextureRenderTarget2D>> PositionsPages;
+	UPROPERTY() TArray<TObjectPtr<UTextureRenderTarget2D>> RotationsPages;
+};
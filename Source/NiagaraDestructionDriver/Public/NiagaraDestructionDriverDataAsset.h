@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "NiagaraSystem.h"
+#include "NiagaraDestructionDriverRuntimeContext.h"
 #include "GeometryCollection/GeometryCollectionObject.h"
 #include "NiagaraDestructionDriverDataAsset.generated.h"
 
@@ -29,9 +30,10 @@ class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverDataAsset : public U
 	 * The static mesh asset generated by the chaos-to-niagara tool.
 	 * Each vertex in this static mesh has a custom UV channel value that holds
 	 * the bone index that this vertex was bound to in the original chaos geometry collection.
+	 * Soft referenced so placed destructibles only keep it resident while they need it, see GetStreamedAssetPaths.
 	 */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible")
-	TObjectPtr<UStaticMesh> StaticMesh;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible", meta = (AssetBundles = "Destruction"))
+	TSoftObjectPtr<UStaticMesh> StaticMesh;
 
 	/**
 	 * The index of the UV channel where the bone index from the geometry collection is written to.
@@ -49,10 +51,11 @@ class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverDataAsset : public U
 	/**
 	 * The texture generated by the chaos-to-niagara tool whose RGB values
 	 * are the XYZ of the initial local positions of each of the bones of the
-	 * chaos geometry collection that was processed using the chaos-to-niagara tool
+	 * chaos geometry collection that was processed using the chaos-to-niagara tool.
+	 * Streamed in and out together with StaticMesh.
 	 */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible")
-	TObjectPtr<UTexture2D> InitialBoneLocationsTexture;
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible", meta = (AssetBundles = "Destruction"))
+	TSoftObjectPtr<UTexture2D> InitialBoneLocationsTexture;
 
 	/**
 	 * The size of the render target texture. Since each pixel holds one "bone" we want this to be sufficiently larged that the
@@ -63,7 +66,88 @@ class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverDataAsset : public U
 
 	/**
 	 * The niagara system used to drive the GPU simulated destructible. The default can be configured in plugin settings.
+	 * Part of the "Destruction" asset bundle so it can be preloaded through the asset manager.
 	 */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible")
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible", meta = (AssetBundles = "Destruction"))
 	TSoftObjectPtr<UNiagaraSystem> ParticleSystemDriver;
+
+	/**
+	 * Draw and simulate every destructible using this data asset with one instanced mesh, one niagara system and one pair of
+	 * render targets (UNiagaraDestructionDriverInstancingSubsystem) instead of a mesh, niagara system, render targets and dynamic
+	 * materials each. The slot materials have to read the per instance custom data and ParticleSystemDriver has to simulate the
+	 * instance arrays, see the README. Not used with a fragment lifetime.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible|Instancing")
+	bool bInstanced = false;
+
+	/**
+	 * CPU copy of the initial bone locations in InitialBoneLocationsTexture (same normalized [-1,1] space, one entry per bone).
+	 * Needed to bake settled destructibles into a plain static mesh, filled by the chaos-to-niagara tool.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible|Baking")
+	TArray<FVector3f> InitialBoneLocations;
+
+	/**
+	 * Materials without the niagara destruction WPO, one per material slot of StaticMesh.
+	 * Used by settled destructibles once their fragments are baked into a static mesh.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible|Baking")
+	TArray<TObjectPtr<UMaterialInterface>> BakedMaterials;
+
+	/**
+	 * Seconds after the first destruction force until small fragments start to despawn. 0 uses DefaultFragmentLifetime
+	 * from the plugin settings, and the result is capped by MaxFragmentLifetime.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible|Lifecycle", meta = (ClampMin = 0))
+	float FragmentLifetime = 0.f;
+
+	/** Fragments whose largest bounds dimension is at most this despawn. 0 despawns every fragment. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible|Lifecycle", meta = (ClampMin = 0))
+	float FragmentDespawnSizeThreshold = 0.f;
+
+	/** Seconds despawning fragments take to shrink away */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible|Lifecycle", meta = (ClampMin = 0))
+	float FragmentShrinkDuration = 1.f;
+
+	/** Largest bounds dimension of each bone's fragment, filled by the chaos-to-niagara tool. Needed for FragmentDespawnSizeThreshold. */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible|Lifecycle")
+	TArray<float> BoneSizes;
+
+	/** FragmentLifetime resolved against the plugin settings' default and cap. 0 means fragments never despawn. */
+	float GetFragmentLifetime() const;
+
+	/** Appends the soft referenced assets needed to activate a destructible using this data asset. */
+	void GetDestructionAssetPaths(TArray<FSoftObjectPath>& OutAssetPaths) const;
+
+	/**
+	 * Appends the large per destructible assets (StaticMesh and InitialBoneLocationsTexture) that are only kept resident while a
+	 * destructible needs them, see UNiagaraDestructionDriverAssetLoader::RetainStreamedAssets.
+	 */
+	void GetStreamedAssetPaths(TArray<FSoftObjectPath>& OutAssetPaths) const;
+
+	/** Resource size of StaticMesh and InitialBoneLocationsTexture, 0 while they are not loaded */
+	SIZE_T GetStreamedAssetSizeBytes() const;
+
+	/**
+	 * The resolved runtime data shared by all destructibles using this data asset.
+	 * Built on first use, so call it only once the destruction assets are loaded (see GetDestructionAssetPaths).
+	 */
+	const FNiagaraDestructionDriverRuntimeContext& GetRuntimeContext();
+
+	/** Drops the cached runtime context so it gets rebuilt on next use */
+	void InvalidateRuntimeContext();
+
+	/**
+	 * Drops the runtime context's references to the streamed assets (mesh, bone texture, slot materials) so they can be garbage
+	 * collected. The niagara system stays referenced; the context is rebuilt once the streamed assets are loaded again.
+	 */
+	void ReleaseStreamedAssets();
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+private:
+
+	UPROPERTY(Transient) FNiagaraDestructionDriverRuntimeContext RuntimeContext;
 };
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "GameFramework/Actor.h"
+#include "NiagaraDestructionDriverEntitySpawner.generated.h"
+
+class ANiagaraDestructionDriverActor;
+class UNiagaraDestructionDriverDataAsset;
+
+/** One intact destructible placed through ANiagaraDestructionDriverEntitySpawner */
+USTRUCT(BlueprintType)
+struct NIAGARADESTRUCTIONDRIVER_API FNiagaraDestructionDriverEntityPlacement
+{
+	GENERATED_BODY()
+
+	/** Destructible blueprint made by the chaos-to-niagara tool, drawn with its SourceGeometryContainer meshes */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Niagara Destructible")
+	TSubclassOf<ANiagaraDestructionDriverActor> DestructibleClass;
+
+	/** Overrides the data asset of DestructibleClass */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Niagara Destructible")
+	TObjectPtr<UNiagaraDestructionDriverDataAsset> DataAsset;
+
+	/** Relative to the spawner */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Niagara Destructible", meta = (MakeEditWidget))
+	FTransform Transform = FTransform::Identity;
+};
+
+/**
+ * Places many intact destructibles as entities (UNiagaraDestructionDriverEntitySubsystem) instead of one actor each. They become
+ * destructibles when a force hits them and go away with the spawner's level. Per instance property changes other than the data
+ * asset are not kept: promoted destructibles use the class defaults.
+ */
+UCLASS()
+class NIAGARADESTRUCTIONDRIVER_API ANiagaraDestructionDriverEntitySpawner : public AActor
+{
+	GENERATED_BODY()
+
+public:
+
+	ANiagaraDestructionDriverEntitySpawner();
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible")
+	TArray<FNiagaraDestructionDriverEntityPlacement> Destructibles;
+
+#if WITH_EDITOR
+	/** Moves every niagara destructible of this spawner's level that can be drawn as an entity into Destructibles and deletes the actors */
+	UFUNCTION(CallInEditor, Category = "Niagara Destructible")
+	void GatherDestructiblesInLevel();
+#endif
+
+	// <overrides>
+	virtual void OnConstruction(const FTransform& Transform) override;
+	// </overrides>
+
+protected:
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+
+	TArray<FMassEntityHandle> SpawnedEntities;
+};
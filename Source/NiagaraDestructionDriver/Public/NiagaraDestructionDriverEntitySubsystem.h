@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassArchetypeTypes.h"
+#include "MassEntityTypes.h"
+#include "NiagaraDestructionDriverProxySubsystem.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "NiagaraDestructionDriverEntitySubsystem.generated.h"
+
+class ANiagaraDestructionDriverActor;
+class UNiagaraDestructionDriverDataAsset;
+struct FMassEntityManager;
+
+/** An intact destructible without an actor: where it is, what it turns into when hit and which proxy instances draw it. */
+USTRUCT()
+struct NIAGARADESTRUCTIONDRIVER_API FNiagaraDestructionDriverEntityFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	FTransform Transform = FTransform::Identity;
+
+	/** Index into UNiagaraDestructionDriverEntitySubsystem's entity types */
+	int32 TypeIndex = INDEX_NONE;
+
+	/** UNiagaraDestructionDriverProxySubsystem proxy id of each of the type's proxies, empty while promoted */
+	TArray<int32, TInlineAllocator<4>> ProxyInstances;
+
+	/** The destructible standing in for this entity since it was hit */
+	TWeakObjectPtr<ANiagaraDestructionDriverActor> PromotedActor;
+};
+
+/** A destructible class + data asset pair that entities are created for */
+USTRUCT()
+struct FNiagaraDestructionDriverEntityType
+{
+	GENERATED_BODY()
+
+	UPROPERTY() TSubclassOf<ANiagaraDestructionDriverActor> DestructibleClass;
+	UPROPERTY() TObjectPtr<UNiagaraDestructionDriverDataAsset> DataAsset;
+
+	TArray<FNiagaraDestructionDriverProxyMesh> Proxies;
+};
+
+/**
+ * Actorless representation of intact destructibles. Placing tens of thousands of ANiagaraDestructionDriverActor costs an actor,
+ * its components and a BeginPlay each, even though nearly all of them are never hit. Here an intact destructible is a Mass entity
+ * (FNiagaraDestructionDriverEntityFragment) whose SourceGeometryContainer meshes are instances of the per world proxy batches
+ * (UNiagaraDestructionDriverProxySubsystem), with collision so forces and gameplay still hit them.
+ *
+ * UNiagaraDestructionDriverHelper::InitiateDestructionForce promotes every entity it overlaps to a destructible from
+ * UNiagaraDestructionDriverActorPool before applying the force. DemoteDestructible turns a reset one back into an entity.
+ * Entities are usually placed through ANiagaraDestructionDriverEntitySpawner. No Mass processors run: intact entities cost nothing per frame.
+ * Compare with actors using r.NDD.BenchmarkEntities.
+ */
+UCLASS()
+class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverEntitySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * Creates an intact destructible entity drawn with the SourceGeometryContainer meshes of DestructibleClass (a blueprint
+	 * made by the chaos-to-niagara tool). Returns an invalid handle if the class has no such meshes.
+	 * @param DataAsset the data asset of the destructible it turns into, defaults to the class default
+	 */
+	FMassEntityHandle AddEntity(TSubclassOf<ANiagaraDestructionDriverActor> DestructibleClass, UNiagaraDestructionDriverDataAsset* DataAsset, const FTransform& Transform);
+
+	/** Destroys an entity, releasing its promoted destructible (if any) to the actor pool */
+	void RemoveEntity(const FMassEntityHandle Entity);
+
+	/** Entity drawn by this instance of a batch component, e.g. from an overlap or hit result */
+	FMassEntityHandle FindEntity(const UPrimitiveComponent* Component, const int32 InstanceIndex) const;
+
+	/**
+	 * Swaps the entity for a full destructible in its resting state (reused from UNiagaraDestructionDriverActorPool if possible).
+	 * Returns the one already standing in for it if it was promoted before.
+	 */
+	ANiagaraDestructionDriverActor* PromoteEntity(const FMassEntityHandle Entity);
+
+	/**
+	 * Turns a promoted destructible back into an intact entity: the destructible is reset to its resting state and released to
+	 * the actor pool. False if it doesn't stand in for an entity.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Niagara Destructible")
+	bool DemoteDestructible(ANiagaraDestructionDriverActor* Destructible);
+
+	/** Number of entities, promoted or not */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	int32 GetNumEntities() const { return Entities.Num(); }
+
+	/** Number of entities currently standing in as destructibles */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	int32 GetNumPromotedEntities() const { return PromotedEntities.Num(); }
+
+	/** Meshes under SourceGeometryContainer in the construction script of DestructibleClass (and its blueprint parents) */
+	static void GetProxyTemplates(TSubclassOf<ANiagaraDestructionDriverActor> DestructibleClass, TArray<const UStaticMeshComponent*>& OutTemplates, TArray<FTransform>& OutRelativeTransforms);
+
+	// <overrides>
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// </overrides>
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	FMassEntityManager& GetEntityManager() const;
+
+	UNiagaraDestructionDriverProxySubsystem& GetProxySubsystem() const;
+
+	int32 FindOrAddType(TSubclassOf<ANiagaraDestructionDriverActor> DestructibleClass, UNiagaraDestructionDriverDataAsset* DataAsset);
+
+	/** Adds or removes the proxy instances of an entity */
+	void AddProxyInstances(const FMassEntityHandle Entity, FNiagaraDestructionDriverEntityFragment& Fragment);
+	void RemoveProxyInstances(FNiagaraDestructionDriverEntityFragment& Fragment);
+
+	/** A promoted destructible was destroyed by someone else, the entity goes with it */
+	UFUNCTION()
+	void OnPromotedDestructibleDestroyed(AActor* DestroyedActor);
+
+	void UpdateStats() const;
+
+	UPROPERTY() TArray<FNiagaraDestructionDriverEntityType> Types;
+
+	FMassArchetypeHandle Archetype;
+	TSet<FMassEntityHandle> Entities;
+	TMap<TObjectKey<ANiagaraDestructionDriverActor>, FMassEntityHandle> PromotedEntities;
+};
@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "UObject/Object.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Math/Float16Color.h"
 #include "NiagaraDestructionDriverHelper.generated.h"
 
 /**
@@ -16,4 +18,28 @@ class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverHelper : public UObj
 
 	UFUNCTION(BlueprintCallable, meta = (WorldContext = "WorldContextObject"))
 	static void InitiateDestructionForce(const UObject* WorldContextObject, const FVector Location, const float Radius, const float Force);
+
+public:
+
+	/**
+	 * Starts streaming in the mesh and bone texture of every destructible within Radius of Location, without activating them.
+	 * Call it when a force is predicted there (a projectile was fired, an explosive armed) so the hit doesn't wait on the load.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Niagara Destructible", meta = (WorldContext = "WorldContextObject"))
+	static void PrefetchDestructionAssets(const UObject* WorldContextObject, const FVector Location, const float Radius);
+
+	/**
+	 * Creates a render target in the format the niagara destruction simulation writes bone transforms to (RGBA16f by default, no mips).
+	 * Used both for per-actor render targets and for the larger shared atlas pages.
+	 */
+	static UTextureRenderTarget2D* CreateSimulationRenderTarget(UObject* Outer, const int32 Size, const ETextureRenderTargetFormat Format = RTF_RGBA16f);
+
+	/** Uploads Pixels (Rect.Width() wide, row by row) into Rect of an RGBA16f render target on the render thread. */
+	static void WriteRenderTargetRegion(UTextureRenderTarget2D* RenderTarget, const FIntRect& Rect, TArray<FFloat16Color> Pixels);
+
+	/**
+	 * False on dedicated servers, with -nullrhi (or any other process that can't render) and when r.NDD.ForceHeadless is set.
+	 * Destructibles then only track their logical destruction state and never create textures, materials or niagara setup.
+	 */
+	static bool ShouldCreateRenderResources(const UObject* WorldContextObject);
 };
@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraDestructionDriverActor.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NiagaraDestructionDriverInstancingSubsystem.generated.h"
+
+class UInstancedStaticMeshComponent;
+class UMaterialInstanceDynamic;
+class UNiagaraComponent;
+class UTextureRenderTarget2D;
+struct FNiagaraDestructionDriverRuntimeContext;
+
+/**
+ * Draws and simulates every instanced destructible (UNiagaraDestructionDriverDataAsset::bInstanced) of one data asset.
+ * Slot N is instance N of MeshComponent (the instance ID the material sees) and tile N of the shared render targets.
+ */
+USTRUCT()
+struct FNiagaraDestructionDriverInstanceGroup
+{
+	GENERATED_BODY()
+
+	/** One instance per slot, zero scaled while its slot is free or its destructible is resting */
+	UPROPERTY() TObjectPtr<UInstancedStaticMeshComponent> MeshComponent;
+
+	/** Simulates the bones of every slot, paused while none of them is simulating */
+	UPROPERTY() TObjectPtr<UNiagaraComponent> NiagaraComponent;
+
+	/** Pages of TilesPerRow x TilesPerRow tiles of TileSize texels */
+	UPROPERTY() TObjectPtr<UTextureRenderTarget2D> PositionsTexture;
+	UPROPERTY() TObjectPtr<UTextureRenderTarget2D> RotationsTexture;
+
+	/** One per material slot of the mesh, shared by every instance */
+	UPROPERTY() TArray<TObjectPtr<UMaterialInstanceDynamic>> Materials;
+
+	int32 TileSize = 0;
+	int32 TilesPerRow = 0;
+
+	/** Destructible holding each slot, unset for free slots */
+	TArray<TWeakObjectPtr<ANiagaraDestructionDriverActor>> Owners;
+	TArray<int32> FreeSlots;
+
+	/** Per slot, as passed to the niagara system. Locations are where the slot's particles are centered (the pivot offset applied). */
+	TArray<FVector> InstanceLocations;
+	TArray<FQuat> InstanceRotations;
+	TArray<FVector> InstanceScales;
+	TArray<FVector4> InstanceTileOffsetScales;
+	TArray<bool> InstanceSimulating;
+	TArray<int32> InstanceResetCounts;
+
+	/** Per slot, drawn with its destructible's transform or zero scaled */
+	TArray<bool> InstanceVisible;
+	TArray<float> InstanceBoundsScales;
+
+	/** Forces still pushing, each for the slot in ForceInstances */
+	TArray<FNiagaraDestructionDriverForce> Forces;
+	TArray<int32> ForceInstances;
+
+	/** The niagara user arrays need to be sent again */
+	bool bParametersDirty = false;
+
+	/** MeshComponent's bounds scale needs to be fitted to InstanceBoundsScales again */
+	bool bBoundsDirty = false;
+};
+
+/**
+ * Instanced mode for data assets placed many times (UNiagaraDestructionDriverDataAsset::bInstanced): instead of a mesh component,
+ * niagara component, render target pair and dynamic materials per destructible, each data asset gets one group of one instanced
+ * static mesh component, one niagara system and one pair of render targets holding a tile per instance. Draw calls and simulation
+ * dispatches are per data asset instead of per destroyed destructible. The actors keep their logic (forces, settling, restore,
+ * baking), only what they draw and simulate with comes from their slot.
+ *
+ * Groups are created with the first activated destructible and go away with the last. Niagara and material inputs are batched:
+ * forces and transform changes of a frame are sent once per group in Tick.
+ */
+UCLASS()
+class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverInstancingSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Gives the destructible a slot in its data asset's group (created on demand). INDEX_NONE if the group is full. */
+	int32 AcquireInstance(ANiagaraDestructionDriverActor* Destructible, const FNiagaraDestructionDriverRuntimeContext& Context);
+
+	/** Hides and frees the destructible's slot, the group is released with its last slot */
+	void ReleaseInstance(const ANiagaraDestructionDriverActor* Destructible);
+
+	/** Draws the destructible's instance where the destructible is */
+	void ShowInstance(const ANiagaraDestructionDriverActor* Destructible);
+
+	/** Hides the instance, drops its forces and has the niagara system respawn its bones at their initial locations */
+	void ResetInstance(const ANiagaraDestructionDriverActor* Destructible);
+
+	/** Moves the instance (and where its bones are simulated) to the destructible's current transform */
+	void UpdateInstanceTransform(const ANiagaraDestructionDriverActor* Destructible);
+
+	/** ObjectBoundsScale of the instance, the group's bounds fit the largest */
+	void SetInstanceBoundsScale(const ANiagaraDestructionDriverActor* Destructible, const float BoundsScale);
+
+	/** Adds a force pushing the destructible's bones and simulates them until SettleInstance */
+	void ApplyForce(const ANiagaraDestructionDriverActor* Destructible, const FNiagaraDestructionDriverForce& Force);
+
+	/** Stops simulating the destructible's bones, its tile keeps the last pose */
+	void SettleInstance(const ANiagaraDestructionDriverActor* Destructible);
+
+	UTextureRenderTarget2D* GetPositionsTexture(const ANiagaraDestructionDriverActor* Destructible) const;
+	UTextureRenderTarget2D* GetRotationsTexture(const ANiagaraDestructionDriverActor* Destructible) const;
+
+	/** UV offset (XY) and scale (ZW) of the destructible's tile */
+	FVector4 GetTileOffsetScale(const ANiagaraDestructionDriverActor* Destructible) const;
+
+	/** Number of data assets drawn instanced */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	int32 GetNumGroups() const { return Groups.Num(); }
+
+	/** Number of destructibles holding a slot */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	int32 GetNumInstances() const;
+
+	/** Logs slots used, simulating instances, forces and page size of every group */
+	void DumpInstancingStats() const;
+
+	// <overrides>
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return Groups.Num() > 0; }
+	virtual void Deinitialize() override;
+	// </overrides>
+
+protected:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	FNiagaraDestructionDriverInstanceGroup* AddGroup(UNiagaraDestructionDriverDataAsset* DataAsset, const FNiagaraDestructionDriverRuntimeContext& Context);
+	void RemoveGroup(UNiagaraDestructionDriverDataAsset* DataAsset);
+
+	/** The group and slot held by the destructible, null if it holds none */
+	FNiagaraDestructionDriverInstanceGroup* FindGroup(const ANiagaraDestructionDriverActor* Destructible, int32& OutSlot);
+	const FNiagaraDestructionDriverInstanceGroup* FindGroup(const ANiagaraDestructionDriverActor* Destructible, int32& OutSlot) const;
+
+	/** Takes the niagara transform of the slot from its destructible */
+	void SetSlotTransform(FNiagaraDestructionDriverInstanceGroup& Group, const int32 Slot, const ANiagaraDestructionDriverActor* Destructible) const;
+
+	/** Writes the slot's transform (zero scaled while hidden) and custom data to the instanced mesh */
+	void UpdateInstance(FNiagaraDestructionDriverInstanceGroup& Group, const int32 Slot) const;
+
+	/** Sends the per slot and force arrays to the niagara system */
+	void PushParameters(FNiagaraDestructionDriverInstanceGroup& Group) const;
+
+	void RemoveForces(FNiagaraDestructionDriverInstanceGroup& Group, const int32 Slot) const;
+
+	void UpdateStats() const;
+
+	UPROPERTY() TMap<TObjectPtr<UNiagaraDestructionDriverDataAsset>, FNiagaraDestructionDriverInstanceGroup> Groups;
+
+	/** Owns the group components */
+	UPROPERTY() TObjectPtr<AActor> GroupOwner;
+};
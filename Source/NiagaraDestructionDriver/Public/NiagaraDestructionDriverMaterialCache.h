@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NiagaraDestructionDriverMaterialCache.generated.h"
+
+class UMaterialInstanceDynamic;
+class UMaterialInterface;
+class UTexture;
+class UTextureRenderTarget2D;
+struct FNiagaraDestructionDriverRuntimeContext;
+
+/** Everything a shared destructible material instance binds. Actors with equal keys render with the same material. */
+USTRUCT()
+struct FNiagaraDestructionDriverMaterialKey
+{
+	GENERATED_BODY()
+
+	UPROPERTY() TObjectPtr<UMaterialInterface> SlotMaterial;
+	UPROPERTY() TObjectPtr<UTextureRenderTarget2D> PositionsTexture;
+	UPROPERTY() TObjectPtr<UTextureRenderTarget2D> RotationsTexture;
+	UPROPERTY() TObjectPtr<UTexture> InitialBoneLocationsTexture;
+	UPROPERTY() TObjectPtr<UTexture> BoneScaleMask;
+
+	bool operator==(const FNiagaraDestructionDriverMaterialKey& Other) const
+	{
+		return SlotMaterial == Other.SlotMaterial
+			&& PositionsTexture == Other.PositionsTexture
+			&& RotationsTexture == Other.RotationsTexture
+			&& InitialBoneLocationsTexture == Other.InitialBoneLocationsTexture
+			&& BoneScaleMask == Other.BoneScaleMask;
+	}
+
+	friend uint32 GetTypeHash(const FNiagaraDestructionDriverMaterialKey& Key)
+	{
+		uint32 Hash = GetTypeHash(Key.SlotMaterial);
+		Hash = HashCombine(Hash, GetTypeHash(Key.PositionsTexture));
+		Hash = HashCombine(Hash, GetTypeHash(Key.RotationsTexture));
+		Hash = HashCombine(Hash, GetTypeHash(Key.InitialBoneLocationsTexture));
+		return HashCombine(Hash, GetTypeHash(Key.BoneScaleMask));
+	}
+};
+
+USTRUCT()
+struct FNiagaraDestructionDriverSharedMaterial
+{
+	GENERATED_BODY()
+
+	UPROPERTY() TObjectPtr<UMaterialInstanceDynamic> Material;
+
+	/** Material slots currently using Material */
+	int32 NumUsers = 0;
+};
+
+/**
+ * Hands out material instances shared by every destructible that binds the same textures, see
+ * UNiagaraDestructionDriverSettings::bUseCustomPrimitiveData. Per actor values go through custom primitive data
+ * (FNiagaraDestructionDriverPrimitiveData) instead of material parameters, so these instances are never modified
+ * after creation and the renderer can batch the actors using them.
+ */
+UCLASS()
+class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverMaterialCache : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Returns the shared instance of SlotMaterial for these textures, creating it on first use. Pair with ReleaseMaterial. */
+	UMaterialInstanceDynamic* AcquireMaterial(UMaterialInterface* SlotMaterial, const FNiagaraDestructionDriverRuntimeContext& Context,
+		UTextureRenderTarget2D* PositionsTexture, UTextureRenderTarget2D* RotationsTexture, UTexture* BoneScaleMask);
+
+	/** Drops one user of a material returned by AcquireMaterial, the instance is freed with its last user. */
+	void ReleaseMaterial(UMaterialInstanceDynamic* Material);
+
+	/** Number of shared material instances alive in this world */
+	int32 GetNumMaterials() const { return Materials.Num(); }
+
+	// <overrides>
+	virtual void Deinitialize() override;
+	// </overrides>
+
+protected:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	UPROPERTY() TMap<FNiagaraDestructionDriverMaterialKey, FNiagaraDestructionDriverSharedMaterial> Materials;
+};
@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/Float16Color.h"
+
+class UNiagaraDestructionDriverDataAsset;
+class UStaticMesh;
+
+/**
+ * Bakes the simulated pose of a settled destructible into a plain static mesh, so the rubble no longer needs
+ * the render targets or the WPO material.
+ *
+ * Follows the same conventions as the VAT material:
+ * - each vertex of the data asset's StaticMesh has its bone index in UV channel CustomUVChannelIndex, stored as BoneIndex / NumBones
+ * - bone i lives in pixel (i % RenderTargetTextureSize, i / RenderTargetTextureSize) of the simulation render targets
+ * - positions are normalized to [-1,1] by the mesh half extents around the mesh center (-PivotOffset), rotations are XYZW quaternions
+ */
+struct NIAGARADESTRUCTIONDRIVER_API FNiagaraDestructionDriverMeshBaker
+{
+	/** Does the data asset carry everything baking needs (loaded CPU accessible mesh, initial bone locations, baked materials) */
+	static bool CanBake(const UNiagaraDestructionDriverDataAsset* DataAsset);
+
+	/**
+	 * Builds a transient static mesh with every fragment moved to its simulated pose, using BakedMaterials for its slots.
+	 * BonePositions and BoneRotations are the read back render target regions, RenderTargetTextureSize pixels wide.
+	 * Triangles of bones set in RemovedBones are left out.
+	 */
+	static UStaticMesh* BakeStaticMesh(UObject* Outer, const UNiagaraDestructionDriverDataAsset* DataAsset, const TArray<FFloat16Color>& BonePositions, const TArray<FFloat16Color>& BoneRotations, const TBitArray<>& RemovedBones = TBitArray<>());
+};
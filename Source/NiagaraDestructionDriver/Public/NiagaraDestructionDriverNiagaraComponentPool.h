@@ -0,0 +1,123 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NiagaraDestructionDriverNiagaraComponentPool.generated.h"
+
+class ANiagaraDestructionDriverActor;
+class UNiagaraComponent;
+class UNiagaraSystem;
+
+/**
+ * Counters for the niagara component pool of a world. Evictions mean MaxPooledNiagaraComponents is holding back destruction:
+ * simulating destructibles had their component taken back early to make room for newly hit ones.
+ */
+USTRUCT(BlueprintType)
+struct NIAGARADESTRUCTIONDRIVER_API FNiagaraDestructionDriverNiagaraComponentPoolStats
+{
+	GENERATED_BODY()
+
+	/** Acquires served by a free component already set up for the system. */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 Hits = 0;
+
+	/** Acquires that had to create a component (or switch a free one to another system). */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 Misses = 0;
+
+	/** Components taken back from simulating destructibles because every component was in use. */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 Evictions = 0;
+
+	/** Components currently lent to destructibles. */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 NumInUse = 0;
+
+	/** Components waiting in the pool. */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 NumFree = 0;
+
+	/** Highest number of components resident at once (in use + free). */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 PeakResidency = 0;
+};
+
+/** Free components of one niagara system, the system asset already set. */
+USTRUCT()
+struct FNiagaraDestructionDriverNiagaraComponentBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY() TArray<TObjectPtr<UNiagaraComponent>> FreeComponents;
+};
+
+/** A component lent to a destructible */
+USTRUCT()
+struct FNiagaraDestructionDriverBorrowedNiagaraComponent
+{
+	GENERATED_BODY()
+
+	UPROPERTY() TObjectPtr<UNiagaraComponent> Component;
+	TWeakObjectPtr<ANiagaraDestructionDriverActor> Destructible;
+};
+
+/**
+ * With UNiagaraDestructionDriverSettings::bPoolNiagaraComponents, destructibles are constructed without a niagara component.
+ * On their first hit they borrow one from here, set up for their data asset's ParticleSystemDriver, and give it back once
+ * they settle or are reset. At most MaxPooledNiagaraComponents components (in use + free) exist per world. When all of them
+ * are in use, the destructible that has been simulating the longest gives its component back early. It isn't settled: its
+ * fragments stop where they are and it borrows a component again on its next force.
+ */
+UCLASS()
+class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverNiagaraComponentPool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * Lends a deactivated component with System set to the destructible, reusing a free one of that system if possible.
+	 * The caller attaches, configures and activates it. Null only if System is.
+	 */
+	UNiagaraComponent* AcquireComponent(ANiagaraDestructionDriverActor* Destructible, UNiagaraSystem* System);
+
+	/** Deactivates a component acquired from this pool and keeps it for the next destructible using its system. */
+	void ReleaseComponent(UNiagaraComponent* Component);
+
+	UFUNCTION(BlueprintCallable, Category = "Niagara Destructible")
+	FNiagaraDestructionDriverNiagaraComponentPoolStats GetPoolStats() const { return Stats; }
+
+	/** Writes the pool stats to the log. */
+	void DumpPoolStats() const;
+
+	// <overrides>
+	virtual void Deinitialize() override;
+	// </overrides>
+
+protected:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	/** A free component of System, creating one (or switching one of another system) while under the limit. Null if at the limit with none free. */
+	UNiagaraComponent* TakeFreeComponent(UNiagaraSystem* System);
+
+	/** Takes the component of the oldest borrower back, without settling it */
+	void EvictOldestBorrower();
+
+	void UpdateStats() const;
+
+	UPROPERTY() TMap<TObjectPtr<UNiagaraSystem>, FNiagaraDestructionDriverNiagaraComponentBucket> Buckets;
+
+	/** In the order they were lent, oldest first */
+	UPROPERTY() TArray<FNiagaraDestructionDriverBorrowedNiagaraComponent> Borrowed;
+
+	/** Owns the components while they are free */
+	UPROPERTY() TObjectPtr<AActor> ComponentOwner;
+
+	FNiagaraDestructionDriverNiagaraComponentPoolStats Stats;
+};
@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Engine/EngineTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "NiagaraDestructionDriverPrewarmSubsystem.generated.h"
+
+class UNiagaraComponent;
+class UNiagaraDestructionDriverAssetLoader;
+class UNiagaraDestructionDriverDataAsset;
+class UTextureRenderTarget2D;
+
+/**
+ * Prewarm coverage of a world. Cold activations are destructibles whose data asset was never prewarmed,
+ * activations while compiling found their material PSOs still being precompiled.
+ */
+USTRUCT(BlueprintType)
+struct NIAGARADESTRUCTIONDRIVER_API FNiagaraDestructionDriverPrewarmStats
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 NumDataAssetsPrewarmed = 0;
+
+	/** Material PSO precache requests issued for the destructible mesh materials */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 NumMaterialPSORequests = 0;
+
+	/** Niagara driver systems that ran a warmup simulation */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 NumNiagaraSystemsWarmed = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 NumWarmActivations = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 NumActivationsWhileCompiling = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 NumColdActivations = 0;
+};
+
+/** A niagara driver running off screen so its GPU simulation shaders get bound before the first real hit. */
+USTRUCT()
+struct FNiagaraDestructionDriverWarmingSystem
+{
+	GENERATED_BODY()
+
+	UPROPERTY() TObjectPtr<UNiagaraComponent> NiagaraComponent;
+	UPROPERTY() TObjectPtr<UTextureRenderTarget2D> PositionsTexture;
+	UPROPERTY() TObjectPtr<UTextureRenderTarget2D> RotationsTexture;
+};
+
+/**
+ * Warms the destructible materials and niagara driver systems of the data assets placed in a level while it loads, see
+ * UNiagaraDestructionDriverSettings::bPrewarmDestructibles. Registers the destructible mesh material / local vertex factory
+ * combinations with the PSO precache system and runs each niagara driver for a moment on pooled render targets.
+ */
+UCLASS()
+class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverPrewarmSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Loads the destruction assets of these data assets (if needed) and prewarms them. Data assets are only prewarmed once per world. */
+	UFUNCTION(BlueprintCallable, Category = "Niagara Destructible")
+	void PrewarmDataAssets(const TArray<UNiagaraDestructionDriverDataAsset*>& DataAssets);
+
+	/** Records whether a destructible activating with this data asset found it prewarmed */
+	void NoteActivation(const UNiagaraDestructionDriverDataAsset* DataAsset);
+
+	UFUNCTION(BlueprintCallable, Category = "Niagara Destructible")
+	FNiagaraDestructionDriverPrewarmStats GetPrewarmStats() const { return Stats; }
+
+	/** Writes the prewarm stats to the log. */
+	void DumpPrewarmStats() const;
+
+	// <overrides>
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	// </overrides>
+
+protected:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	/** Prewarms the data assets placed in a streamed in level */
+	void OnLevelAddedToWorld(ULevel* Level, UWorld* World);
+	void PrewarmLevel(const ULevel* Level);
+
+	/** Second half of PrewarmDataAssets once the destruction assets are in memory */
+	void PrewarmLoadedDataAssets(TArray<TWeakObjectPtr<UNiagaraDestructionDriverDataAsset>> DataAssets);
+	void PrecacheMaterialPSOs(UNiagaraDestructionDriverDataAsset* DataAsset);
+	void WarmNiagaraSystem(UNiagaraDestructionDriverDataAsset* DataAsset);
+	/** Destroys the warmup systems and lets go of the streamed assets retained for prewarming */
+	void FinishWarmingSystems();
+
+	UNiagaraDestructionDriverAssetLoader* GetAssetLoader() const;
+
+	/** Data assets prewarmed (or being prewarmed) in this world */
+	TSet<TObjectKey<UNiagaraDestructionDriverDataAsset>> PrewarmedDataAssets;
+
+	/** Outstanding PSO precache tasks per data asset */
+	TMap<TObjectKey<UNiagaraDestructionDriverDataAsset>, FGraphEventArray> PrecacheEvents;
+
+	UPROPERTY() TArray<FNiagaraDestructionDriverWarmingSystem> WarmingSystems;
+
+	/** Prewarmed data assets whose streamed assets (mesh, bone texture) are kept resident until their batch finished warming */
+	UPROPERTY() TArray<TObjectPtr<UNiagaraDestructionDriverDataAsset>> RetainedDataAssets;
+
+	/** Data assets whose streamed assets are retained but still loading, they move to RetainedDataAssets once prewarmed */
+	UPROPERTY() TArray<TObjectPtr<UNiagaraDestructionDriverDataAsset>> LoadingDataAssets;
+
+	FTimerHandle WarmingTimerHandle;
+	FDelegateHandle LevelAddedHandle;
+
+	FNiagaraDestructionDriverPrewarmStats Stats;
+};
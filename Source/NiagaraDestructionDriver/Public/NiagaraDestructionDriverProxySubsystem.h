@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NiagaraDestructionDriverProxySubsystem.generated.h"
+
+class ANiagaraDestructionDriverActor;
+class UInstancedStaticMeshComponent;
+class UStaticMeshComponent;
+
+/** One SourceGeometryContainer mesh of a destructible, drawn by a UNiagaraDestructionDriverProxySubsystem batch */
+USTRUCT()
+struct FNiagaraDestructionDriverProxyMesh
+{
+	GENERATED_BODY()
+
+	/** Relative to the actor */
+	FTransform RelativeTransform = FTransform::Identity;
+
+	int32 BatchIndex = INDEX_NONE;
+};
+
+/** What an intact proxy instance stands in for: a placed destructible or an entity (UNiagaraDestructionDriverEntitySubsystem) */
+struct FNiagaraDestructionDriverProxyOwner
+{
+	TWeakObjectPtr<ANiagaraDestructionDriverActor> Destructible;
+	FMassEntityHandle Entity;
+};
+
+/** One instanced static mesh component drawing every intact proxy with the same mesh, materials and collision */
+USTRUCT()
+struct FNiagaraDestructionDriverProxyBatch
+{
+	GENERATED_BODY()
+
+	UPROPERTY() TObjectPtr<UInstancedStaticMeshComponent> Component;
+
+	/** Proxy id of each instance, kept in sync with the remove-at-swap of the component */
+	TArray<int32> InstanceProxies;
+};
+
+/**
+ * Per world instanced static mesh manager for the intact proxies of destructibles. The chaos-to-niagara tool gives every
+ * destructible one static mesh component per geometry source under SourceGeometryContainer, so 1000 props of 12 source meshes
+ * would be 12000 primitives. Instead, destructibles (bBatchSourceGeometry in the plugin settings) and entities add their proxies
+ * as instances of one batch per mesh, materials, collision profile and shadow casting, and remove only their own instances
+ * on hot swap. Intact props then cost draw calls and primitives per unique mesh, not per actor.
+ *
+ * Batches collide like the meshes they replace. UNiagaraDestructionDriverHelper::InitiateDestructionForce maps the instances it
+ * overlaps back to their owners with FindProxyOwner.
+ */
+UCLASS()
+class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverProxySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Batch drawing meshes set up like Template (mesh, override materials, collision profile, shadow casting), created on demand */
+	int32 FindOrAddBatch(const UStaticMeshComponent* Template);
+
+	/** Adds a world space instance to a batch. Returns the proxy id to remove it with. */
+	int32 AddProxy(const int32 BatchIndex, const FTransform& Transform, const FNiagaraDestructionDriverProxyOwner& Owner);
+
+	void RemoveProxy(const int32 ProxyId);
+
+	/** Owner of the proxy drawn by this instance of a batch component, e.g. from an overlap or hit result. Null for other components. */
+	const FNiagaraDestructionDriverProxyOwner* FindProxyOwner(const UPrimitiveComponent* Component, const int32 InstanceIndex) const;
+
+	/** Number of intact proxies drawn by the batches */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	int32 GetNumProxies() const { return Proxies.Num(); }
+
+	/** Number of instanced static mesh components drawing the intact proxies */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	int32 GetNumBatches() const { return Batches.Num(); }
+
+	// <overrides>
+	virtual void Deinitialize() override;
+	// </overrides>
+
+protected:
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	struct FProxy
+	{
+		int32 BatchIndex = INDEX_NONE;
+		int32 InstanceIndex = INDEX_NONE;
+		FNiagaraDestructionDriverProxyOwner Owner;
+	};
+
+	void UpdateStats() const;
+
+	/** Proxy ids are indices, stable while other proxies come and go */
+	TSparseArray<FProxy> Proxies;
+
+	UPROPERTY() TArray<FNiagaraDestructionDriverProxyBatch> Batches;
+
+	/** Owns the batch components */
+	UPROPERTY() TObjectPtr<AActor> BatchOwner;
+};
@@ -0,0 +1,88 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/TextureRenderTarget2D.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NiagaraDestructionDriverRenderTargetPool.generated.h"
+
+/**
+ * Counters for the render target pool of a world. Hits vs misses during spawn waves tell you
+ * whether destructibles are still allocating render targets at runtime.
+ */
+USTRUCT(BlueprintType)
+struct NIAGARADESTRUCTIONDRIVER_API FNiagaraDestructionDriverRenderTargetPoolStats
+{
+	GENERATED_BODY()
+
+	/** Acquires served by a recycled render target. */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 Hits = 0;
+
+	/** Acquires that had to allocate a new render target. */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 Misses = 0;
+
+	/** Render targets currently handed out. */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 NumInUse = 0;
+
+	/** Render targets currently waiting in the pool. */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 NumFree = 0;
+
+	/** Highest number of render targets resident at once (in use + free). */
+	UPROPERTY(BlueprintReadOnly, Category = "Niagara Destructible")
+	int32 PeakResidency = 0;
+};
+
+/** Free render targets of one (size, format) combination. */
+USTRUCT()
+struct FNiagaraDestructionDriverRenderTargetBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY() TArray<TObjectPtr<UTextureRenderTarget2D>> FreeRenderTargets;
+};
+
+/**
+ * Recycles the simulation render targets of destructibles that are spawned and destroyed during gameplay.
+ * Render targets are bucketed by (size, format) and cleared when handed out instead of being reallocated.
+ */
+UCLASS()
+class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverRenderTargetPool : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Returns a cleared render target of the given size and format, allocating one if the bucket is empty. */
+	UTextureRenderTarget2D* AcquireRenderTarget(const int32 Size, const ETextureRenderTargetFormat Format = RTF_RGBA16f);
+
+	/** Hands a render target acquired from this pool back for reuse. */
+	void ReleaseRenderTarget(UTextureRenderTarget2D* RenderTarget);
+
+	UFUNCTION(BlueprintCallable, Category = "Niagara Destructible")
+	FNiagaraDestructionDriverRenderTargetPoolStats GetPoolStats() const { return Stats; }
+
+	/** Writes the pool stats to the log. */
+	void DumpPoolStats() const;
+
+	// <overrides>
+	virtual void Deinitialize() override;
+	// </overrides>
+
+protected:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	static int64 MakeBucketKey(const int32 Size, const ETextureRenderTargetFormat Format) { return (static_cast<int64>(Size) << 8) | static_cast<uint8>(Format); }
+
+	UPROPERTY() TMap<int64, FNiagaraDestructionDriverRenderTargetBucket> Buckets;
+
+	FNiagaraDestructionDriverRenderTargetPoolStats Stats;
+};
@@ -0,0 +1,123 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraDestructionDriverRuntimeContext.generated.h"
+
+class UMaterialInterface;
+class UNiagaraDestructionDriverDataAsset;
+class UNiagaraSystem;
+class UStaticMesh;
+class UTexture2D;
+
+/**
+ * Names of the material and niagara parameters driven by destructibles.
+ * Constructed once so actors don't rebuild (and hash) the same FNames on every activation and force.
+ */
+struct NIAGARADESTRUCTIONDRIVER_API FNiagaraDestructionDriverParameterNames
+{
+	static const FNiagaraDestructionDriverParameterNames& Get();
+
+	// <material_parameters>
+	FName RT_Size = FName("RT_Size");
+	FName RT_Position = FName("RT_Position");
+	FName RT_Rotation = FName("RT_Rotation");
+	FName RT_TileOffsetScale = FName("RT_TileOffsetScale");
+	FName InitialBoneLocations = FName("InitialBoneLocations");
+	FName ActorRotationQuat = FName("ActorRotationQuat");
+	FName MeshHalfExtents = FName("MeshHalfExtents");
+	FName ObjectBoundsScale = FName("ObjectBoundsScale");
+	FName BoneScaleMask = FName("BoneScaleMask");
+	// </material_parameters>
+
+	// <niagara_parameters>
+	FName DestructibleMesh = FName("DestructibleMesh");
+	FName InitialBonePositionsTexture = FName("InitialBonePositionsTexture");
+	FName SimulatedParticlePositionsOut = FName("SimulatedParticlePositionsOut");
+	FName SimulatedParticleRotationsOut = FName("SimulatedParticleRotationsOut");
+	FName RenderTargetTileOffsetScale = FName("RenderTargetTileOffsetScale");
+	FName DestructibleMeshLocalHalfExtents = FName("DestructibleMeshLocalHalfExtents");
+	FName ForceCenter = FName("ForceCenter");
+	FName ForceRadius = FName("ForceRadius");
+	FName ForceStartTime = FName("ForceStartTime");
+	FName ForceDuration = FName("ForceDuration");
+	// instanced destructibles (UNiagaraDestructionDriverInstancingSubsystem), arrays with one entry per instance or force
+	FName InstanceCount = FName("InstanceCount");
+	FName InstanceLocations = FName("InstanceLocations");
+	FName InstanceRotations = FName("InstanceRotations");
+	FName InstanceScales = FName("InstanceScales");
+	FName InstanceTileOffsetScales = FName("InstanceTileOffsetScales");
+	FName InstanceSimulating = FName("InstanceSimulating");
+	FName InstanceResetCounts = FName("InstanceResetCounts");
+	FName ForceCenters = FName("ForceCenters");
+	FName ForceRadii = FName("ForceRadii");
+	FName ForceStartTimes = FName("ForceStartTimes");
+	FName ForceDurations = FName("ForceDurations");
+	FName ForceInstances = FName("ForceInstances");
+	// shared simulation (UNiagaraDestructionDriverSharedSimulationSubsystem), arrays with one entry per bone, range or force;
+	// ForceCenters, ForceRadii, ForceStartTimes and ForceDurations are shared with the instanced ones
+	FName SharedBoneCount = FName("SharedBoneCount");
+	FName BoneInitialLocations = FName("BoneInitialLocations");
+	FName BoneRanges = FName("BoneRanges");
+	FName RangeBoneStarts = FName("RangeBoneStarts");
+	FName RangeBoneCounts = FName("RangeBoneCounts");
+	FName RangeLocations = FName("RangeLocations");
+	FName RangeRotations = FName("RangeRotations");
+	FName RangeScales = FName("RangeScales");
+	FName RangeHalfExtents = FName("RangeHalfExtents");
+	FName RangeTileOffsetScales = FName("RangeTileOffsetScales");
+	FName RangeTileSizes = FName("RangeTileSizes");
+	FName RangeSimulating = FName("RangeSimulating");
+	FName RangeResetCounts = FName("RangeResetCounts");
+	FName ForceRanges = FName("ForceRanges");
+	// </niagara_parameters>
+};
+
+/**
+ * Custom primitive data layout of the destructible mesh component, see UNiagaraDestructionDriverSettings::bUseCustomPrimitiveData.
+ * The material parameters of the same name need "Use Custom Primitive Data" enabled with these start indices.
+ * Instanced destructibles (UNiagaraDestructionDriverDataAsset::bInstanced) pass the same layout as per instance custom data.
+ */
+struct FNiagaraDestructionDriverPrimitiveData
+{
+	static constexpr int32 RT_TileOffsetScale = 0; // float4
+	static constexpr int32 ActorRotationQuat = 4; // float4
+	static constexpr int32 ObjectBoundsScale = 8; // float
+	static constexpr int32 Num = 9;
+};
+
+/**
+ * Immutable runtime data derived from a UNiagaraDestructionDriverDataAsset.
+ * Built once per data asset (after its soft references are loaded) and shared by every actor using it,
+ * see UNiagaraDestructionDriverDataAsset::GetRuntimeContext.
+ */
+USTRUCT()
+struct NIAGARADESTRUCTIONDRIVER_API FNiagaraDestructionDriverRuntimeContext
+{
+	GENERATED_BODY()
+
+	/** Resolves and caches everything an actor needs from the data asset. Soft references must already be loaded. */
+	static FNiagaraDestructionDriverRuntimeContext Build(const UNiagaraDestructionDriverDataAsset* DataAsset);
+
+	bool IsValid() const { return bIsValid; }
+
+	/** The resolved niagara driver system (null if it's not set or failed to load) */
+	UPROPERTY() TObjectPtr<UNiagaraSystem> ParticleSystem;
+
+	UPROPERTY() TObjectPtr<UStaticMesh> StaticMesh;
+
+	UPROPERTY() TObjectPtr<UTexture2D> InitialBoneLocationsTexture;
+
+	/** Parent material of each material slot of StaticMesh */
+	UPROPERTY() TArray<TObjectPtr<UMaterialInterface>> SlotMaterials;
+
+	/** Half extents of the local bounding box of StaticMesh */
+	UPROPERTY() FVector MeshHalfExtents = FVector::ZeroVector;
+
+	UPROPERTY() FVector PivotOffset = FVector::ZeroVector;
+
+	UPROPERTY() int32 RenderTargetTextureSize = 0;
+
+	UPROPERTY() bool bIsValid = false;
+};
@@ -6,6 +6,40 @@
 #include "NiagaraSystem.h"
 #include "NiagaraDestructionDriverSettings.generated.h"
 
+/**
+ * Where destroyed destructibles switch simulation tiers (ENiagaraDestructionDriverSignificanceTier). Screen size is the
+ * destructible's bounds radius over its distance to the closest view, 0 while it isn't rendered.
+ */
+USTRUCT(BlueprintType)
+struct NIAGARADESTRUCTIONDRIVER_API FNiagaraDestructionDriverSignificanceThresholds
+{
+	GENERATED_BODY()
+
+	/** Screen size from which destructibles simulate every frame */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible", meta=(ClampMin=0))
+	float FullRateScreenSize = 0.05f;
+
+	/** Screen size below which destructibles are frozen, between the two they simulate at ReducedUpdateRate */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible", meta=(ClampMin=0))
+	float FrozenScreenSize = 0.01f;
+
+	/** Frozen beyond this distance from every view whatever their size, 0 means no limit */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible", meta=(ClampMin=0))
+	float MaxSimulationDistance = 0.f;
+
+	/** Simulation steps per second of the reduced tier */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible", meta=(ClampMin=1))
+	float ReducedUpdateRate = 15.f;
+
+	/** Seconds after a force during which the destructible simulates every frame wherever it is, that's where the debris ends up */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible", meta=(ClampMin=0))
+	float FullRateForceTime = 0.5f;
+
+	/** Frozen destructibles whose last force is this many seconds old are settled (and baked with bBakeSettledDestructibles). 0 never settles them early. */
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = "Niagara Destructible", meta=(ClampMin=0))
+	float BakeFrozenAfterForceTime = 10.f;
+};
+
 /*
  * Project settings for Niagara Chaos Destruction Driver Plugin
  */
@@ -29,4 +63,250 @@ public:
 	/** The default particle system for niagara driven destructibles. */
 	UPROPERTY(Config, EditDefaultsOnly, Category=Config, meta=(Categories="Niagara Destructible"))
 	TSoftObjectPtr<UNiagaraSystem> DefaultNiagaraParticleSystem;
+
+	/**
+	 * Packs the positions/rotations render targets of all destructibles in a world into shared atlas pages
+	 * instead of allocating a render target pair per actor. Each actor gets a tile and passes its
+	 * offset/scale to the materials (RT_TileOffsetScale) and the niagara system (RenderTargetTileOffsetScale).
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Render Targets", meta=(Categories="Niagara Destructible"))
+	bool bUseRenderTargetAtlas = false;
+
+	/** Width and height of each atlas page. Rounded up to a power of two. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Render Targets", meta=(Categories="Niagara Destructible", EditCondition="bUseRenderTargetAtlas", ClampMin=16, ClampMax=8192))
+	int32 AtlasPageSize = 1024;
+
+	/** Maximum number of atlas pages per world. Actors that don't fit fall back to their own render targets. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Render Targets", meta=(Categories="Niagara Destructible", EditCondition="bUseRenderTargetAtlas", ClampMin=1))
+	int32 MaxAtlasPages = 4;
+
+	/**
+	 * Recycle dedicated render targets through a per world pool bucketed by (size, format) instead of
+	 * allocating new ones in BeginPlay and dropping them in EndPlay.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Render Targets", meta=(Categories="Niagara Destructible"))
+	bool bUseRenderTargetPool = true;
+
+	/** How many free render targets each (size, format) bucket keeps around. Extra released render targets are freed. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Render Targets", meta=(Categories="Niagara Destructible", EditCondition="bUseRenderTargetPool", ClampMin=0))
+	int32 MaxFreeRenderTargetsPerBucket = 256;
+
+	/**
+	 * Size the bounds of destroyed destructibles from the simulated fragment positions (read back asynchronously from
+	 * the positions render target) instead of a fixed CullingBoundsMultiplier. Bounds shrink again as debris settles.
+	 * Readbacks stop once the debris stopped spreading after the last force, the next force restarts them.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Render Targets", meta=(Categories="Niagara Destructible"))
+	bool bUseDynamicBounds = true;
+
+	/** Seconds between fragment position readbacks for dynamic bounds. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Render Targets", meta=(Categories="Niagara Destructible", EditCondition="bUseDynamicBounds", ClampMin=0.05))
+	float DynamicBoundsUpdateInterval = 0.25f;
+
+	/** Largest bounds scale dynamic bounds may grow to, relative to the intact mesh. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Render Targets", meta=(Categories="Niagara Destructible", EditCondition="bUseDynamicBounds", ClampMin=1))
+	float MaxDynamicBoundsScale = 16.f;
+
+	/**
+	 * Pass the per actor material values (RT_TileOffsetScale, ActorRotationQuat, ObjectBoundsScale) as custom primitive data and
+	 * share one material instance per slot between all destructibles binding the same textures, instead of a dynamic material per
+	 * actor and slot. Your VAT material needs those parameters set to "Use Custom Primitive Data", see FNiagaraDestructionDriverPrimitiveData.
+	 * Actors only share textures (and so materials) through the render target atlas.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Materials", meta=(Categories="Niagara Destructible"))
+	bool bUseCustomPrimitiveData = false;
+
+	/**
+	 * Slots of the instance group of each instanced data asset (UNiagaraDestructionDriverDataAsset::bInstanced), which is also the
+	 * number of tiles in its render targets. Destructibles activated while their group is full are drawn on their own.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Instancing", meta=(Categories="Niagara Destructible", ClampMin=1))
+	int32 MaxInstancesPerDataAsset = 256;
+
+	/**
+	 * Draw the SourceGeometryContainer meshes of intact destructibles as instances of per world batches shared by every destructible
+	 * (UNiagaraDestructionDriverProxySubsystem) instead of a component per mesh per actor. Draw calls and primitives of intact props
+	 * then scale with unique meshes instead of actors. Batched proxies stop colliding once their destructible swaps to fragments,
+	 * like entities. Destructibles with bTrackTransformChanges and headless ones (dedicated servers) keep their own components.
+	 * Traces and overlaps against batched proxies return the batch owner actor instead of the destructible, and destructibles moved
+	 * without bTrackTransformChanges leave their proxies behind.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Instancing", meta=(Categories="Niagara Destructible"))
+	bool bBatchSourceGeometry = false;
+
+	/**
+	 * The chaos-to-niagara tool merges every GeometrySource mesh of the geometry collection (at its LocalTransform) into one proxy
+	 * static mesh with a material slot per unique material, instead of adding a SourceGeometryContainer component per source mesh.
+	 * Applies to new conversions, the conversion log reports the proxy triangles and draw calls saved.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Conversion", meta=(Categories="Niagara Destructible"))
+	bool bMergeSourceGeometryProxy = false;
+
+	/** Triangles the merged proxy mesh is simplified down to, 0 keeps every source triangle. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Conversion", meta=(Categories="Niagara Destructible", EditCondition="bMergeSourceGeometryProxy", ClampMin=0))
+	int32 MergedProxyTriangleBudget = 0;
+
+	/**
+	 * Simulate the bones of every destroyed destructible with a tile in the same render target atlas page in one instance of
+	 * SharedSimulationSystem (UNiagaraDestructionDriverSharedSimulationSubsystem) instead of an instance of its own
+	 * ParticleSystemDriver. Needs bUseRenderTargetAtlas and data assets converted while this is enabled (InitialBoneLocations);
+	 * everything else, including instanced data assets, keeps simulating on its own.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Simulation", meta=(Categories="Niagara Destructible"))
+	bool bUseSharedSimulation = false;
+
+	/**
+	 * Niagara system simulating the bone ranges of a whole atlas page. It receives the per bone, per range and force arrays of
+	 * FNiagaraDestructionDriverParameterNames (BoneRanges, RangeLocations, ForceRanges, ...) and writes each range into its tile.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Simulation", meta=(Categories="Niagara Destructible", EditCondition="bUseSharedSimulation"))
+	TSoftObjectPtr<UNiagaraSystem> SharedSimulationSystem;
+
+	/** Bones (particles) each shared simulation instance is spawned with, split between the destructibles of its atlas page. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Simulation", meta=(Categories="Niagara Destructible", EditCondition="bUseSharedSimulation", ClampMin=1))
+	int32 MaxSharedSimulationBones = 65536;
+
+	/**
+	 * Destructibles destroy their own niagara component in BeginPlay. On their first hit they borrow one set up for their
+	 * ParticleSystemDriver from a per world pool (UNiagaraDestructionDriverNiagaraComponentPool) and give it back once they settle
+	 * or are reset.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Simulation", meta=(Categories="Niagara Destructible"))
+	bool bPoolNiagaraComponents = false;
+
+	/**
+	 * Niagara components (in use + free) each world's pool may hold, which bounds the live system instances during large battles.
+	 * When all are in use, the destructible that has been simulating the longest gives its component back early (its fragments
+	 * stop, it isn't settled and borrows again on its next force).
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Simulation", meta=(Categories="Niagara Destructible", EditCondition="bPoolNiagaraComponents", ClampMin=1))
+	int32 MaxPooledNiagaraComponents = 64;
+
+	/**
+	 * Register destroyed destructibles with the world's significance manager (SignificanceManager plugin) and simulate them at
+	 * full rate, reduced rate, frozen or baked depending on their screen size, distance and the age of their last force
+	 * (UNiagaraDestructionDriverSignificanceSubsystem), so simulation cost follows what is visible.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Significance", meta=(Categories="Niagara Destructible"))
+	bool bUseSignificance = false;
+
+	/** Update the significance manager from the player cameras every frame. Disable if your game already updates it. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Significance", meta=(Categories="Niagara Destructible", EditCondition="bUseSignificance"))
+	bool bUpdateSignificanceManager = true;
+
+	/** Tier thresholds for platforms without an entry in PlatformSignificanceThresholds */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Significance", meta=(Categories="Niagara Destructible", EditCondition="bUseSignificance"))
+	FNiagaraDestructionDriverSignificanceThresholds SignificanceThresholds;
+
+	/** Tier thresholds per ini platform name (Windows, Android, IOS, ...). Platform config files can override either as well. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Significance", meta=(Categories="Niagara Destructible", EditCondition="bUseSignificance"))
+	TMap<FName, FNiagaraDestructionDriverSignificanceThresholds> PlatformSignificanceThresholds;
+
+	/** SignificanceThresholds, or the entry of the running platform in PlatformSignificanceThresholds */
+	const FNiagaraDestructionDriverSignificanceThresholds& GetSignificanceThresholds() const;
+
+	/** How often (seconds) lazily activated destructibles check for players within their LazyActivationDistance. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Activation", meta=(Categories="Niagara Destructible", ClampMin=0))
+	float LazyActivationCheckInterval = 0.25f;
+
+	/**
+	 * Spread the first-hit hot swap of destructibles over frames through UNiagaraDestructionDriverActivationScheduler instead of
+	 * running it for every destructible a large force overlaps in the same frame. Closest to the camera and the force go first;
+	 * deferred destructibles receive their forces with the original start time.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Activation", meta=(Categories="Niagara Destructible"))
+	bool bUseActivationBudget = true;
+
+	/** Maximum hot swaps per frame. 0 means no count limit. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Activation", meta=(Categories="Niagara Destructible", EditCondition="bUseActivationBudget", ClampMin=0))
+	int32 MaxHotSwapsPerFrame = 16;
+
+	/** Game thread time (milliseconds) hot swaps may take per frame. At least one runs per frame. 0 means no time limit. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Activation", meta=(Categories="Niagara Destructible", EditCondition="bUseActivationBudget", ClampMin=0))
+	float HotSwapTimeBudgetMs = 2.f;
+
+	/**
+	 * While a level loads, precache the PSOs of the destructible mesh materials and briefly run the niagara driver of every
+	 * data asset placed in it (UNiagaraDestructionDriverPrewarmSubsystem), so the first destruction of a prop type doesn't hitch.
+	 * Check the coverage with r.NDD.DumpPrewarmStats.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Prewarm", meta=(Categories="Niagara Destructible"))
+	bool bPrewarmDestructibles = true;
+
+	/** Also run each niagara driver off screen for NiagaraWarmupDuration so its simulation shaders are bound during loading. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Prewarm", meta=(Categories="Niagara Destructible", EditCondition="bPrewarmDestructibles"))
+	bool bPrewarmNiagaraSystems = true;
+
+	/** Seconds the warmup niagara systems run before they are destroyed. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Prewarm", meta=(Categories="Niagara Destructible", EditCondition="bPrewarmDestructibles && bPrewarmNiagaraSystems", ClampMin=0.01))
+	float NiagaraWarmupDuration = 0.2f;
+
+	/**
+	 * Keep the destructible mesh and bone texture (soft referenced by the data asset) resident only while destructibles need them:
+	 * from activation (or AssetStreamingDistance / PrefetchDestructionAssets) until a reset of a lazily activated destructible,
+	 * the settle bake or the last fragment despawning. Off keeps them resident for every placed destructible, like hard references.
+	 * Check the resident set with r.NDD.DumpStreamingStats and "NDD Resident Streamed Assets" in stat NiagaraDestructionDriver.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Streaming", meta=(Categories="Niagara Destructible"))
+	bool bStreamDestructibleMeshes = true;
+
+	/** How many released destructibles UNiagaraDestructionDriverActorPool keeps per data asset. Extra released actors are destroyed. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Activation", meta=(Categories="Niagara Destructible", ClampMin=0))
+	int32 MaxPooledDestructiblesPerDataAsset = 64;
+
+	/**
+	 * Seconds without a new destruction force (counted from the end of the last force) after which a destructible is
+	 * considered settled: its niagara simulation is stopped and released, the render targets keep the last pose.
+	 * A new destruction force wakes a settled destructible up and simulates it again. 0 disables settling, which keeps every
+	 * destroyed destructible simulating like without this setting.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Settling", meta=(Categories="Niagara Destructible", ClampMin=0))
+	float SettleQuietTime = 0.f;
+
+	/**
+	 * Before settling, also check that no fragment moved faster than SettleVelocityThreshold by reading back the positions render
+	 * target (asynchronously) every SettleVelocityCheckInterval. Costs a GPU readback per check, so only enable it if fragments can
+	 * still be moving after SettleQuietTime.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Settling", meta=(Categories="Niagara Destructible"))
+	bool bConfirmSettleWithVelocity = false;
+
+	/** Max fragment speed (units per second) still considered at rest. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Settling", meta=(Categories="Niagara Destructible", EditCondition="bConfirmSettleWithVelocity", ClampMin=0))
+	float SettleVelocityThreshold = 5.f;
+
+	/** Seconds between the positions readbacks used to measure fragment velocity. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Settling", meta=(Categories="Niagara Destructible", EditCondition="bConfirmSettleWithVelocity", ClampMin=0.05))
+	float SettleVelocityCheckInterval = 0.5f;
+
+	/**
+	 * Once settled, read back the final bone transforms (asynchronously) and bake them into a transient static mesh without WPO,
+	 * then give the render targets back. Needs a data asset with InitialBoneLocations and BakedMaterials and a static mesh
+	 * with CPU access, which the chaos-to-niagara tool sets up while this is enabled.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Settling", meta=(Categories="Niagara Destructible"))
+	bool bBakeSettledDestructibles = false;
+
+	/**
+	 * Keep the state of destroyed destructibles whose level or World Partition cell streams out (force history and the bone pose
+	 * read back when they settled) and show them settled again when it streams back in, without resimulating. Destructibles still
+	 * simulating (all of them without SettleQuietTime) replay their forces instead.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Settling", meta=(Categories="Niagara Destructible"))
+	bool bPersistStreamedOutDestruction = true;
+
+	/** Fragment lifetime (seconds after the first destruction force) for data assets that don't set their own. 0 keeps fragments forever. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Lifecycle", meta=(Categories="Niagara Destructible", ClampMin=0))
+	float DefaultFragmentLifetime = 0.f;
+
+	/** Upper bound for every fragment lifetime, so long sessions can't pile up rubble forever. 0 means no cap. */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Lifecycle", meta=(Categories="Niagara Destructible", ClampMin=0))
+	float MaxFragmentLifetime = 0.f;
+
+	/**
+	 * Destruction forces each destructible keeps in its DestructionForceHistory, the oldest are dropped first. The history is part
+	 * of every streamed out state and save snapshot, this keeps their size bounded by the bone count. 0 means no cap.
+	 */
+	UPROPERTY(Config, EditDefaultsOnly, Category="Config|Lifecycle", meta=(Categories="Niagara Destructible", ClampMin=0))
+	int32 MaxDestructionForceHistory = 32;
 };
@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraDestructionDriverActor.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "NiagaraDestructionDriverSharedSimulationSubsystem.generated.h"
+
+class UNiagaraComponent;
+struct FNiagaraDestructionDriverRuntimeContext;
+
+/**
+ * One system instance of UNiagaraDestructionDriverSettings::SharedSimulationSystem, simulating the bones of every destructible
+ * with a tile in one render target atlas page. Range N is a span of the bone budget, written to the tile of its destructible.
+ */
+USTRUCT()
+struct FNiagaraDestructionDriverSharedSimulation
+{
+	GENERATED_BODY()
+
+	/** Writes into the atlas page, paused while no range is simulating */
+	UPROPERTY() TObjectPtr<UNiagaraComponent> NiagaraComponent;
+
+	/** Destructible holding each range, unset for free ranges */
+	TArray<TWeakObjectPtr<ANiagaraDestructionDriverActor>> Owners;
+	TArray<int32> FreeRanges;
+
+	/** Unused spans of the bone budget (X = first bone, Y = bone count), sorted by first bone */
+	TArray<FIntPoint> FreeBoneSpans;
+
+	/** Per bone of the budget: initial location in normalized [-1,1] mesh space, and the range it belongs to (INDEX_NONE if free) */
+	TArray<FVector> BoneInitialLocations;
+	TArray<int32> BoneRanges;
+
+	/** Per range, as passed to the niagara system. Locations are where the range's particles are centered (the pivot offset applied). */
+	TArray<int32> RangeBoneStarts;
+	TArray<int32> RangeBoneCounts;
+	TArray<FVector> RangeLocations;
+	TArray<FQuat> RangeRotations;
+	TArray<FVector> RangeScales;
+	TArray<FVector> RangeHalfExtents;
+	TArray<FVector4> RangeTileOffsetScales;
+	TArray<int32> RangeTileSizes;
+	TArray<bool> RangeSimulating;
+	TArray<int32> RangeResetCounts;
+
+	/** Forces still pushing, each for the range in ForceRanges */
+	TArray<FNiagaraDestructionDriverForce> Forces;
+	TArray<int32> ForceRanges;
+
+	/** The niagara user arrays need to be sent again, the bone arrays only when ranges come and go */
+	bool bParametersDirty = false;
+	bool bBonesDirty = false;
+};
+
+/**
+ * Shared simulation mode (UNiagaraDestructionDriverSettings::bUseSharedSimulation): instead of a niagara system instance per
+ * destroyed destructible, one instance per render target atlas page simulates the bones of every destructible with a tile in it.
+ * Each destructible gets a bone range of the page's budget, its forces are routed to that range, and transforms and forces
+ * of a frame are sent once per page in Tick. Simulation dispatches and game thread instance overhead stay flat as destruction
+ * scales. Meshes and materials stay per destructible, they read the same atlas tiles as before.
+ *
+ * Needs the render target atlas and data assets with InitialBoneLocations (the chaos-to-niagara tool fills them while this is
+ * enabled). Destructibles that don't fit the bone budget simulate on their own.
+ */
+UCLASS()
+class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverSharedSimulationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/**
+	 * Gives the destructible a bone range in the simulation of its atlas page (created on demand).
+	 * False if the shared system isn't loaded yet, the data asset has no InitialBoneLocations or the bone budget is used up.
+	 */
+	bool AcquireRange(ANiagaraDestructionDriverActor* Destructible, const FNiagaraDestructionDriverRuntimeContext& Context, const FNiagaraDestructionDriverAtlasTile& Tile);
+
+	/** Frees the destructible's range, the simulation is released with its last range */
+	void ReleaseRange(const ANiagaraDestructionDriverActor* Destructible);
+
+	/** Drops the range's forces and has the niagara system respawn its bones at their initial locations */
+	void ResetRange(const ANiagaraDestructionDriverActor* Destructible);
+
+	/** Moves where the range's bones are simulated to the destructible's current transform */
+	void UpdateRangeTransform(const ANiagaraDestructionDriverActor* Destructible);
+
+	/** Adds a force pushing the destructible's bones and simulates them until SettleRange */
+	void ApplyForce(const ANiagaraDestructionDriverActor* Destructible, const FNiagaraDestructionDriverForce& Force);
+
+	/** Stops simulating the destructible's bones, its tile keeps the last pose */
+	void SettleRange(const ANiagaraDestructionDriverActor* Destructible);
+
+	/** Number of shared system instances (atlas pages with simulated destructibles) */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	int32 GetNumSimulations() const { return Simulations.Num(); }
+
+	/** Number of destructibles holding a bone range */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	int32 GetNumRanges() const { return RangeKeys.Num(); }
+
+	/** Logs ranges, simulating ranges, forces and bones used of every simulation */
+	void DumpSharedSimulationStats() const;
+
+	// <overrides>
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return Simulations.Num() > 0; }
+	virtual void Deinitialize() override;
+	// </overrides>
+
+protected:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	FNiagaraDestructionDriverSharedSimulation* AddSimulation(const FNiagaraDestructionDriverAtlasTile& Tile);
+	void RemoveSimulation(const int32 PageIndex);
+
+	/** The simulation and range held by the destructible, null if it holds none */
+	FNiagaraDestructionDriverSharedSimulation* FindSimulation(const ANiagaraDestructionDriverActor* Destructible, int32& OutRange);
+
+	/** First fit span of NumBones bones, INDEX_NONE if none is left */
+	static int32 AllocateBones(FNiagaraDestructionDriverSharedSimulation& Simulation, const int32 NumBones);
+	static void FreeBones(FNiagaraDestructionDriverSharedSimulation& Simulation, const int32 FirstBone, const int32 NumBones);
+
+	/** Takes the niagara transform of the range from its destructible */
+	static void SetRangeTransform(FNiagaraDestructionDriverSharedSimulation& Simulation, const int32 Range, const ANiagaraDestructionDriverActor* Destructible);
+
+	/** Sends the per range, per bone and force arrays to the niagara system */
+	void PushParameters(FNiagaraDestructionDriverSharedSimulation& Simulation) const;
+
+	static void RemoveForces(FNiagaraDestructionDriverSharedSimulation& Simulation, const int32 Range);
+
+	void UpdateStats() const;
+
+	/** Per atlas page */
+	UPROPERTY() TMap<int32, FNiagaraDestructionDriverSharedSimulation> Simulations;
+
+	/** Atlas page (X) and range (Y) of every destructible holding one */
+	TMap<TObjectKey<ANiagaraDestructionDriverActor>, FIntPoint> RangeKeys;
+
+	/** Owns the simulation components */
+	UPROPERTY() TObjectPtr<AActor> SimulationOwner;
+};
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraDestructionDriverActor.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "NiagaraDestructionDriverSignificanceSubsystem.generated.h"
+
+/**
+ * Significance LOD for destroyed destructibles (UNiagaraDestructionDriverSettings::bUseSignificance). A destructible registers
+ * with the world's USignificanceManager on its first hit and leaves it once settled or reset. Its significance is its screen
+ * size (bounds radius over view distance, 0 while not rendered or beyond MaxSimulationDistance), or the highest possible while
+ * its last force is younger than FullRateForceTime. Every frame the significance and the age of the last force pick its tier
+ * (ENiagaraDestructionDriverSignificanceTier) from GetSignificanceThresholds, so simulation cost follows what is visible.
+ * Reduced tier destructibles are paused between steps and catch up with a custom time dilation when they do step.
+ */
+UCLASS()
+class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverSignificanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Starts picking a tier for the destructible. Does nothing without a significance manager. */
+	void RegisterDestructible(ANiagaraDestructionDriverActor* Destructible);
+
+	void UnregisterDestructible(ANiagaraDestructionDriverActor* Destructible);
+
+	/** Number of registered destructibles currently in the tier */
+	UFUNCTION(BlueprintPure, Category = "Niagara Destructible")
+	int32 GetNumDestructiblesInTier(const ENiagaraDestructionDriverSignificanceTier Tier) const;
+
+	/** Logs the registered destructibles per tier and the thresholds in use */
+	void DumpSignificanceStats() const;
+
+	// <overrides>
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	virtual bool IsTickable() const override { return Destructibles.Num() > 0; }
+	virtual void Deinitialize() override;
+	// </overrides>
+
+protected:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	struct FRegisteredDestructible
+	{
+		TWeakObjectPtr<ANiagaraDestructionDriverActor> Destructible;
+
+		/** Center and radius of the intact mesh in actor space */
+		FVector LocalCenter = FVector::ZeroVector;
+		float BoundsRadius = 0.f;
+
+		/** Last significance the manager computed, the highest view wins */
+		float Significance = TNumericLimits<float>::Max();
+
+		/** Time since the last step of the reduced tier */
+		float TimeSinceStep = 0.f;
+	};
+
+	/** Called by the significance manager, possibly in parallel: only reads */
+	float CalculateSignificance(const FRegisteredDestructible& Entry, const FTransform& View) const;
+
+	static ENiagaraDestructionDriverSignificanceTier PickTier(const float Significance, const float ForceAge);
+
+	/** Pauses reduced tier destructibles between steps */
+	static void StepReducedRate(FRegisteredDestructible& Entry, const float DeltaTime);
+
+	void UpdateStats() const;
+
+	TMap<TObjectKey<ANiagaraDestructionDriverActor>, FRegisteredDestructible> Destructibles;
+};
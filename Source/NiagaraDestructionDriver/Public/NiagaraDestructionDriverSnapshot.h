@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FNiagaraDestructionDriverSavedState;
+
+/**
+ * Packs a FNiagaraDestructionDriverSavedState into a compact, versioned byte array for save games.
+ *
+ * Layout (little endian, via FMemoryWriter):
+ * - version, flags (fragments despawned, has pose, settled)
+ * - force history (origin, radius, duration, start time)
+ * - despawned fragments as a bit array over the bones
+ * - per bone: position as 3 int16 relative to the largest absolute coordinate, rotation as smallest-three (1 byte + 3 int16)
+ * That is 13 bytes per bone, precise to ~1/32767 of the debris spread and well below a degree.
+ */
+struct NIAGARADESTRUCTIONDRIVER_API FNiagaraDestructionDriverSnapshot
+{
+	static void Write(const FNiagaraDestructionDriverSavedState& State, TArray<uint8>& OutSnapshot);
+
+	/** False if the snapshot is malformed or from an unknown version */
+	static bool Read(const TArray<uint8>& Snapshot, FNiagaraDestructionDriverSavedState& OutState);
+};
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NiagaraDestructionDriverActor.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NiagaraDestructionDriverStreamingSubsystem.generated.h"
+
+/**
+ * Keeps the destruction state of destructibles whose level (or World Partition cell) streamed out, see
+ * UNiagaraDestructionDriverSettings::bPersistStreamedOutDestruction. A destroyed destructible leaving the world stores its
+ * FNiagaraDestructionDriverSavedState here (its render targets and niagara instance go away with it), and picks it up again
+ * in BeginPlay when its level streams back in, showing the settled pose right away.
+ */
+UCLASS()
+class NIAGARADESTRUCTIONDRIVER_API UNiagaraDestructionDriverStreamingSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Captures and keeps the state of a destroyed destructible. Resting destructibles are skipped. */
+	void StoreState(const ANiagaraDestructionDriverActor* Destructible);
+
+	/** Moves the stored state of this destructible (if any) into OutState */
+	bool ConsumeState(const ANiagaraDestructionDriverActor* Destructible, FNiagaraDestructionDriverSavedState& OutState);
+
+	/** Identifies a placed destructible across unloads and reloads of its level: the path of the actor inside its level package. */
+	static FString GetStateKey(const AActor* Destructible);
+
+	int32 GetNumStoredStates() const { return StoredStates.Num(); }
+
+	// <overrides>
+	virtual void Deinitialize() override;
+	// </overrides>
+
+protected:
+
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	UPROPERTY() TMap<FString, FNiagaraDestructionDriverSavedState> StoredStates;
+};
@@ -10,6 +10,8 @@
 #include "DynamicMeshEditor.h"
 #include "DynamicMeshToMeshDescription.h"
 #include "MeshDescriptionBuilder.h"
+#include "MeshDescriptionToDynamicMesh.h"
+#include "MeshSimplification.h"
 #include "StaticMeshAttributes.h"
 #include "DynamicMesh/MeshNormals.h"
 #include "DynamicMesh/MeshTransforms.h"
@@ -26,6 +28,7 @@
 #include "IContentBrowserSingleton.h"
 #include "NiagaraDestructionDriverActor.h"
 #include "NiagaraDestructionDriverDataAsset.h"
+#include "NiagaraDestructionDriverSettings.h"
 #include "PlanarCut.h"
 #include "Engine/SCS_Node.h"
 #include "Engine/SimpleConstructionScript.h"
@@ -82,6 +85,24 @@ int32 NearestBiggerPowerOfTwo(int32 Reference)
 	return Reference;
 }
 
+/** Adds the LOD 0 triangles and non empty sections (one draw call each) of a proxy mesh */
+void AddProxyMeshCost(const UStaticMesh* Mesh, int32& InOutTriangles, int32& InOutDrawCalls)
+{
+	const FMeshDescription* MeshDescription = Mesh ? Mesh->GetMeshDescription(0) : nullptr;
+	if (MeshDescription == nullptr)
+	{
+		return;
+	}
+	InOutTriangles += MeshDescription->Triangles().Num();
+	for (const FPolygonGroupID PolygonGroup : MeshDescription->PolygonGroups().GetElementIDs())
+	{
+		if (MeshDescription->GetNumPolygonGroupPolygons(PolygonGroup) > 0)
+		{
+			InOutDrawCalls++;
+		}
+	}
+}
+
 #pragma endregion 
 // </utility_functions>
 
@@ -623,6 +644,8 @@ UNiagaraDestructionDriverDataAsset* UNiagaraDestructionDriverGeometryCollectionF
 	// since we need to enable NDD material function params on the new materials instances, we want to create and save new ones for this generated static mesh
 	// yes this is done after we've already done the material assignment once, but the benefit is that this block of code can be easily commented out and things still work
 	// with the original materials
+	// the original materials don't have the WPO, settled destructibles switch back to them once baked
+	const TArray<FStaticMaterial> SourceMaterials = StaticMesh->GetStaticMaterials();
 	auto NewMaterialInstances = UNiagaraDestructionDriverGeometryCollectionFunctions::CreateNewInstancesOfMeshMaterials(StaticMesh);
 	for (int Idx = 0; Idx< NewMaterialInstances.Num(); Idx++)
 	{
@@ -648,6 +671,12 @@ UNiagaraDestructionDriverDataAsset* UNiagaraDestructionDriverGeometryCollectionF
 	}
 	// Additional steps to ensure editor updates
 	FEditorDelegates::MapChange.Broadcast(0);
+	// baking settled destructibles reads the vertices back on the CPU
+	const bool bBakeSettledDestructibles = GetDefault<UNiagaraDestructionDriverSettings>()->bBakeSettledDestructibles;
+	if (bBakeSettledDestructibles)
+	{
+		StaticMesh->bAllowCPUAccess = true;
+	}
 	// Save the generated Static Mesh in the editor
 	QuickSaveAssetRelativeTo(StaticMesh, GeometryCollectionIn, StaticMesh->GetName(), TEXT(""));
 
@@ -663,8 +692,57 @@ UNiagaraDestructionDriverDataAsset* UNiagaraDestructionDriverGeometryCollectionF
 	DataAsset->CustomUVChannelIndex = 1;
 	DataAsset->RenderTargetTextureSize = RenderTargetTextureSize;
 	DataAsset->PivotOffset = -GeometryCollectionIn->GetGeometryCollection()->GetBoundingBox().Origin;
+	// fragment sizes drive FragmentDespawnSizeThreshold
+	const TManagedArray<FBox>& FragmentBounds = GeometryCollectionIn->GetGeometryCollection()->GetAttribute<FBox>("BoundingBox", FGeometryCollection::GeometryGroup);
+	DataAsset->BoneSizes.Reserve(FragmentBounds.Num());
+	for (int32 GeometryIdx = 0; GeometryIdx < FragmentBounds.Num(); GeometryIdx++)
+	{
+		DataAsset->BoneSizes.Add(FragmentBounds[GeometryIdx].GetSize().GetMax());
+	}
+	// the shared simulation spawns bones from this CPU copy instead of a texture per destructible
+	if (bBakeSettledDestructibles || GetDefault<UNiagaraDestructionDriverSettings>()->bUseSharedSimulation)
+	{
+		DataAsset->InitialBoneLocations = GenerateGeometryCollectionFragmentCentroids(GeometryCollectionIn->GetGeometryCollection().Get());
+	}
+	if (bBakeSettledDestructibles)
+	{
+		for (const FStaticMaterial& SourceMaterial : SourceMaterials)
+		{
+			DataAsset->BakedMaterials.Add(SourceMaterial.MaterialInterface);
+		}
+	}
 	// Save the DataAsset in the editor
 	QuickSaveAssetRelativeTo(DataAsset, GeometryCollectionIn, DataAsset->GetName(), TEXT(""));
+
+	// the intact proxy is either a component per source mesh, or one merged (and simplified) mesh
+	TArray<UStaticMesh*> SourceMeshes;
+	TArray<FTransform> SourceMeshTransforms;
+	int32 SourceTriangles = 0;
+	int32 SourceDrawCalls = 0;
+	for (const FGeometryCollectionSource& SourceGeometry : GeometryCollectionIn->GeometrySource)
+	{
+		if (UStaticMesh* SourceMesh = Cast<UStaticMesh>(SourceGeometry.SourceGeometryObject.TryLoad()))
+		{
+			SourceMeshes.Add(SourceMesh);
+			SourceMeshTransforms.Add(SourceGeometry.LocalTransform);
+			AddProxyMeshCost(SourceMesh, SourceTriangles, SourceDrawCalls);
+		}
+	}
+	int32 ProxyTriangles = SourceTriangles;
+	int32 ProxyDrawCalls = SourceDrawCalls;
+	const UNiagaraDestructionDriverSettings* Settings = GetDefault<UNiagaraDestructionDriverSettings>();
+	if (Settings->bMergeSourceGeometryProxy && SourceMeshes.Num() > 0)
+	{
+		if (UStaticMesh* MergedProxyMesh = MergeSourceGeometryToProxyMesh(GeometryCollectionIn, Settings->MergedProxyTriangleBudget))
+		{
+			QuickSaveAssetRelativeTo(MergedProxyMesh, GeometryCollectionIn, MergedProxyMesh->GetName(), TEXT(""));
+			SourceMeshes = { MergedProxyMesh };
+			SourceMeshTransforms = { FTransform::Identity };
+			ProxyTriangles = 0;
+			ProxyDrawCalls = 0;
+			AddProxyMeshCost(MergedProxyMesh, ProxyTriangles, ProxyDrawCalls);
+		}
+	}
 	
 	// create new package for Destruction Actor
 	FString UniqueActorPackageName;
@@ -689,13 +767,13 @@ UNiagaraDestructionDriverDataAsset* UNiagaraDestructionDriverGeometryCollectionF
 				// Set the NDD data asset property directly on the CDO
 				CDO->NiagaraDestructionDriverParams = DataAsset;
 
-				// for each piece of the source geometry in the collection
-				for (FGeometryCollectionSource& SourceGeometry : GeometryCollectionIn->GeometrySource)
+				// for each piece of the source geometry in the collection (or the merged proxy mesh)
+				for (int32 SourceIdx = 0; SourceIdx < SourceMeshes.Num(); SourceIdx++)
 				{
 					// grab the static mesh and attach it as a component to the new actor
 					// we do this so we can have a hot-swappable simple mesh that changes into the destructible mesh
 					// at runtime when destruction forces happen
-					if (UStaticMesh* SourceMesh = Cast<UStaticMesh>(SourceGeometry.SourceGeometryObject.TryLoad()))
+					if (UStaticMesh* SourceMesh = SourceMeshes[SourceIdx])
 					{
 						/*
 						UStaticMeshComponent* SourceMeshComp = NewObject<UStaticMeshComponent>(CDO, FName(SourceMesh->GetName()));
@@ -719,7 +797,7 @@ UNiagaraDestructionDriverDataAsset* UNiagaraDestructionDriverGeometryCollectionF
 						
 						SourceMeshComp->SetStaticMesh(SourceMesh);
 						SourceMeshComp->AttachToComponent(CDO->SourceGeometryContainer, FAttachmentTransformRules::KeepRelativeTransform);
-						SourceMeshComp->SetRelativeTransform(SourceGeometry.LocalTransform);
+						SourceMeshComp->SetRelativeTransform(SourceMeshTransforms[SourceIdx]);
 					}
 				}
             
@@ -743,6 +821,15 @@ UNiagaraDestructionDriverDataAsset* UNiagaraDestructionDriverGeometryCollectionF
 		*PackageFileName,
 		SaveArgs);
 
+	UE_LOG(LogNiagaraDestructionDriverEditor, Display, TEXT("Converted %s: intact proxy of %d source meshes as %d component(s), %d -> %d triangles, %d -> %d draw calls."),
+		*GeometryCollectionIn->GetName(),
+		GeometryCollectionIn->GeometrySource.Num(),
+		SourceMeshes.Num(),
+		SourceTriangles,
+		ProxyTriangles,
+		SourceDrawCalls,
+		ProxyDrawCalls);
+
 	return DataAsset;
 }
 
@@ -962,3 +1049,105 @@ UTexture2D* UNiagaraDestructionDriverGeometryCollectionFunctions::CreateInitialB
 
 	return NewTexture;
 }
+
+
+UStaticMesh* UNiagaraDestructionDriverGeometryCollectionFunctions::MergeSourceGeometryToProxyMesh(UGeometryCollection* GeometryCollectionIn, int32 TriangleBudget)
+{
+	check(GeometryCollectionIn);
+
+	FDynamicMesh3 MergedMesh;
+	TArray<UMaterialInterface*> MergedMaterials;
+	bool bHasMergedMesh = false;
+
+	for (const FGeometryCollectionSource& SourceGeometry : GeometryCollectionIn->GeometrySource)
+	{
+		const UStaticMesh* SourceMesh = Cast<UStaticMesh>(SourceGeometry.SourceGeometryObject.TryLoad());
+		const FMeshDescription* SourceMeshDescription = SourceMesh ? SourceMesh->GetMeshDescription(0) : nullptr;
+		if (SourceMeshDescription == nullptr)
+		{
+			continue;
+		}
+
+		FDynamicMesh3 SourceDynamicMesh;
+		FMeshDescriptionToDynamicMesh ToDynamicMesh;
+		ToDynamicMesh.Convert(SourceMeshDescription, SourceDynamicMesh, true);
+		MeshTransforms::ApplyTransform(SourceDynamicMesh, FTransformSRT3d(SourceGeometry.LocalTransform), true);
+		if (!SourceDynamicMesh.Attributes()->HasMaterialID())
+		{
+			SourceDynamicMesh.Attributes()->EnableMaterialID();
+		}
+
+		// one merged slot per unique material, the source's own material overrides win over the mesh's
+		FDynamicMeshMaterialAttribute* MaterialIDs = SourceDynamicMesh.Attributes()->GetMaterialID();
+		TMap<int32, int32> MergedSlots;
+		for (const int32 TriangleID : SourceDynamicMesh.TriangleIndicesItr())
+		{
+			const int32 SourceSlot = MaterialIDs->GetValue(TriangleID);
+			const int32* MergedSlot = MergedSlots.Find(SourceSlot);
+			if (MergedSlot == nullptr)
+			{
+				UMaterialInterface* Material = SourceGeometry.SourceMaterial.IsValidIndex(SourceSlot) && SourceGeometry.SourceMaterial[SourceSlot]
+					? SourceGeometry.SourceMaterial[SourceSlot].Get()
+					: SourceMesh->GetMaterial(SourceSlot);
+				MergedSlot = &MergedSlots.Add(SourceSlot, MergedMaterials.AddUnique(Material));
+			}
+			MaterialIDs->SetValue(TriangleID, *MergedSlot);
+		}
+
+		if (!bHasMergedMesh)
+		{
+			MergedMesh = MoveTemp(SourceDynamicMesh);
+			bHasMergedMesh = true;
+			continue;
+		}
+		// later sources take the attribute layout (UV layers etc.) of the first one
+		SourceDynamicMesh.EnableMatchingAttributes(MergedMesh, false);
+		FDynamicMeshEditor MeshEditor(&MergedMesh);
+		FMeshIndexMappings IndexMappings;
+		MeshEditor.AppendMesh(&SourceDynamicMesh, IndexMappings);
+	}
+
+	if (MergedMesh.TriangleCount() == 0)
+	{
+		return nullptr;
+	}
+
+	if (TriangleBudget > 0 && MergedMesh.TriangleCount() > TriangleBudget)
+	{
+		FScopedSlowTask SimplifyTask(1, INVTEXT("Simplifying merged proxy mesh"));
+		SimplifyTask.MakeDialog();
+
+		// keeps the UV and material seams, the proxy is only seen before the first hit
+		FAttrMeshSimplification Simplifier(&MergedMesh);
+		Simplifier.SimplifyToTriangleCount(TriangleBudget);
+		MergedMesh.CompactInPlace();
+	}
+
+	UStaticMesh* ProxyMesh = NewObject<UStaticMesh>(
+		GetTransientPackage(),
+		UStaticMesh::StaticClass(),
+		FName(TEXT("SM_") + GeometryCollectionIn->GetName() + TEXT("_Proxy_NDD")),
+		RF_Standalone | RF_Public | RF_Transactional);
+
+	ProxyMesh->SetNumSourceModels(1);
+	// normals and tangents carry over from the source meshes
+	ProxyMesh->GetSourceModel(0).BuildSettings.bRecomputeNormals = false;
+	ProxyMesh->GetSourceModel(0).BuildSettings.bRecomputeTangents = false;
+
+	FMeshDescription* ProxyMeshDescription = ProxyMesh->CreateMeshDescription(0);
+	FStaticMeshAttributes(*ProxyMeshDescription).Register();
+	FDynamicMeshToMeshDescription ToMeshDescription;
+	ToMeshDescription.Convert(&MergedMesh, *ProxyMeshDescription, true);
+
+	for (UMaterialInterface* Material : MergedMaterials)
+	{
+		ProxyMesh->GetStaticMaterials().Add(FStaticMaterial(Material));
+	}
+	ProxyMesh->CommitMeshDescription(0);
+
+	// the source meshes' simple collision doesn't carry over
+	ProxyMesh->CreateBodySetup();
+	ProxyMesh->GetBodySetup()->CollisionTraceFlag = ECollisionTraceFlag::CTF_UseComplexAsSimple;
+
+	return ProxyMesh;
+}
@@ -75,6 +75,19 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Geometry Collection Processing")
 	static UTexture2D* CreateInitialBoneLocationsToTexture(UGeometryCollection* GeometryCollectionIn);
 
+	/**
+	 * Merges the GeometrySource static meshes of a geometry collection, each at its LocalTransform, into one proxy mesh with a
+	 * material slot per unique material. Collision is the (simplified) render geometry.
+	 * 
+	 * @brief Generates a single merged proxy mesh for the source geometry of the provided Geometry Collection.
+	 * @note This DOES NOT create or save any assets in the editor.
+	 * @param GeometryCollectionIn the geometry collection we want to process.
+	 * @param TriangleBudget triangles the merged mesh is simplified down to, 0 keeps every source triangle.
+	 * @return the merged proxy mesh, null if the geometry collection has no static mesh sources.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Geometry Collection Processing")
+	static UStaticMesh* MergeSourceGeometryToProxyMesh(UGeometryCollection* GeometryCollectionIn, int32 TriangleBudget = 0);
+
 private:
 
 	static TArray<FVector3f> GenerateGeometryCollectionFragmentCentroids(const FGeometryCollection* GeometryCollection);